@@ -0,0 +1,129 @@
+#include "batch_export.h"
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QtConcurrent>
+#include "mainwindow.h"
+#include "tabbedplotwidget.h"
+#include "plotwidget.h"
+#include "PlotJuggler/fmt/format.h"
+
+namespace
+{
+struct ExportJob
+{
+  PlotWidget* plot;
+  QPicture picture;
+  QString file_name;
+  QSize size;
+  bool success = false;
+};
+
+QString FileNameFromTitle(QString title)
+{
+  return title.replace(QRegularExpression("[^\\w\\-]"), "_");
+}
+
+// Qwt doesn't need a widget to be visible to render it, but the plots of the hidden
+// tabs don't have a size until the tab is shown once.
+void CollectJobs(const BatchExportConfig& config, std::vector<ExportJob>& jobs)
+{
+  const QDir directory(config.directory);
+  int tab_number = 1;
+
+  for (const auto& it : TabbedPlotWidget::instances())
+  {
+    QTabWidget* tab_widget = it.second->tabWidget();
+    tab_widget->window()->resize(config.window_size);
+
+    for (int i = 0; i < tab_widget->count(); i++, tab_number++)
+    {
+      tab_widget->setCurrentIndex(i);
+      QApplication::processEvents();
+
+      auto docker = static_cast<PlotDocker*>(tab_widget->widget(i));
+      docker->replot();
+
+      for (int index = 0; index < docker->plotCount(); index++)
+      {
+        PlotWidget* plot = docker->plotAt(index);
+        if (plot->isEmpty())
+        {
+          continue;
+        }
+        ExportJob job;
+        job.plot = plot;
+        job.size = plot->widget()->size();
+        if (job.size.isEmpty())
+        {
+          job.size = QSize(1200, 900);
+        }
+        const QString name = QString("%1_%2_%3.%4")
+                                 .arg(tab_number, 2, 10, QLatin1Char('0'))
+                                 .arg(FileNameFromTitle(docker->name()))
+                                 .arg(index + 1, 2, 10, QLatin1Char('0'))
+                                 .arg(config.format);
+        job.file_name = directory.filePath(name);
+        jobs.push_back(job);
+      }
+    }
+  }
+}
+}  // namespace
+
+int RunBatchExport(MainWindow& window, const BatchExportConfig& config,
+                   std::ostream& out)
+{
+  if (!QDir().mkpath(config.directory))
+  {
+    out << fmt::format("Can't create the directory [{}]\n",
+                       config.directory.toStdString());
+    return -1;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+
+  // the plots are rendered by QwtPlotRenderer, not by the canvas
+  PlotWidgetBase::setBackgroundRendering(false);
+  window.show();
+
+  std::vector<ExportJob> jobs;
+  CollectJobs(config, jobs);
+  const double layout_time = timer.nsecsElapsed() * 1e-9;
+
+  // the widgets are painted by the GUI thread; only the encoding of the files is
+  // done in parallel
+  for (auto& job : jobs)
+  {
+    job.picture = job.plot->renderToPicture(job.size);
+  }
+  const double render_time = timer.nsecsElapsed() * 1e-9 - layout_time;
+
+  QtConcurrent::blockingMap(jobs, [](ExportJob& job) {
+    job.success = PlotWidget::savePicture(job.picture, job.file_name, job.size);
+    job.picture = QPicture();
+  });
+
+  int failures = 0;
+  for (const auto& job : jobs)
+  {
+    if (job.success)
+    {
+      out << fmt::format("{} ({}x{})\n", job.file_name.toStdString(),
+                         job.size.width(), job.size.height());
+    }
+    else
+    {
+      out << fmt::format("FAILED: {}\n", job.file_name.toStdString());
+      failures++;
+    }
+  }
+  out << fmt::format("Exported {} plots in {:.3f} s "
+                     "(layout {:.3f} s, rendering {:.3f} s, {} threads)\n",
+                     jobs.size() - failures, timer.nsecsElapsed() * 1e-9, layout_time,
+                     render_time, QThreadPool::globalInstance()->maxThreadCount());
+
+  return (failures == 0) ? 0 : -1;
+}
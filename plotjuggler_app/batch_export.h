@@ -0,0 +1,33 @@
+#ifndef BATCH_EXPORT_H
+#define BATCH_EXPORT_H
+
+#include <ostream>
+#include <QSize>
+#include <QString>
+
+class MainWindow;
+
+struct BatchExportConfig
+{
+  // the directory is created, if necessary
+  QString directory;
+  // "png", "svg" or "pdf"
+  QString format = "png";
+  // size of the windows used to lay out the plots; each plot is exported with the
+  // size it has in its tab.
+  QSize window_size = QSize(1920, 1080);
+};
+
+/**
+ * Export every plot of every tab into a file, without showing the window (the
+ * "offscreen" platform must be used).
+ *
+ * The window is laid out in the GUI thread, then the plots are rendered in parallel.
+ * The files written are listed in the stream.
+ *
+ * @return 0 on success
+ */
+int RunBatchExport(MainWindow& window, const BatchExportConfig& config,
+                   std::ostream& out);
+
+#endif  // BATCH_EXPORT_H
@@ -20,9 +20,23 @@
 #include <QTreeWidget>
 
 #include "PlotJuggler/svg_util.h"
+#include "PlotJuggler/memory_budget.h"
 
 //-------------------------------------------------
 
+static QString FormatBytes(size_t bytes)
+{
+  if (bytes < 1024)
+  {
+    return QString("%1 bytes").arg(bytes);
+  }
+  if (bytes < 1024 * 1024)
+  {
+    return QString("%1 KB").arg(double(bytes) / 1024.0, 0, 'f', 1);
+  }
+  return QString("%1 MB").arg(double(bytes) / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
 CurveListPanel::CurveListPanel(PlotDataMapRef& mapped_plot_data,
                                const TransformsMap& mapped_math_plots, QWidget* parent)
   : QWidget(parent)
@@ -380,6 +394,44 @@ void CurveListPanel::refreshValues()
     tree_view->treeVisitor(DisplayValue);
     // tree_view->setViewResizeEnabled(true);
   }
+  //------------------------------------
+  auto usage = MemoryBudget::memoryUsage(_plot_data);
+  ui->labelNumberDisplayed->setToolTip(
+      tr("Memory used by the data: %1\n  numeric: %2\n  strings: %3")
+          .arg(FormatBytes(usage.total()))
+          .arg(FormatBytes(usage.numeric))
+          .arg(FormatBytes(usage.strings)));
+}
+
+QString CurveListPanel::memoryUsageText(const std::string& name) const
+{
+  auto Text = [](const auto& series) {
+    return tr("%1 samples, %2").arg(series.size()).arg(FormatBytes(series.memoryUsage()));
+  };
+
+  auto num_it = _plot_data.numeric.find(name);
+  if (num_it != _plot_data.numeric.end())
+  {
+    const PlotData& series = num_it->second;
+    QString text = Text(series);
+    if (!series.archive().empty())
+    {
+      text += tr("\n%1 older samples compressed").arg(series.archive().size());
+    }
+    if (series.compactedResolution() > 0)
+    {
+      text += tr("\nhistory before %1 summarized every %2 s")
+                  .arg(series.compactedUntil(), 0, 'f', 1)
+                  .arg(series.compactedResolution());
+    }
+    return text;
+  }
+  auto str_it = _plot_data.strings.find(name);
+  if (str_it != _plot_data.strings.end())
+  {
+    return Text(str_it->second);
+  }
+  return {};
 }
 
 QString StringifyArray(QString str)
@@ -53,6 +53,9 @@ public:
 
   void updateColors();
 
+  /// Number of samples and memory used by a series, shown in its tooltip.
+  QString memoryUsageText(const std::string& name) const;
+
 private slots:
 
   void on_lineEditFilter_textChanged(const QString& search_string);
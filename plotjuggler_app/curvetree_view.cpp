@@ -272,10 +272,19 @@ bool CurveTreeView::eventFilter(QObject* object, QEvent* event)
     auto* item = itemAt(mouse_event->pos());
     if (item)
     {
-      auto tooltip = item->data(0, CustomRoles::ToolTip);
-      if (tooltip.isValid())
+      QString tooltip = item->data(0, CustomRoles::ToolTip).toString();
+      const QString name = item->data(0, CustomRoles::Name).toString();
+      if (!name.isEmpty() && !item->data(0, CustomRoles::IsGroupName).toBool())
       {
-        QToolTip::showText(mapToGlobal(mouse_event->pos()), tooltip.toString());
+        const QString memory = _parent_panel->memoryUsageText(name.toStdString());
+        if (!memory.isEmpty())
+        {
+          tooltip += tooltip.isEmpty() ? memory : ("\n" + memory);
+        }
+      }
+      if (!tooltip.isEmpty())
+      {
+        QToolTip::showText(mapToGlobal(mouse_event->pos()), tooltip);
       }
       else
       {
@@ -7,8 +7,12 @@
 #include "qwt_symbol.h"
 #include "qwt_graphic.h"
 #include "qwt_text.h"
+#include "qwt_widget_overlay.h"
 #include <qevent.h>
 #include <QFontDatabase>
+#include <QFontMetrics>
+#include <QPainter>
+#include <algorithm>
 
 struct compareX
 {
@@ -18,18 +22,120 @@ struct compareX
   }
 };
 
-CurveTracker::CurveTracker(QwtPlot* plot) : QObject(plot), _plot(plot), _param(VALUE)
+class CurveTracker::Overlay : public QwtWidgetOverlay
+{
+public:
+  Overlay(CurveTracker* tracker, QwtPlot* plot)
+    : QwtWidgetOverlay(plot->canvas()), _tracker(tracker), _plot(plot)
+  {
+    setMaskMode(QwtWidgetOverlay::NoMask);
+    _font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    _font.setPointSize(9);
+  }
+
+protected:
+  void drawOverlay(QPainter* painter) const override;
+
+private:
+  CurveTracker* _tracker;
+  QwtPlot* _plot;
+  QFont _font;
+  // indexes of the points in the canvas, reused by each call
+  mutable std::vector<size_t> _visible;
+};
+
+void CurveTracker::Overlay::drawOverlay(QPainter* painter) const
 {
-  _line_marker = new QwtPlotMarker();
+  if (!_tracker->_visible)
+  {
+    return;
+  }
+  const QwtScaleMap x_map = _plot->canvasMap(QwtPlot::xBottom);
+  const QwtScaleMap y_map = _plot->canvasMap(QwtPlot::yLeft);
+  const QRectF canvas_rect = rect();
+
+  const double line_x = x_map.transform(_tracker->_prev_trackerpoint.x());
+  painter->setPen(QPen(Qt::red));
+  painter->drawLine(QLineF(line_x, canvas_rect.top(), line_x, canvas_rect.bottom()));
+
+  const auto& points = _tracker->_points;
+  double min_y = std::numeric_limits<double>::max();
+  double max_y = -min_y;
+  _visible.clear();
+
+  painter->setRenderHint(QPainter::Antialiasing, true);
+  painter->setPen(QPen(Qt::black));
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    if (!points[i].valid)
+    {
+      continue;
+    }
+    const QPointF pos(x_map.transform(points[i].point.x()),
+                      y_map.transform(points[i].point.y()));
+    if (!canvas_rect.contains(pos))
+    {
+      continue;
+    }
+    painter->setBrush(points[i].color);
+    painter->drawEllipse(pos, 2.5, 2.5);
+
+    min_y = std::min(min_y, pos.y());
+    max_y = std::max(max_y, pos.y());
+    _visible.push_back(i);
+  }
+
+  const Parameter param = _tracker->_param;
+  if (_visible.empty() || param == LINE_ONLY)
+  {
+    return;
+  }
+
+  // the highest value first
+  std::sort(_visible.begin(), _visible.end(), [&points](size_t a, size_t b) {
+    return points[a].point.y() > points[b].point.y();
+  });
+
+  QFontMetrics fm(_font);
+  int text_width = 0;
+  for (size_t index : _visible)
+  {
+    text_width = std::max(text_width, fm.width(points[index].text));
+  }
+  const int margin = 2;
+  const double box_width = text_width + 2 * margin;
+  const double box_height = fm.height() * int(_visible.size()) + 2 * margin;
 
-  _line_marker->setLinePen(QPen(Qt::red));
-  _line_marker->setLineStyle(QwtPlotMarker::VLine);
-  _line_marker->setValue(0, 0);
-  _line_marker->attach(plot);
+  const double text_X_offset = canvas_rect.width() * 0.02;
+  double box_x = line_x + text_X_offset;
+  if (box_x + box_width > canvas_rect.right())
+  {
+    box_x = line_x - text_X_offset - box_width;
+  }
+  const double box_y = 0.5 * (min_y + max_y) - 0.5 * box_height;
+  const QRectF box(box_x, box_y, box_width, box_height);
 
-  _text_marker = new QwtPlotMarker();
-  _text_marker->attach(plot);
+  QColor background_color = _plot->palette().background().color();
+  background_color.setAlpha(180);
+  painter->setPen(Qt::NoPen);
+  painter->setBrush(background_color);
+  painter->drawRect(box);
+
+  painter->setFont(_font);
+  const int flags =
+      (param == VALUE ? Qt::AlignHCenter : Qt::AlignLeft) | Qt::AlignVCenter;
+  QRectF line_rect(box.left() + margin, box.top() + margin, text_width, fm.height());
+  for (size_t index : _visible)
+  {
+    painter->setPen(points[index].color);
+    painter->drawText(line_rect, flags, points[index].text);
+    line_rect.translate(0, fm.height());
+  }
+}
 
+CurveTracker::CurveTracker(QwtPlot* plot) : QObject(plot), _plot(plot), _param(VALUE)
+{
+  _overlay = new Overlay(this, plot);
   _visible = true;
 }
 
@@ -56,13 +162,7 @@ void CurveTracker::setParameter(Parameter par)
 void CurveTracker::setEnabled(bool enable)
 {
   _visible = enable;
-  _line_marker->setVisible(enable);
-  _text_marker->setVisible(enable);
-
-  for (int i = 0; i < _marker.size(); i++)
-  {
-    _marker[i]->setVisible(enable);
-  }
+  _overlay->updateOverlay();
 }
 
 bool CurveTracker::isEnabled() const
@@ -74,53 +174,18 @@ void CurveTracker::setPosition(const QPointF& position)
 {
   const QwtPlotItemList curves = _plot->itemList(QwtPlotItem::Rtti_PlotCurve);
 
-  _line_marker->setValue(position);
-
-  QRectF rect;
-  rect.setBottom(_plot->canvasMap(QwtPlot::yLeft).s1());
-  rect.setTop(_plot->canvasMap(QwtPlot::yLeft).s2());
-  rect.setLeft(_plot->canvasMap(QwtPlot::xBottom).s1());
-  rect.setRight(_plot->canvasMap(QwtPlot::xBottom).s2());
-
-  double min_Y = std::numeric_limits<double>::max();
-  double max_Y = -min_Y;
-  int visible_points = 0;
-
-  while (_marker.size() > curves.size())
-  {
-    _marker.back()->detach();
-    _marker.pop_back();
-  }
-
-  for (int i = _marker.size(); i < curves.size(); i++)
-  {
-    _marker.push_back(new QwtPlotMarker);
-    _marker[i]->attach(_plot);
-  }
-
-  double text_X_offset = 0;
-
-  std::multimap<double, QString> text_lines;
+  _points.resize(curves.size());
 
   for (int i = 0; i < curves.size(); i++)
   {
     QwtPlotCurve* curve = static_cast<QwtPlotCurve*>(curves[i]);
-    _marker[i]->setVisible(curve->isVisible());
+    CurvePoint& entry = _points[i];
+    entry.valid = false;
 
     if (curve->isVisible() == false)
     {
       continue;
     }
-    QColor color = curve->pen().color();
-
-    text_X_offset = rect.width() * 0.02;
-
-    if (!_marker[i]->symbol() || _marker[i]->symbol()->brush().color() != color)
-    {
-      QwtSymbol* sym =
-          new QwtSymbol(QwtSymbol::Ellipse, color, QPen(Qt::black), QSize(5, 5));
-      _marker[i]->setSymbol(sym);
-    }
 
     const QLineF line = curveLineAt(curve, position.x());
 
@@ -129,101 +194,38 @@ void CurveTracker::setPosition(const QPointF& position)
       continue;
     }
 
-    QPointF point;
     double middle_X = (line.p1().x() + line.p2().x()) / 2.0;
-
-    if (position.x() < middle_X)
-      point = line.p1();
-    else
-      point = line.p2();
-
-    _marker[i]->setValue(point);
-
-    if (rect.contains(point) && _visible)
+    entry.point = (position.x() < middle_X) ? line.p1() : line.p2();
+    entry.color = curve->pen().color();
+    entry.valid = true;
+
+    const double val = entry.point.y();
+    // the title of a curve can be changed by the user (e.g. with an alias)
+    const QString title = (_param == VALUE) ? QString() : curve->title().text();
+    if (_param == LINE_ONLY ||
+        (entry.curve == curve && entry.text_param == _param && entry.text_value == val &&
+         entry.text_title == title && !entry.text.isEmpty()))
     {
-      min_Y = std::min(min_Y, point.y());
-      max_Y = std::max(max_Y, point.y());
-
-      visible_points++;
-      double val = point.y();
-
-      QString line;
-
-      if (_param == VALUE)
-      {
-        line = QString("<font color=%1>%2</font>").arg(color.name()).arg(val);
-      }
-      else if (_param == VALUE_NAME)
-      {
-        QString value = QString::number(val, 'f', 3);
-        int whitespaces = 8 - value.length();
-        while (whitespaces-- > 0)
-          value.prepend("&nbsp;");
-
-        line = QString("<font color=%1>%2 : %3</font>")
-                   .arg(color.name())
-                   .arg(value)
-                   .arg(curve->title().text());
-      }
-
-      text_lines.insert(std::make_pair(val, line));
-      _marker[i]->setVisible(true);
+      continue;
     }
-    else
+    entry.curve = curve;
+    entry.text_param = _param;
+    entry.text_value = val;
+    entry.text_title = title;
+
+    if (_param == VALUE)
     {
-      _marker[i]->setVisible(false);
+      entry.text = QString::number(val);
     }
-    _marker[i]->setValue(point);
-  }
-
-  QwtText mark_text;
-
-  QString text_marker_info;
-
-  int count = 0;
-  for (auto it = text_lines.rbegin(); it != text_lines.rend(); it++)
-  {
-    text_marker_info += it->second;
-    if (count++ < text_lines.size() - 1)
+    else
     {
-      text_marker_info += "<br>";
+      QString value = QString::number(val, 'f', 3);
+      entry.text = QString("%1 : %2").arg(value, 8).arg(title);
     }
   }
-  mark_text.setBorderPen(QColor(Qt::transparent));
-
-  QColor background_color = _plot->palette().background().color();
-  background_color.setAlpha(180);
-  mark_text.setBackgroundBrush(background_color);
-  mark_text.setText(text_marker_info);
-
-  QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
-  font.setPointSize(9);
-
-  mark_text.setFont(font);
-  mark_text.setRenderFlags(_param == VALUE ? Qt::AlignCenter : Qt::AlignLeft);
-
-  _text_marker->setLabel(mark_text);
-  _text_marker->setLabelAlignment(Qt::AlignRight);
-
-  _text_marker->setXValue(position.x() + text_X_offset);
-
-  if (visible_points > 0)
-  {
-    _text_marker->setYValue(0.5 * (max_Y + min_Y));
-  }
-
-  double canvas_ratio = rect.width() / double(_plot->width());
-  double text_width = mark_text.textSize().width() * canvas_ratio;
-  bool exceed_right = (_text_marker->boundingRect().right() + text_width) > rect.right();
-
-  if (exceed_right)
-  {
-    _text_marker->setXValue(position.x() - text_X_offset - text_width);
-  }
-
-  _text_marker->setVisible(visible_points > 0 && _visible && _param != LINE_ONLY);
 
   _prev_trackerpoint = position;
+  _overlay->updateOverlay();
 }
 
 QLineF CurveTracker::curveLineAt(const QwtPlotCurve* curve, double x) const
@@ -1,14 +1,22 @@
 #ifndef CUSTOMTRACKER_H
 #define CUSTOMTRACKER_H
 
+#include <QColor>
 #include <QEvent>
 #include <QPointF>
+#include <vector>
 #include "qwt_plot_picker.h"
 #include "qwt_picker_machine.h"
 #include "qwt_plot_marker.h"
 
 class QwtPlotCurve;
 
+/**
+ * @brief Vertical line, with the value of each curve at that time.
+ *
+ * It is drawn in an overlay of the canvas: moving it does not require a
+ * replot; the curves are restored from the backing store of the canvas.
+ */
 class CurveTracker : public QObject
 {
   Q_OBJECT
@@ -48,10 +56,25 @@ private:
 
   QPoint invTransform(QPointF);
 
+  class Overlay;
+
+  // value of a curve at the position of the tracker
+  struct CurvePoint
+  {
+    const QwtPlotCurve* curve = nullptr;
+    QPointF point;
+    QColor color;
+    bool valid = false;
+    // the text is built again only when the value (or the title) changes
+    QString text;
+    double text_value = 0;
+    QString text_title;
+    Parameter text_param = LINE_ONLY;
+  };
+
   QPointF _prev_trackerpoint;
-  std::vector<QwtPlotMarker*> _marker;
-  QwtPlotMarker* _line_marker;
-  QwtPlotMarker* _text_marker;
+  std::vector<CurvePoint> _points;
+  Overlay* _overlay;
   QwtPlot* _plot;
   Parameter _param;
   bool _visible;
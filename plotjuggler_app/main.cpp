@@ -22,6 +22,8 @@
 
 #include "nlohmann_parsers.h"
 #include "new_release_dialog.h"
+#include "streaming_benchmark.h"
+#include "batch_export.h"
 
 static QString VERSION_STRING =
     QString("%1.%2.%3").arg(PJ_MAJOR_VERSION).arg(PJ_MINOR_VERSION).arg(PJ_PATCH_VERSION);
@@ -133,6 +135,17 @@ std::pair<int, char**> MergeArguments(int argc, char* argv[])
 int main(int argc, char* argv[])
 {
   auto arg = MergeArguments(argc, argv);
+
+  // the benchmark and the export don't need a display
+  for (int i = 1; i < arg.first; i++)
+  {
+    const QByteArray option(arg.second[i]);
+    const bool headless = (option == "--benchmark" || option == "--export");
+    if (headless && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    {
+      qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+  }
   QApplication app(arg.first, arg.second);
 
   QCoreApplication::setOrganizationName("PlotJuggler");
@@ -248,8 +261,79 @@ int main(int argc, char* argv[])
                                     "file_name (no extension)");
   parser.addOption(start_streamer);
 
+  QCommandLineOption benchmark_option(QStringList() << "benchmark",
+                                      "Run the streaming benchmark without GUI for the "
+                                      "given number of seconds and print the results",
+                                      "seconds");
+  parser.addOption(benchmark_option);
+
+  QCommandLineOption stress_series_option(QStringList() << "stress_series",
+                                          "Number of series generated by the benchmark "
+                                          "(default: 100)",
+                                          "count");
+  parser.addOption(stress_series_option);
+
+  QCommandLineOption stress_rate_option(QStringList() << "stress_rate",
+                                        "Frequency of the series generated by the "
+                                        "benchmark (default: 100)",
+                                        "Hz");
+  parser.addOption(stress_rate_option);
+
+  QCommandLineOption stress_payload_option(QStringList() << "stress_payload",
+                                           "Type of data generated by the benchmark: "
+                                           "numeric, string or json (default: numeric)",
+                                           "type");
+  parser.addOption(stress_payload_option);
+
+  QCommandLineOption export_option(QStringList() << "export",
+                                   "Load the layout and the data files, save every plot "
+                                   "into the given directory and quit, without showing "
+                                   "the window. The data files replace the ones saved "
+                                   "in the layout",
+                                   "directory_path");
+  parser.addOption(export_option);
+
+  QCommandLineOption export_format_option(QStringList() << "export_format",
+                                          "Format of the exported plots: png, svg or pdf "
+                                          "(default: png)",
+                                          "format");
+  parser.addOption(export_format_option);
+
+  QCommandLineOption export_size_option(QStringList() << "export_size",
+                                        "Size of the window used to lay out the "
+                                        "exported plots (default: 1920x1080)",
+                                        "WIDTHxHEIGHT");
+  parser.addOption(export_size_option);
+
   parser.process(*qApp);
 
+  if (parser.isSet(benchmark_option))
+  {
+    StreamingBenchmarkConfig config;
+    config.duration = std::max(1.0, parser.value(benchmark_option).toDouble());
+    if (parser.isSet(stress_series_option))
+    {
+      config.source.series_count = parser.value(stress_series_option).toUInt();
+    }
+    if (parser.isSet(stress_rate_option))
+    {
+      config.source.rate = parser.value(stress_rate_option).toDouble();
+    }
+    if (parser.isSet(stress_payload_option) &&
+        !StressGenerator::parsePayload(parser.value(stress_payload_option),
+                                       config.source.payload))
+    {
+      std::cerr << "Option [ --stress_payload ] must be numeric, string or json."
+                << std::endl;
+      return -1;
+    }
+    if (parser.isSet(buffersize_option))
+    {
+      config.buffer_size = std::max(10, parser.value(buffersize_option).toInt());
+    }
+    return RunStreamingBenchmark(config, std::cout);
+  }
+
   if (parser.isSet(publish_option) && !parser.isSet(layout_option))
   {
     std::cerr << "Option [ -p / --publish ] is invalid unless [ -l / --layout ] is used "
@@ -271,6 +355,40 @@ int main(int argc, char* argv[])
     settings.setValue("Preferences::use_opengl", false);
   }
 
+  if (parser.isSet(export_option))
+  {
+    if (!parser.isSet(layout_option))
+    {
+      std::cerr << "Option [ --export ] requires [ -l / --layout ]." << std::endl;
+      return -1;
+    }
+    BatchExportConfig config;
+    config.directory = parser.value(export_option);
+    if (parser.isSet(export_format_option))
+    {
+      config.format = parser.value(export_format_option).toLower();
+      if (config.format != "png" && config.format != "svg" && config.format != "pdf")
+      {
+        std::cerr << "Option [ --export_format ] must be png, svg or pdf." << std::endl;
+        return -1;
+      }
+    }
+    if (parser.isSet(export_size_option))
+    {
+      const QStringList size = parser.value(export_size_option).split('x');
+      config.window_size = (size.size() == 2) ?
+                               QSize(size[0].toInt(), size[1].toInt()) :
+                               QSize();
+      if (config.window_size.isEmpty())
+      {
+        std::cerr << "Option [ --export_size ] must be WIDTHxHEIGHT." << std::endl;
+        return -1;
+      }
+    }
+    MainWindow window(parser);
+    return RunBatchExport(window, config, std::cout);
+  }
+
   if (parser.isSet(skin_path_option))
   {
     QDir path(parser.value(skin_path_option));
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <functional>
 #include <stdio.h>
 #include <numeric>
@@ -26,6 +27,7 @@
 #include <QStringListModel>
 #include <QStringRef>
 #include <QThread>
+#include <QtConcurrent>
 #include <QTextStream>
 #include <QWindow>
 #include <QHeaderView>
@@ -38,7 +40,7 @@
 #include "PlotJuggler/plotdata.h"
 #include "qwt_plot_canvas.h"
 #include "transforms/function_editor.h"
-#include "transforms/lua_custom_function.h"
+#include "transforms/custom_function.h"
 #include "utils.h"
 #include "PlotJuggler/svg_util.h"
 #include "stylesheet.h"
@@ -58,6 +60,42 @@
 #include <ament_index_cpp/get_package_share_directory.hpp>
 #endif
 
+namespace
+{
+// maximum number of undo and redo steps
+const size_t MAX_UNDO_STATES = 100;
+
+QDomDocument SavePlotState(PlotWidget* plot)
+{
+  QDomDocument doc;
+  doc.appendChild(plot->xmlSaveState(doc));
+  return doc;
+}
+
+// a file being loaded by MainWindow::loadDataFileBatch
+struct FileLoadTask
+{
+  FileLoadInfo info;
+  DataLoaderPtr loader;
+  PlotDataMapRef data;
+  bool loaded = false;
+  QString error;
+};
+
+// may be executed in a worker thread: the errors are reported later
+void ReadDataFile(FileLoadTask* task)
+{
+  try
+  {
+    task->loaded = task->loader->readDataFromFile(&task->info, task->data);
+  }
+  catch (std::exception& ex)
+  {
+    task->error = ex.what();
+  }
+}
+}  // namespace
+
 MainWindow::MainWindow(const QCommandLineParser& commandline_parser, QWidget* parent)
   : QMainWindow(parent)
   , ui(new Ui::MainWindow)
@@ -80,6 +118,7 @@ MainWindow::MainWindow(const QCommandLineParser& commandline_parser, QWidget* pa
 
   _test_option = commandline_parser.isSet("test");
   _autostart_publishers = commandline_parser.isSet("publish");
+  _headless = commandline_parser.isSet("export");
 
   if (commandline_parser.isSet("enabled_plugins"))
   {
@@ -238,9 +277,10 @@ MainWindow::MainWindow(const QCommandLineParser& commandline_parser, QWidget* pa
   // save initial state
   onUndoableChange();
 
-  _replot_timer = new QTimer(this);
-  connect(_replot_timer, &QTimer::timeout, this,
+  _replot_scheduler = new ReplotScheduler(this);
+  connect(_replot_scheduler, &ReplotScheduler::frameRequested, this,
           [this]() { updateDataAndReplot(false); });
+  loadStreamingPreferences();
 
   _publish_timer = new QTimer(this);
   _publish_timer->setInterval(20);
@@ -257,14 +297,23 @@ MainWindow::MainWindow(const QCommandLineParser& commandline_parser, QWidget* pa
   }
 
   bool file_loaded = false;
-  if (commandline_parser.isSet("datafile"))
+  if (_headless)
   {
-    QStringList datafiles = commandline_parser.values("datafile");
-    file_loaded = loadDataFromFiles(datafiles);
+    // the configuration of the DataLoaders is taken from the layout, to avoid dialogs
+    loadLayoutFromFile(commandline_parser.value("layout"),
+                       commandline_parser.values("datafile"));
   }
-  if (commandline_parser.isSet("layout"))
+  else
   {
-    loadLayoutFromFile(commandline_parser.value("layout"));
+    if (commandline_parser.isSet("datafile"))
+    {
+      QStringList datafiles = commandline_parser.values("datafile");
+      file_loaded = loadDataFromFiles(datafiles);
+    }
+    if (commandline_parser.isSet("layout"))
+    {
+      loadLayoutFromFile(commandline_parser.value("layout"));
+    }
   }
 
   restoreGeometry(settings.value("MainWindow.geometry").toByteArray());
@@ -382,20 +431,172 @@ void MainWindow::onUndoableChange()
   if (_disable_undo_logging)
     return;
 
+  // a change notified by a PlotWidget doesn't need to save the entire layout
+  auto plot = qobject_cast<PlotWidget*>(sender());
+  if (plot && !_undo_states.empty())
+  {
+    recordPlotChanges({ plot });
+  }
+  else
+  {
+    recordLayoutChange();
+  }
+}
+
+void MainWindow::recordPlotChanges(const std::vector<PlotWidget*>& plots)
+{
+  if (_disable_undo_logging)
+    return;
+
+  UndoEntry entry;
+  for (PlotWidget* plot : plots)
+  {
+    PlotChange change;
+    auto prev_it = _plot_states.find(plot);
+    if (prev_it == _plot_states.end() || !findPlotPath(plot, change.path))
+    {
+      // plot not known yet: the structure of the layout changed too
+      recordLayoutChange();
+      return;
+    }
+    change.before = prev_it->second;
+    change.after = SavePlotState(plot);
+    prev_it->second = change.after;
+
+    if (change.before.toString() != change.after.toString())
+    {
+      entry.plots.push_back(std::move(change));
+    }
+  }
+  if (!entry.plots.empty())
+  {
+    pushUndoEntry(std::move(entry));
+  }
+}
+
+void MainWindow::recordLayoutChange()
+{
+  UndoEntry entry;
+  entry.layout = xmlSaveState();
+  refreshPlotStates();
+  pushUndoEntry(std::move(entry));
+}
+
+void MainWindow::pushUndoEntry(UndoEntry&& entry)
+{
   int elapsed_ms = _undo_timer.restart();
+  _redo_states.clear();
 
-  // overwrite the previous
-  if (elapsed_ms < 100)
+  // merge with the previous one (for instance, while dragging or zooming)
+  if (elapsed_ms < 100 && !_undo_states.empty())
   {
-    if (_undo_states.empty() == false)
-      _undo_states.pop_back();
+    UndoEntry& prev = _undo_states.back();
+    if (prev.isLayout() && entry.isLayout())
+    {
+      prev.layout = entry.layout;
+      return;
+    }
+    if (!prev.isLayout() && !entry.isLayout())
+    {
+      for (auto& change : entry.plots)
+      {
+        auto same_plot = [&](const PlotChange& other) {
+          return other.path.tabbed_widget == change.path.tabbed_widget &&
+                 other.path.tab == change.path.tab && other.path.index == change.path.index;
+        };
+        auto it = std::find_if(prev.plots.begin(), prev.plots.end(), same_plot);
+        if (it != prev.plots.end())
+        {
+          it->after = change.after;
+        }
+        else
+        {
+          prev.plots.push_back(std::move(change));
+        }
+      }
+      return;
+    }
   }
 
-  while (_undo_states.size() >= 100)
+  while (_undo_states.size() >= MAX_UNDO_STATES)
     _undo_states.pop_front();
-  _undo_states.push_back(xmlSaveState());
-  _redo_states.clear();
-  // qDebug() << "undo " << _undo_states.size();
+  _undo_states.push_back(std::move(entry));
+}
+
+void MainWindow::applyPlotChanges(const std::vector<PlotChange>& changes, bool undo)
+{
+  auto apply = [&](const PlotChange& change) {
+    PlotWidget* plot = plotFromPath(change.path);
+    if (!plot)
+    {
+      return;
+    }
+    const QDomDocument& state = undo ? change.before : change.after;
+    QDomElement plot_elem = state.documentElement();
+    plot->xmlLoadState(plot_elem);
+    plot->replot();
+    _plot_states[plot] = state;
+  };
+
+  if (undo)
+  {
+    std::for_each(changes.rbegin(), changes.rend(), apply);
+  }
+  else
+  {
+    std::for_each(changes.begin(), changes.end(), apply);
+  }
+}
+
+void MainWindow::refreshPlotStates()
+{
+  _plot_states.clear();
+  forEachWidget([this](PlotWidget* plot) { _plot_states[plot] = SavePlotState(plot); });
+}
+
+bool MainWindow::findPlotPath(PlotWidget* plot, PlotPath& path) const
+{
+  for (const auto& [name, tabbed_widget] : TabbedPlotWidget::instances())
+  {
+    const QTabWidget* tabs = tabbed_widget->tabWidget();
+    for (int t = 0; t < tabs->count(); t++)
+    {
+      auto docker = dynamic_cast<PlotDocker*>(tabs->widget(t));
+      if (!docker)
+      {
+        continue;
+      }
+      for (int index = 0; index < docker->plotCount(); index++)
+      {
+        if (docker->plotAt(index) == plot)
+        {
+          path = { name, t, index };
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+PlotWidget* MainWindow::plotFromPath(const PlotPath& path) const
+{
+  TabbedPlotWidget* tabbed_widget = TabbedPlotWidget::instance(path.tabbed_widget);
+  if (!tabbed_widget || path.tab >= tabbed_widget->tabWidget()->count())
+  {
+    return nullptr;
+  }
+  auto docker = dynamic_cast<PlotDocker*>(tabbed_widget->tabWidget()->widget(path.tab));
+  if (!docker)
+  {
+    return nullptr;
+  }
+  docker->materialize();
+  if (path.index >= docker->plotCount())
+  {
+    return nullptr;
+  }
+  return docker->plotAt(path.index);
 }
 
 void MainWindow::onRedoInvoked()
@@ -403,15 +604,22 @@ void MainWindow::onRedoInvoked()
   _disable_undo_logging = true;
   if (_redo_states.size() > 0)
   {
-    QDomDocument state_document = _redo_states.back();
-    while (_undo_states.size() >= 100)
-      _undo_states.pop_front();
-    _undo_states.push_back(state_document);
+    UndoEntry entry = std::move(_redo_states.back());
     _redo_states.pop_back();
 
-    xmlLoadState(state_document);
+    if (entry.isLayout())
+    {
+      xmlLoadState(entry.layout);
+    }
+    else
+    {
+      applyPlotChanges(entry.plots, false);
+    }
+
+    while (_undo_states.size() >= MAX_UNDO_STATES)
+      _undo_states.pop_front();
+    _undo_states.push_back(std::move(entry));
   }
-  // qDebug() << "undo " << _undo_states.size();
   _disable_undo_logging = false;
 }
 
@@ -420,16 +628,45 @@ void MainWindow::onUndoInvoked()
   _disable_undo_logging = true;
   if (_undo_states.size() > 1)
   {
-    QDomDocument state_document = _undo_states.back();
-    while (_redo_states.size() >= 100)
-      _redo_states.pop_front();
-    _redo_states.push_back(state_document);
+    UndoEntry entry = std::move(_undo_states.back());
     _undo_states.pop_back();
-    state_document = _undo_states.back();
 
-    xmlLoadState(state_document);
+    bool undone = true;
+    if (!entry.isLayout())
+    {
+      applyPlotChanges(entry.plots, true);
+    }
+    else
+    {
+      // rebuild the previous layout, then replay the plot changes recorded after it
+      auto layout_it = std::find_if(_undo_states.rbegin(), _undo_states.rend(),
+                                    [](const UndoEntry& e) { return e.isLayout(); });
+      if (layout_it != _undo_states.rend())
+      {
+        xmlLoadState(layout_it->layout);
+        for (auto it = layout_it.base(); it != _undo_states.end(); it++)
+        {
+          applyPlotChanges(it->plots, false);
+        }
+      }
+      else
+      {
+        // the oldest layout was discarded: this change can't be undone
+        undone = false;
+      }
+    }
+
+    if (undone)
+    {
+      while (_redo_states.size() >= MAX_UNDO_STATES)
+        _redo_states.pop_front();
+      _redo_states.push_back(std::move(entry));
+    }
+    else
+    {
+      _undo_states.push_back(std::move(entry));
+    }
   }
-  // qDebug() << "undo " << _undo_states.size();
   _disable_undo_logging = false;
 }
 
@@ -469,7 +706,8 @@ void MainWindow::onTrackerTimeUpdated(double absolute_time, bool do_replot)
 
   forEachWidget([&](PlotWidget* plot) {
     plot->setTrackerPosition(_tracker_time);
-    if (do_replot)
+    // the tracker is drawn in an overlay; only XY plots move the markers of the curves
+    if (do_replot && plot->isXYPlot())
     {
       plot->replot();
     }
@@ -510,11 +748,17 @@ void MainWindow::initializeActions()
 
 void MainWindow::loadAllPlugins(QStringList command_line_plugin_folders)
 {
+  QElapsedTimer timer;
+  timer.start();
+
   QSettings settings;
   QStringList loaded;
   QStringList plugin_folders;
   QStringList builtin_folders;
 
+  // if missing or outdated, all the plugins are loaded to create a new one
+  _plugin_manifest.load();
+
   plugin_folders += command_line_plugin_folders;
   plugin_folders +=
       settings.value("Preferences::plugin_folders", QStringList()).toStringList();
@@ -570,6 +814,13 @@ void MainWindow::loadAllPlugins(QStringList command_line_plugin_folders)
   }
 
   settings.setValue("Preferences::builtin_plugin_folders", builtin_folders);
+
+  if (!_plugin_manifest.save())
+  {
+    qDebug() << "Can't write the plugin manifest: " << PluginManifest::defaultCacheFile();
+  }
+  qDebug() << "Plugins initialized in " << timer.elapsed() << " ms ("
+           << _lazy_plugins.size() << " will be loaded on first use)";
 }
 
 QStringList MainWindow::initializePlugins(QString directory_name)
@@ -579,6 +830,10 @@ QStringList MainWindow::initializePlugins(QString directory_name)
 
   qDebug() << "Loading compatible plugins from directory: " << directory_name;
   int loaded_count = 0;
+  int cached_count = 0;
+
+  QElapsedTimer timer;
+  timer.start();
 
   QDir pluginsDir(directory_name);
 
@@ -596,245 +851,414 @@ QStringList MainWindow::initializePlugins(QString directory_name)
       continue;
     }
 
-    QPluginLoader pluginLoader(pluginsDir.absoluteFilePath(filename), this);
+    // the library is opened only if the file is not in the manifest (or it changed)
+    const QFileInfo absolute_fileinfo(pluginsDir.absoluteFilePath(filename));
+    PluginManifest::Entry entry;
+    QObject* plugin = nullptr;
 
-    QObject* plugin = pluginLoader.instance();
-    if (plugin)
+    if (auto cached_entry = _plugin_manifest.find(absolute_fileinfo))
     {
-      auto class_name = pluginLoader.metaData().value("className").toString();
-      loaded_out.push_back(class_name);
+      entry = *cached_entry;
+      cached_count++;
+    }
+    else
+    {
+      entry = PluginManifest::createEntry(absolute_fileinfo);
+      plugin = instantiatePlugin(entry);
+      // a plugin that failed to load (missing dependencies?) will be tried again
+      if (plugin || entry.iid.isEmpty())
+      {
+        _plugin_manifest.insert(entry);
+      }
+    }
 
-      DataLoader* loader = qobject_cast<DataLoader*>(plugin);
-      StatePublisher* publisher = qobject_cast<StatePublisher*>(plugin);
-      DataStreamer* streamer = qobject_cast<DataStreamer*>(plugin);
-      MessageParserCreator* message_parser = qobject_cast<MessageParserCreator*>(plugin);
-      ToolboxPlugin* toolbox = qobject_cast<ToolboxPlugin*>(plugin);
+    if (!entry.isPlugin())
+    {
+      continue;
+    }
+    loaded_out.push_back(entry.class_name);
 
-      QString plugin_name;
-      QString plugin_type;
-      bool is_debug_plugin = dynamic_cast<PlotJugglerPlugin*>(plugin)->isDebugPlugin();
+    const QString plugin_name = entry.name;
+    QString message = QString("%1 is a %2 plugin").arg(filename).arg(entry.type);
 
-      if (loader)
-      {
-        plugin_name = loader->name();
-        plugin_type = "DataLoader";
-      }
-      else if (publisher)
-      {
-        plugin_name = publisher->name();
-        plugin_type = "StatePublisher";
-      }
-      else if (streamer)
-      {
-        plugin_name = streamer->name();
-        plugin_type = "DataStreamer";
-      }
-      else if (message_parser)
-      {
-        plugin_name = message_parser->name();
-        plugin_type = "MessageParser";
-      }
-      else if (toolbox)
-      {
-        plugin_name = toolbox->name();
-        plugin_type = "MessageParser";
-      }
+    if ((_enabled_plugins.size() > 0) &&
+        (_enabled_plugins.contains(fileinfo.baseName()) == false))
+    {
+      qDebug() << message << " ...skipping, because it is not explicitly enabled";
+      continue;
+    }
+    if ((_disabled_plugins.size() > 0) &&
+        (_disabled_plugins.contains(fileinfo.baseName()) == true))
+    {
+      qDebug() << message << " ...skipping, because it is explicitly disabled";
+      continue;
+    }
+    if (!_test_option && entry.is_debug)
+    {
+      qDebug() << message << " ...disabled, unless option -t is used";
+      continue;
+    }
+    if (loaded_plugins.find(plugin_name) != loaded_plugins.end())
+    {
+      qDebug() << message << " ...skipping, because already loaded";
+      continue;
+    }
 
-      QString message = QString("%1 is a %2 plugin").arg(filename).arg(plugin_type);
+    loaded_plugins.insert(plugin_name);
+    loaded_count++;
 
-      if ((_enabled_plugins.size() > 0) &&
-          (_enabled_plugins.contains(fileinfo.baseName()) == false))
-      {
-        qDebug() << message << " ...skipping, because it is not explicitly enabled";
-        continue;
-      }
-      if ((_disabled_plugins.size() > 0) &&
-          (_disabled_plugins.contains(fileinfo.baseName()) == true))
-      {
-        qDebug() << message << " ...skipping, because it is explicitly disabled";
-        continue;
-      }
-      if (!_test_option && is_debug_plugin)
-      {
-        qDebug() << message << " ...disabled, unless option -t is used";
-        continue;
-      }
-      if (loaded_plugins.find(plugin_name) != loaded_plugins.end())
+    // DataLoaders, DataStreamers and Toolboxes are loaded when they are used for the
+    // first time; what the GUI needs to know about them is in the manifest
+    const bool lazy = entry.type == "DataLoader" || entry.type == "DataStreamer" ||
+                      entry.type == "Toolbox";
+
+    if (!plugin && !lazy)
+    {
+      plugin = instantiatePlugin(entry);
+      if (!plugin)
       {
-        qDebug() << message << " ...skipping, because already loaded";
         continue;
       }
-
+    }
+    if (plugin)
+    {
       qDebug() << message;
+    }
+    else
+    {
+      qDebug() << message << " ...will be loaded on first use";
+    }
 
-      loaded_plugins.insert(plugin_name);
-      loaded_count++;
+    if (entry.type == "DataLoader")
+    {
+      _data_loader_extensions[plugin_name] = entry.file_extensions;
+    }
+    else if (entry.type == "DataStreamer" && _default_streamer == fileinfo.baseName())
+    {
+      _default_streamer = plugin_name;
+    }
+    else if (entry.type == "Toolbox")
+    {
+      addToolboxAction(plugin_name);
+    }
 
-      if (loader)
+    if (plugin)
+    {
+      registerPlugin(plugin, plugin_name);
+    }
+    else
+    {
+      _lazy_plugins[plugin_name] = entry;
+    }
+  }
+
+  std::vector<QString> streamer_names;
+  for (const auto& it : _data_streamer)
+  {
+    streamer_names.push_back(it.first);
+  }
+  for (const auto& it : _lazy_plugins)
+  {
+    if (it.second.type == "DataStreamer")
+    {
+      streamer_names.push_back(it.first);
+    }
+  }
+
+  if (!streamer_names.empty())
+  {
+    QSignalBlocker block(ui->comboStreaming);
+    ui->comboStreaming->setEnabled(true);
+    ui->buttonStreamingStart->setEnabled(true);
+
+    for (const auto& name : streamer_names)
+    {
+      if (ui->comboStreaming->findText(name) == -1)
       {
-        _data_loader.insert(std::make_pair(plugin_name, loader));
+        ui->comboStreaming->addItem(name);
       }
-      else if (publisher)
-      {
-        publisher->setDataMap(&_mapped_plot_data);
-        _state_publisher.insert(std::make_pair(plugin_name, publisher));
+    }
 
-        ui->layoutPublishers->setColumnStretch(0, 1.0);
+    // remember the previous one
+    QSettings settings;
+    QString streaming_name =
+        settings
+            .value("MainWindow.previousStreamingPlugin", ui->comboStreaming->itemText(0))
+            .toString();
 
-        int row = _state_publisher.size() - 1;
-        auto label = new QLabel(plugin_name, ui->framePublishers);
-        ui->layoutPublishers->addWidget(label, row, 0);
+    if (ui->comboStreaming->findText(streaming_name) == -1)
+    {
+      streaming_name = ui->comboStreaming->itemText(0);
+    }
 
-        auto start_checkbox = new QCheckBox(ui->framePublishers);
-        ui->layoutPublishers->addWidget(start_checkbox, row, 1);
-        start_checkbox->setFocusPolicy(Qt::FocusPolicy::NoFocus);
+    ui->comboStreaming->setCurrentText(streaming_name);
 
-        connect(start_checkbox, &QCheckBox::toggled, this,
-                [=](bool enable) { publisher->setEnabled(enable); });
+    // only the selected streamer is loaded
+    auto streamer = dataStreamer(streaming_name);
+    bool contains_options = streamer && !streamer->availableActions().empty();
+    ui->buttonStreamingOptions->setEnabled(contains_options);
+  }
+  qDebug() << "Number of plugins loaded: " << loaded_count << " (" << cached_count
+           << " files found in the manifest) in " << timer.elapsed() << " ms\n";
+  return loaded_out;
+}
 
-        connect(publisher, &StatePublisher::closed, start_checkbox,
-                [=]() { start_checkbox->setChecked(false); });
+QObject* MainWindow::instantiatePlugin(PluginManifest::Entry& entry)
+{
+  QElapsedTimer timer;
+  timer.start();
 
-        if (publisher->availableActions().empty())
-        {
-          QFrame* empty = new QFrame(ui->framePublishers);
-          empty->setFixedSize({ 22, 22 });
-          ui->layoutPublishers->addWidget(empty, row, 2);
-        }
-        else
-        {
-          auto options_button = new QPushButton(ui->framePublishers);
-          options_button->setFlat(true);
-          options_button->setFixedSize({ 24, 24 });
-          ui->layoutPublishers->addWidget(options_button, row, 2);
+  const QString filename = QFileInfo(entry.file_path).fileName();
+  QPluginLoader pluginLoader(entry.file_path, this);
+
+  // the metadata is read without loading the library
+  entry.iid = pluginLoader.metaData().value("IID").toString();
+  entry.class_name = pluginLoader.metaData().value("className").toString();
+
+  QObject* plugin = pluginLoader.instance();
+  if (!plugin)
+  {
+    if (pluginLoader.errorString().contains("is not an ELF object") == false)
+    {
+      qDebug() << filename << ": " << pluginLoader.errorString();
+    }
+    return nullptr;
+  }
+
+  auto pj_plugin = dynamic_cast<PlotJugglerPlugin*>(plugin);
+  if (!pj_plugin)
+  {
+    return nullptr;
+  }
+  entry.is_debug = pj_plugin->isDebugPlugin();
+
+  if (auto loader = qobject_cast<DataLoader*>(plugin))
+  {
+    entry.name = loader->name();
+    entry.type = "DataLoader";
+    entry.file_extensions.clear();
+    for (const char* extension : loader->compatibleFileExtensions())
+    {
+      entry.file_extensions.push_back(extension);
+    }
+  }
+  else if (auto publisher = qobject_cast<StatePublisher*>(plugin))
+  {
+    entry.name = publisher->name();
+    entry.type = "StatePublisher";
+  }
+  else if (auto streamer = qobject_cast<DataStreamer*>(plugin))
+  {
+    entry.name = streamer->name();
+    entry.type = "DataStreamer";
+  }
+  else if (auto message_parser = qobject_cast<MessageParserCreator*>(plugin))
+  {
+    entry.name = message_parser->name();
+    entry.type = "MessageParser";
+  }
+  else if (auto toolbox = qobject_cast<ToolboxPlugin*>(plugin))
+  {
+    entry.name = toolbox->name();
+    entry.type = "Toolbox";
+  }
+  else
+  {
+    return nullptr;
+  }
+
+  qDebug() << filename << "loaded in" << timer.elapsed() << "ms";
+  return plugin;
+}
+
+void MainWindow::registerPlugin(QObject* plugin, const QString& plugin_name)
+{
+  DataLoader* loader = qobject_cast<DataLoader*>(plugin);
+  StatePublisher* publisher = qobject_cast<StatePublisher*>(plugin);
+  DataStreamer* streamer = qobject_cast<DataStreamer*>(plugin);
+  MessageParserCreator* message_parser = qobject_cast<MessageParserCreator*>(plugin);
+  ToolboxPlugin* toolbox = qobject_cast<ToolboxPlugin*>(plugin);
+
+  if (loader)
+  {
+    _data_loader.insert(std::make_pair(plugin_name, loader));
+  }
+  else if (publisher)
+  {
+    publisher->setDataMap(&_mapped_plot_data);
+    _state_publisher.insert(std::make_pair(plugin_name, publisher));
+
+    ui->layoutPublishers->setColumnStretch(0, 1.0);
+
+    int row = _state_publisher.size() - 1;
+    auto label = new QLabel(plugin_name, ui->framePublishers);
+    ui->layoutPublishers->addWidget(label, row, 0);
+
+    auto start_checkbox = new QCheckBox(ui->framePublishers);
+    ui->layoutPublishers->addWidget(start_checkbox, row, 1);
+    start_checkbox->setFocusPolicy(Qt::FocusPolicy::NoFocus);
+
+    connect(start_checkbox, &QCheckBox::toggled, this,
+            [=](bool enable) { publisher->setEnabled(enable); });
+
+    connect(publisher, &StatePublisher::closed, start_checkbox,
+            [=]() { start_checkbox->setChecked(false); });
+
+    if (publisher->availableActions().empty())
+    {
+      QFrame* empty = new QFrame(ui->framePublishers);
+      empty->setFixedSize({ 22, 22 });
+      ui->layoutPublishers->addWidget(empty, row, 2);
+    }
+    else
+    {
+      auto options_button = new QPushButton(ui->framePublishers);
+      options_button->setFlat(true);
+      options_button->setFixedSize({ 24, 24 });
+      ui->layoutPublishers->addWidget(options_button, row, 2);
 
-          options_button->setIcon(LoadSvg(":/resources/svg/settings_cog.svg", "light"));
-          options_button->setIconSize({ 16, 16 });
+      options_button->setIcon(LoadSvg(":/resources/svg/settings_cog.svg", "light"));
+      options_button->setIconSize({ 16, 16 });
 
-          auto optionsMenu = [=]() {
-            PopupMenu* menu = new PopupMenu(options_button, this);
-            for (auto action : publisher->availableActions())
-            {
-              menu->addAction(action);
-            }
-            menu->exec();
-          };
-
-          connect(options_button, &QPushButton::clicked, options_button, optionsMenu);
-
-          connect(this, &MainWindow::stylesheetChanged, options_button,
-                  [=](QString style) {
-                    options_button->setIcon(
-                        LoadSvg(":/resources/svg/settings_cog.svg", style));
-                  });
-        }
-      }
-      else if (message_parser)
-      {
-        _message_parser_factory->insert(std::make_pair(plugin_name, message_parser));
-      }
-      else if (streamer)
-      {
-        if (_default_streamer == fileinfo.baseName())
+      auto optionsMenu = [=]() {
+        PopupMenu* menu = new PopupMenu(options_button, this);
+        for (auto action : publisher->availableActions())
         {
-          _default_streamer = plugin_name;
+          menu->addAction(action);
         }
-        _data_streamer.insert(std::make_pair(plugin_name, streamer));
+        menu->exec();
+      };
 
-        streamer->setAvailableParsers(_message_parser_factory);
+      connect(options_button, &QPushButton::clicked, options_button, optionsMenu);
 
-        connect(streamer, &DataStreamer::closed, this,
-                [this]() { this->stopStreamingPlugin(); });
+      connect(this, &MainWindow::stylesheetChanged, options_button, [=](QString style) {
+        options_button->setIcon(LoadSvg(":/resources/svg/settings_cog.svg", style));
+      });
+    }
+  }
+  else if (message_parser)
+  {
+    _message_parser_factory->insert(std::make_pair(plugin_name, message_parser));
+  }
+  else if (streamer)
+  {
+    _data_streamer.insert(std::make_pair(plugin_name, streamer));
 
-        connect(streamer, &DataStreamer::clearBuffers, this,
-                &MainWindow::on_actionClearBuffer_triggered);
+    streamer->setAvailableParsers(_message_parser_factory);
 
-        connect(streamer, &DataStreamer::dataReceived, _animated_streaming_movie,
-                [this]() {
-                  _animated_streaming_movie->start();
-                  _animated_streaming_timer->start(500);
-                });
+    connect(streamer, &DataStreamer::closed, this,
+            [this]() { this->stopStreamingPlugin(); });
 
-        connect(streamer, &DataStreamer::removeGroup, this,
-                &MainWindow::on_deleteSerieFromGroup);
+    connect(streamer, &DataStreamer::clearBuffers, this,
+            &MainWindow::on_actionClearBuffer_triggered);
 
-        connect(streamer, &DataStreamer::dataReceived, this, [this]() {
-          if (isStreamingActive() && !_replot_timer->isActive())
-          {
-            _replot_timer->setSingleShot(true);
-            _replot_timer->start(40);
-          }
-        });
+    connect(streamer, &DataStreamer::dataReceived, _animated_streaming_movie, [this]() {
+      _animated_streaming_movie->start();
+      _animated_streaming_timer->start(500);
+    });
 
-        connect(streamer, &DataStreamer::notificationsChanged, this,
-                &MainWindow::on_streamingNotificationsChanged);
-      }
-      else if (toolbox)
+    connect(streamer, &DataStreamer::removeGroup, this,
+            &MainWindow::on_deleteSerieFromGroup);
+
+    connect(streamer, &DataStreamer::dataReceived, this, [this]() {
+      if (isStreamingActive())
       {
-        toolbox->init(_mapped_plot_data, _transform_functions);
+        _replot_scheduler->requestFrame();
+      }
+    });
 
-        auto action = ui->menuTools->addAction(toolbox->name());
+    connect(streamer, &DataStreamer::notificationsChanged, this,
+            &MainWindow::on_streamingNotificationsChanged);
+  }
+  else if (toolbox)
+  {
+    toolbox->init(_mapped_plot_data, _transform_functions);
 
-        int new_index = ui->widgetStack->count();
-        auto provided = toolbox->providedWidget();
-        auto widget = provided.first;
-        ui->widgetStack->addWidget(widget);
+    auto widget = toolbox->providedWidget().first;
+    ui->widgetStack->addWidget(widget);
 
-        connect(action, &QAction::triggered, toolbox, &ToolboxPlugin::onShowWidget);
+    connect(toolbox, &ToolboxPlugin::closed, this,
+            [=]() { ui->widgetStack->setCurrentIndex(0); });
 
-        connect(action, &QAction::triggered, this,
-                [=]() { ui->widgetStack->setCurrentIndex(new_index); });
+    connect(toolbox, &ToolboxPlugin::plotCreated, this,
+            [=](std::string name) { _curvelist_widget->addCurve(name); });
 
-        connect(toolbox, &ToolboxPlugin::closed, this,
-                [=]() { ui->widgetStack->setCurrentIndex(0); });
+    _toolboxes.insert(std::make_pair(plugin_name, toolbox));
+  }
+}
 
-        connect(toolbox, &ToolboxPlugin::plotCreated, this,
-                [=](std::string name) { _curvelist_widget->addCurve(name); });
-      }
-    }
-    else
-    {
-      if (pluginLoader.errorString().contains("is not an ELF object") == false)
-      {
-        qDebug() << filename << ": " << pluginLoader.errorString();
-      }
-    }
+QObject* MainWindow::loadLazyPlugin(const QString& plugin_name)
+{
+  auto it = _lazy_plugins.find(plugin_name);
+  if (it == _lazy_plugins.end())
+  {
+    return nullptr;
   }
-  if (!_data_streamer.empty())
+  PluginManifest::Entry entry = it->second;
+  _lazy_plugins.erase(it);
+
+  QObject* plugin = instantiatePlugin(entry);
+  if (!plugin)
   {
-    QSignalBlocker block(ui->comboStreaming);
-    ui->comboStreaming->setEnabled(true);
-    ui->buttonStreamingStart->setEnabled(true);
+    QMessageBox::warning(this, tr("Error loading plugin"),
+                         tr("The plugin %1 can not be loaded from:\n%2")
+                             .arg(plugin_name)
+                             .arg(entry.file_path));
+    return nullptr;
+  }
+  registerPlugin(plugin, plugin_name);
 
-    for (const auto& it : _data_streamer)
-    {
-      if (ui->comboStreaming->findText(it.first) == -1)
-      {
-        ui->comboStreaming->addItem(it.first);
-      }
-    }
+  // state read from a layout, before the plugin was loaded
+  auto state_it = _lazy_plugins_state.find(plugin_name);
+  if (state_it != _lazy_plugins_state.end())
+  {
+    dynamic_cast<PlotJugglerPlugin*>(plugin)->xmlLoadState(state_it->second);
+    _lazy_plugins_state.erase(state_it);
+  }
+  return plugin;
+}
 
-    // remember the previous one
-    QSettings settings;
-    QString streaming_name =
-        settings
-            .value("MainWindow.previousStreamingPlugin", ui->comboStreaming->itemText(0))
-            .toString();
+void MainWindow::addToolboxAction(const QString& plugin_name)
+{
+  auto action = ui->menuTools->addAction(plugin_name);
 
-    auto streamer_it = _data_streamer.find(streaming_name);
-    if (streamer_it == _data_streamer.end())
+  connect(action, &QAction::triggered, this, [=]() {
+    if (auto toolbox = toolboxPlugin(plugin_name))
     {
-      streamer_it = _data_streamer.begin();
-      streaming_name = streamer_it->first;
+      toolbox->onShowWidget();
+      ui->widgetStack->setCurrentWidget(toolbox->providedWidget().first);
     }
+  });
+}
 
-    ui->comboStreaming->setCurrentText(streaming_name);
+DataLoaderPtr MainWindow::dataLoader(const QString& plugin_name)
+{
+  auto it = _data_loader.find(plugin_name);
+  if (it == _data_loader.end() && loadLazyPlugin(plugin_name))
+  {
+    it = _data_loader.find(plugin_name);
+  }
+  return it == _data_loader.end() ? nullptr : it->second;
+}
 
-    bool contains_options = !streamer_it->second->availableActions().empty();
-    ui->buttonStreamingOptions->setEnabled(contains_options);
+DataStreamerPtr MainWindow::dataStreamer(const QString& plugin_name)
+{
+  auto it = _data_streamer.find(plugin_name);
+  if (it == _data_streamer.end() && loadLazyPlugin(plugin_name))
+  {
+    it = _data_streamer.find(plugin_name);
   }
-  qDebug() << "Number of plugins loaded: " << loaded_count << "\n";
-  return loaded_out;
+  return it == _data_streamer.end() ? nullptr : it->second;
+}
+
+ToolboxPluginPtr MainWindow::toolboxPlugin(const QString& plugin_name)
+{
+  auto it = _toolboxes.find(plugin_name);
+  if (it == _toolboxes.end() && loadLazyPlugin(plugin_name))
+  {
+    it = _toolboxes.find(plugin_name);
+  }
+  return it == _toolboxes.end() ? nullptr : it->second;
 }
 
 void MainWindow::buildDummyData()
@@ -882,6 +1306,8 @@ void MainWindow::onPlotAdded(PlotWidget* plot)
 {
   connect(plot, &PlotWidget::undoableChange, this, &MainWindow::onUndoableChange);
 
+  connect(plot, &QObject::destroyed, this, [this, plot]() { _plot_states.erase(plot); });
+
   connect(plot, &PlotWidget::trackerMoved, this, &MainWindow::onTrackerMovedFromWidget);
 
   connect(this, &MainWindow::dataSourceRemoved, plot, &PlotWidget::onDataSourceRemoved);
@@ -889,8 +1315,15 @@ void MainWindow::onPlotAdded(PlotWidget* plot)
   connect(plot, &PlotWidget::curveListChanged, this, [this]() {
     updateTimeOffset();
     updateTimeSlider();
+    // a new derived series may have pinned a compressed history, that is restored
+    // by updateDataAndReplot()
+    _replot_scheduler->requestFrame();
   });
 
+  // same for the transforms applied to the curves
+  connect(plot, &PlotWidget::undoableChange, this,
+          [this]() { _replot_scheduler->requestFrame(); });
+
   connect(&_time_offset, SIGNAL(valueChanged(double)), plot,
           SLOT(on_changeTimeOffset(double)));
 
@@ -920,9 +1353,11 @@ void MainWindow::onPlotAdded(PlotWidget* plot)
 
 void MainWindow::onPlotZoomChanged(PlotWidget* modified_plot, QRectF new_range)
 {
+  std::vector<PlotWidget*> modified_plots = { modified_plot };
+
   if (ui->pushButtonLink->isChecked())
   {
-    auto visitor = [=](PlotWidget* plot) {
+    auto visitor = [&](PlotWidget* plot) {
       if (plot != modified_plot && !plot->isEmpty() && !plot->isXYPlot() &&
           plot->isZoomLinkEnabled())
       {
@@ -932,12 +1367,20 @@ void MainWindow::onPlotZoomChanged(PlotWidget* modified_plot, QRectF new_range)
         plot->setZoomRectangle(bound_act, false);
         plot->on_zoomOutVertical_triggered(false);
         plot->replot();
+        modified_plots.push_back(plot);
       }
     };
     this->forEachWidget(visitor);
   }
 
-  onUndoableChange();
+  if (!_undo_states.empty())
+  {
+    recordPlotChanges(modified_plots);
+  }
+  else
+  {
+    onUndoableChange();
+  }
 }
 
 void MainWindow::onPlotTabAdded(PlotDocker* docker)
@@ -947,6 +1390,16 @@ void MainWindow::onPlotTabAdded(PlotDocker* docker)
   connect(this, &MainWindow::stylesheetChanged, docker,
           &PlotDocker::on_stylesheetChanged);
 
+  // the plots of a tab loaded from a layout may be created later (see
+  // PlotDocker::setDeferredState)
+  connect(docker, &PlotDocker::materialized, this, [this, docker]() {
+    for (int index = 0; index < docker->plotCount(); index++)
+    {
+      PlotWidget* plot = docker->plotAt(index);
+      _plot_states[plot] = SavePlotState(plot);
+    }
+  });
+
   // TODO  connect(matrix, &PlotMatrix::undoableChange, this,
   // &MainWindow::onUndoableChange);
 }
@@ -1097,6 +1550,8 @@ bool MainWindow::xmlLoadState(QDomDocument state_document)
   checkAllCurvesFromLayout(root);
   //-----------------------------------------------------
 
+  // nothing is painted until all the widgets of the layout are created
+  setUpdatesEnabled(false);
   for (QDomElement tw = root.firstChildElement("tabbed_widget"); tw.isNull() == false;
        tw = tw.nextSiblingElement("tabb"
                                   "ed_"
@@ -1106,6 +1561,7 @@ bool MainWindow::xmlLoadState(QDomDocument state_document)
     TabbedPlotWidget* tabwidget = TabbedPlotWidget::instance(tw.attribute("name"));
     tabwidget->xmlLoadState(tw);
   }
+  setUpdatesEnabled(true);
 
   QDomElement relative_time = root.firstChildElement("use_relative_time_offset");
   if (!relative_time.isNull())
@@ -1113,13 +1569,18 @@ bool MainWindow::xmlLoadState(QDomDocument state_document)
     bool remove_offset = (relative_time.attribute("enabled") == QString("1"));
     ui->pushButtonRemoveTimeOffset->setChecked(remove_offset);
   }
+  refreshPlotStates();
   return true;
 }
 
 void MainWindow::onDeleteMultipleCurves(const std::vector<std::string>& curve_names)
 {
+  PlotWidgetBase::waitForRendering();
   std::set<std::string> orphaned_transforms;
 
+  // the curves must be removed from the tabs that were not shown yet too
+  forEachDocker([](PlotDocker* docker) { docker->materialize(); });
+
   for (const auto& curve_name : curve_names)
   {
     emit dataSourceRemoved(curve_name);
@@ -1236,6 +1697,7 @@ void MainWindow::updateRecentLayoutMenu(QStringList new_filenames)
 
 void MainWindow::deleteAllData()
 {
+  PlotWidgetBase::waitForRendering();
   forEachWidget([](PlotWidget* plot) { plot->removeAllCurves(); });
 
   _mapped_plot_data.clear();
@@ -1273,6 +1735,7 @@ void MainWindow::deleteAllData()
 
 void MainWindow::importPlotDataMap(PlotDataMapRef& new_data, bool remove_old)
 {
+  PlotWidgetBase::waitForRendering();
   if (remove_old)
   {
     auto ClearOldSeries = [](auto& prev_plot_data, auto& new_plot_data) {
@@ -1333,6 +1796,7 @@ bool MainWindow::loadDataFromFiles(QStringList filenames)
 
   QStringList loaded_filenames;
 
+  std::vector<FileLoadInfo> infos;
   for (int i = 0; i < filenames.size(); i++)
   {
     FileLoadInfo info;
@@ -1341,7 +1805,14 @@ bool MainWindow::loadDataFromFiles(QStringList filenames)
     {
       info.prefix = QFileInfo(info.filename).baseName();
     }
-    auto added_names = loadDataFromFile(info);
+    infos.push_back(info);
+  }
+
+  auto added_names_per_file = loadDataFileBatch(infos);
+
+  for (int i = 0; i < filenames.size(); i++)
+  {
+    const auto& added_names = added_names_per_file[i];
     if (!added_names.empty())
     {
       loaded_filenames.push_back(filenames[i]);
@@ -1397,45 +1868,40 @@ bool MainWindow::loadDataFromFiles(QStringList filenames)
 
 std::unordered_set<std::string> MainWindow::loadDataFromFile(const FileLoadInfo& info)
 {
-  ui->pushButtonPlay->setChecked(false);
-
-  const QString extension = QFileInfo(info.filename).suffix().toLower();
+  return loadDataFileBatch({ info }).front();
+}
 
-  typedef std::map<QString, DataLoaderPtr>::iterator MapIterator;
+DataLoaderPtr MainWindow::selectDataLoader(const QString& filename)
+{
+  const QString extension = QFileInfo(filename).suffix().toLower();
 
-  std::vector<MapIterator> compatible_loaders;
+  std::vector<QString> compatible_loaders;
 
-  for (auto it = _data_loader.begin(); it != _data_loader.end(); ++it)
+  for (const auto& [name, extensions] : _data_loader_extensions)
   {
-    DataLoaderPtr data_loader = it->second;
-    std::vector<const char*> extensions = data_loader->compatibleFileExtensions();
-
-    for (auto& ext : extensions)
+    for (const auto& ext : extensions)
     {
-      if (extension == QString(ext).toLower())
+      if (extension == ext.toLower())
       {
-        compatible_loaders.push_back(it);
+        compatible_loaders.push_back(name);
         break;
       }
     }
   }
 
   DataLoaderPtr dataloader;
-  std::unordered_set<std::string> added_names;
 
   if (compatible_loaders.size() == 1)
   {
-    dataloader = compatible_loaders.front()->second;
+    dataloader = dataLoader(compatible_loaders.front());
   }
   else
   {
     static QString last_plugin_name_used;
 
     QStringList names;
-    for (auto& cl : compatible_loaders)
+    for (const auto& name : compatible_loaders)
     {
-      const auto& name = cl->first;
-
       if (name == last_plugin_name_used)
       {
         names.push_front(name);
@@ -1452,79 +1918,129 @@ std::unordered_set<std::string> MainWindow::loadDataFromFile(const FileLoadInfo&
                               tr("Select the loader to use:"), names, 0, false, &ok);
     if (ok && !plugin_name.isEmpty())
     {
-      dataloader = _data_loader[plugin_name];
+      dataloader = dataLoader(plugin_name);
       last_plugin_name_used = plugin_name;
     }
   }
 
-  if (dataloader)
+  if (!dataloader)
+  {
+    QMessageBox::warning(this, tr("Error"),
+                         tr("Cannot read files with extension %1.\n No plugin can handle "
+                            "that!\n")
+                             .arg(filename));
+    return {};
+  }
+
+  QFile file(filename);
+  if (!file.open(QFile::ReadOnly | QFile::Text))
+  {
+    QMessageBox::warning(
+        this, tr("Datafile"),
+        tr("Cannot read file %1:\n%2.").arg(filename).arg(file.errorString()));
+    return {};
+  }
+  file.close();
+
+  return dataloader;
+}
+
+std::vector<std::unordered_set<std::string>>
+MainWindow::loadDataFileBatch(const std::vector<FileLoadInfo>& infos)
+{
+  ui->pushButtonPlay->setChecked(false);
+
+  // each file is read into its own PlotDataMapRef. The prefix is applied when the
+  // series are created, therefore the maps can be merged without renaming.
+  std::vector<FileLoadTask> tasks(infos.size());
+  for (size_t i = 0; i < infos.size(); i++)
   {
-    QFile file(info.filename);
+    tasks[i].info = infos[i];
+    tasks[i].loader = selectDataLoader(infos[i].filename);
+    tasks[i].data.name_prefix = infos[i].prefix.toStdString();
+  }
+
+  // the files of the loaders that support it are read by the thread pool,
+  // while the others are read here, one at a time.
+  auto runsConcurrently = [&tasks](const FileLoadTask& task) {
+    return tasks.size() > 1 && task.loader && task.loader->supportsConcurrentLoading();
+  };
 
-    if (!file.open(QFile::ReadOnly | QFile::Text))
+  std::vector<QFuture<void>> futures;
+  for (auto& task : tasks)
+  {
+    if (runsConcurrently(task))
     {
-      QMessageBox::warning(
-          this, tr("Datafile"),
-          tr("Cannot read file %1:\n%2.").arg(info.filename).arg(file.errorString()));
-      return {};
+      futures.push_back(QtConcurrent::run(ReadDataFile, &task));
     }
-    file.close();
-
-    try
+  }
+  for (auto& task : tasks)
+  {
+    if (task.loader && !runsConcurrently(task))
+    {
+      ReadDataFile(&task);
+    }
+  }
+  if (!futures.empty())
+  {
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    for (auto& future : futures)
     {
-      PlotDataMapRef mapped_data;
-      FileLoadInfo new_info = info;
+      future.waitForFinished();
+    }
+    QApplication::restoreOverrideCursor();
+  }
 
-      if (dataloader->readDataFromFile(&new_info, mapped_data))
-      {
-        AddPrefixToPlotData(info.prefix.toStdString(), mapped_data.numeric);
-        AddPrefixToPlotData(info.prefix.toStdString(), mapped_data.strings);
+  // merge the results, in the same order of the files
+  std::vector<std::unordered_set<std::string>> added_names(tasks.size());
 
-        added_names = mapped_data.getAllNames();
-        importPlotDataMap(mapped_data, true);
+  for (size_t i = 0; i < tasks.size(); i++)
+  {
+    FileLoadTask& task = tasks[i];
+    if (!task.error.isEmpty())
+    {
+      QMessageBox::warning(this, tr("Exception from the plugin"),
+                           tr("The plugin [%1] thrown the following exception: \n\n %3\n")
+                               .arg(task.loader->name())
+                               .arg(task.error));
+      continue;
+    }
+    if (!task.loaded)
+    {
+      continue;
+    }
+    task.loader->finishLoading(task.info);
 
-        QDomElement plugin_elem = dataloader->xmlSaveState(new_info.plugin_config);
-        new_info.plugin_config.appendChild(plugin_elem);
+    added_names[i] = task.data.getAllNames();
+    importPlotDataMap(task.data, true);
 
-        bool duplicate = false;
+    FileLoadInfo& new_info = task.info;
+    QDomElement plugin_elem = task.loader->xmlSaveState(new_info.plugin_config);
+    new_info.plugin_config.appendChild(plugin_elem);
 
-        // substitute an old item of _loaded_datafiles or push_back another item.
-        for (auto& prev_loaded : _loaded_datafiles)
-        {
-          if (prev_loaded.filename == new_info.filename &&
-              prev_loaded.prefix == new_info.prefix)
-          {
-            prev_loaded = new_info;
-            duplicate = true;
-            break;
-          }
-        }
+    bool duplicate = false;
 
-        if (!duplicate)
-        {
-          _loaded_datafiles.push_back(new_info);
-        }
+    // substitute an old item of _loaded_datafiles or push_back another item.
+    for (auto& prev_loaded : _loaded_datafiles)
+    {
+      if (prev_loaded.filename == new_info.filename &&
+          prev_loaded.prefix == new_info.prefix)
+      {
+        prev_loaded = new_info;
+        duplicate = true;
+        break;
       }
     }
-    catch (std::exception& ex)
+
+    if (!duplicate)
     {
-      QMessageBox::warning(this, tr("Exception from the plugin"),
-                           tr("The plugin [%1] thrown the following exception: \n\n %3\n")
-                               .arg(dataloader->name())
-                               .arg(ex.what()));
-      return {};
+      _loaded_datafiles.push_back(new_info);
     }
   }
-  else
-  {
-    QMessageBox::warning(this, tr("Error"),
-                         tr("Cannot read files with extension %1.\n No plugin can handle "
-                            "that!\n")
-                             .arg(info.filename));
-  }
   _curvelist_widget->updateFilter();
 
   // clean the custom plot. Function updateDataAndReplot will update them
+  PlotWidgetBase::waitForRendering();
   for (auto& custom_it : _transform_functions)
   {
     auto it = _mapped_plot_data.numeric.find(custom_it.first);
@@ -1544,7 +2060,11 @@ std::unordered_set<std::string> MainWindow::loadDataFromFile(const FileLoadInfo&
 
 void MainWindow::on_buttonStreamingNotifications_clicked()
 {
-  auto streamer = _data_streamer.at(ui->comboStreaming->currentText());
+  auto streamer = dataStreamer(ui->comboStreaming->currentText());
+  if (!streamer)
+  {
+    return;
+  }
   QAction* notification_button_action = streamer->notificationAction().first;
   if (notification_button_action != nullptr)
   {
@@ -1634,21 +2154,16 @@ void MainWindow::startStreamingPlugin(QString streamer_name)
     _active_streamer_plugin = nullptr;
   }
 
-  if (_data_streamer.empty())
+  if (ui->comboStreaming->count() == 0)
   {
     qDebug() << "Error, no streamer loaded";
     return;
   }
 
-  auto it = _data_streamer.find(streamer_name);
-  if (it != _data_streamer.end())
-  {
-    _active_streamer_plugin = it->second;
-  }
-  else
+  _active_streamer_plugin = dataStreamer(streamer_name);
+  if (!_active_streamer_plugin)
   {
     qDebug() << "Error. The streamer " << streamer_name << " can't be loaded";
-    _active_streamer_plugin = nullptr;
     return;
   }
 
@@ -1794,6 +2309,11 @@ void MainWindow::loadPluginState(const QDomElement& root)
                               "<plugin ID=\"PluginName\" "));
     }
 
+    if (_lazy_plugins.count(plugin_name) != 0)
+    {
+      // applied if and when the plugin is loaded
+      _lazy_plugins_state[plugin_name] = plugin_elem;
+    }
     if (_data_loader.find(plugin_name) != _data_loader.end())
     {
       _data_loader[plugin_name]->xmlLoadState(plugin_elem);
@@ -1852,6 +2372,12 @@ QDomElement MainWindow::savePluginState(QDomDocument& doc)
     }
   }
 
+  // plugins not loaded yet: keep the state read from the previous layout
+  for (const auto& it : _lazy_plugins_state)
+  {
+    list_plugins.appendChild(doc.importNode(it.second, true));
+  }
+
   for (auto& it : _state_publisher)
   {
     const StatePublisherPtr state_publisher = it.second;
@@ -1869,61 +2395,27 @@ QDomElement MainWindow::savePluginState(QDomDocument& doc)
 
 std::tuple<double, double, int> MainWindow::calculateVisibleRangeX()
 {
-  // find min max time
-  double min_time = std::numeric_limits<double>::max();
-  double max_time = -std::numeric_limits<double>::max();
-  int max_steps = 0;
-
-  forEachWidget([&](const PlotWidget* widget) {
-    for (auto& it : widget->curveList())
-    {
-      const auto& curve_name = it.src_name;
-
-      auto plot_it = _mapped_plot_data.numeric.find(curve_name);
-      if (plot_it == _mapped_plot_data.numeric.end())
-      {
-        continue;  // FIXME?
-      }
-      const auto& data = plot_it->second;
-      if (data.size() >= 1)
-      {
-        const double t0 = data.front().x;
-        const double t1 = data.back().x;
-        min_time = std::min(min_time, t0);
-        max_time = std::max(max_time, t1);
-        max_steps = std::max(max_steps, (int)data.size());
-      }
-    }
-  });
+  // series displayed in at least one plot
+  auto& index = *_mapped_plot_data.time_range;
+  RangeOpt range = index.viewedRange();
+  size_t max_steps = index.viewedMaxSize();
 
   // needed if all the plots are empty
-  if (max_steps == 0 || max_time < min_time)
+  if (!range)
   {
-    for (const auto& it : _mapped_plot_data.numeric)
-    {
-      const PlotData& data = it.second;
-      if (data.size() >= 1)
-      {
-        const double t0 = data.front().x;
-        const double t1 = data.back().x;
-        min_time = std::min(min_time, t0);
-        max_time = std::max(max_time, t1);
-        max_steps = std::max(max_steps, (int)data.size());
-      }
-    }
+    range = index.range();
+    max_steps = index.maxSize();
   }
 
   // last opportunity. Everything else failed
-  if (max_steps == 0 || max_time < min_time)
+  if (!range || range->max < range->min)
   {
-    min_time = 0.0;
-    max_time = 1.0;
-    max_steps = 1;
+    return std::tuple<double, double, int>(0.0, 1.0, 1);
   }
-  return std::tuple<double, double, int>(min_time, max_time, max_steps);
+  return std::tuple<double, double, int>(range->min, range->max, int(max_steps));
 }
 
-bool MainWindow::loadLayoutFromFile(QString filename)
+bool MainWindow::loadLayoutFromFile(QString filename, const QStringList& datafiles)
 {
   QSettings settings;
 
@@ -1958,6 +2450,7 @@ bool MainWindow::loadLayoutFromFile(QString filename)
   QDomElement previously_loaded_datafile = root.firstChildElement("previouslyLoaded_"
                                                                   "Datafiles");
 
+  std::vector<FileLoadInfo> datafile_infos;
   QDomElement datafile_elem = previously_loaded_datafile.firstChildElement("fileInfo");
   while (!datafile_elem.isNull())
   {
@@ -1981,12 +2474,29 @@ bool MainWindow::loadLayoutFromFile(QString filename)
     auto plugin_elem = datafile_elem.firstChildElement("plugin");
     info.plugin_config.appendChild(info.plugin_config.importNode(plugin_elem, true));
 
-    loadDataFromFile(info);
+    datafile_infos.push_back(info);
     datafile_elem = datafile_elem.nextSiblingElement("fileInfo");
   }
+  for (int i = 0; i < datafiles.size(); i++)
+  {
+    if (i < int(datafile_infos.size()))
+    {
+      datafile_infos[i].filename = datafiles[i];
+    }
+    else
+    {
+      FileLoadInfo info;
+      info.filename = datafiles[i];
+      datafile_infos.push_back(info);
+    }
+  }
+  if (!datafile_infos.empty())
+  {
+    loadDataFileBatch(datafile_infos);
+  }
 
   QDomElement previous_streamer = root.firstChildElement("previouslyLoaded_Streamer");
-  if (!previous_streamer.isNull())
+  if (!previous_streamer.isNull() && !_headless)
   {
     QString streamer_name = previous_streamer.attribute("name");
 
@@ -2001,7 +2511,7 @@ bool MainWindow::loadLayoutFromFile(QString filename)
 
     if (msgBox.clickedButton() == yes)
     {
-      if (_data_streamer.count(streamer_name) != 0)
+      if (dataStreamer(streamer_name))
       {
         auto allCurves = readAllCurvesFromXML(root);
 
@@ -2083,7 +2593,7 @@ bool MainWindow::loadLayoutFromFile(QString filename)
     {
       try
       {
-        CustomPlotPtr new_custom_plot = std::make_shared<LuaCustomFunction>(snippet);
+        CustomPlotPtr new_custom_plot = CreateCustomFunction(snippet);
         new_custom_plot->xmlLoadState(custom_eq);
 
         new_custom_plot->calculateAndAdd(_mapped_plot_data);
@@ -2125,7 +2635,7 @@ bool MainWindow::loadLayoutFromFile(QString filename)
       }
     }
 
-    if (snippets_are_different)
+    if (snippets_are_different && !_headless)
     {
       QMessageBox msgBox(this);
       msgBox.setWindowTitle("Overwrite custom transforms?");
@@ -2154,7 +2664,8 @@ bool MainWindow::loadLayoutFromFile(QString filename)
 
   xmlLoadState(domDocument);
 
-  forEachWidget([&](PlotWidget* plot) { plot->zoomOut(false); });
+  // the hidden tabs will zoom out when they are shown for the first time
+  forEachDocker([](PlotDocker* docker) { docker->zoomOut(); });
 
   _undo_states.clear();
   _undo_states.push_back(domDocument);
@@ -2166,32 +2677,33 @@ void MainWindow::on_tabbedAreaDestroyed(QObject* object)
   this->setFocus();
 }
 
-void MainWindow::forEachWidget(
-    std::function<void(PlotWidget*, PlotDocker*, int)> operation)
+void MainWindow::forEachDocker(std::function<void(PlotDocker*)> operation)
 {
-  auto func = [&](QTabWidget* tabs) {
+  for (const auto& it : TabbedPlotWidget::instances())
+  {
+    QTabWidget* tabs = it.second->tabWidget();
     for (int t = 0; t < tabs->count(); t++)
     {
-      PlotDocker* matrix = dynamic_cast<PlotDocker*>(tabs->widget(t));
-      if (!matrix)
+      if (auto docker = dynamic_cast<PlotDocker*>(tabs->widget(t)))
       {
-        continue;
-      }
-
-      for (int index = 0; index < matrix->plotCount(); index++)
-      {
-        PlotWidget* plot = matrix->plotAt(index);
-        operation(plot, matrix, index);
+        operation(docker);
       }
     }
-  };
-
-  for (const auto& it : TabbedPlotWidget::instances())
-  {
-    func(it.second->tabWidget());
   }
 }
 
+void MainWindow::forEachWidget(
+    std::function<void(PlotWidget*, PlotDocker*, int)> operation)
+{
+  forEachDocker([&](PlotDocker* matrix) {
+    for (int index = 0; index < matrix->plotCount(); index++)
+    {
+      PlotWidget* plot = matrix->plotAt(index);
+      operation(plot, matrix, index);
+    }
+  });
+}
+
 void MainWindow::forEachWidget(std::function<void(PlotWidget*)> op)
 {
   forEachWidget([&](PlotWidget* plot, PlotDocker*, int) { op(plot); });
@@ -2225,9 +2737,15 @@ void MainWindow::updateTimeOffset()
 
 void MainWindow::updateDataAndReplot(bool replot_hidden_tabs)
 {
-  _replot_timer->stop();
+  _replot_scheduler->beginFrame();
+
+  // the plots are redrawn at each update while streaming: a background rendering
+  // would be cancelled before it is done.
+  PlotWidgetBase::setBackgroundRendering(!isStreamingActive());
+  PlotWidgetBase::waitForRendering();
 
   MoveDataRet move_ret;
+  bool compacted = false;
 
   if (_active_streamer_plugin)
   {
@@ -2247,7 +2765,21 @@ void MainWindow::updateDataAndReplot(bool replot_hidden_tabs)
     }
 
     _mapped_plot_data.setMaximumRangeX(ui->streamingSpinBox->value());
+    // compacted series must be copied again into the curves
+    compacted = move_ret.data_pushed && _memory_budget.enforce(_mapped_plot_data);
+  }
+
+  // The sources of the derived series are pinned, and never compressed. A series
+  // pinned by a derived series created after its compression gets its history back
+  // here: the derived series are then computed again from the first point.
+  for (auto& it : _mapped_plot_data.numeric)
+  {
+    if (it.second.historyPinned() && it.second.restoreHistory() > 0)
+    {
+      compacted = true;
+    }
   }
+  _replot_scheduler->endStage(ReplotScheduler::INGESTION);
 
   const bool is_streaming_active = isStreamingActive();
 
@@ -2269,8 +2801,16 @@ void MainWindow::updateDataAndReplot(bool replot_hidden_tabs)
     function->calculate();
   }
 
-  forEachWidget([](PlotWidget* plot)
-                { plot->updateCurves(false); });
+  // widgets whose curves did not receive new samples don't need to be repainted
+  std::unordered_set<PlotWidget*> updated_plots;
+  forEachWidget([&](PlotWidget* plot) {
+    if (plot->updateCurves(compacted))
+    {
+      updated_plots.insert(plot);
+    }
+  });
+
+  _replot_scheduler->endStage(ReplotScheduler::TRANSFORMS);
 
   //--------------------------------
   // trigger again the execution of this callback if steaming == true
@@ -2289,27 +2829,34 @@ void MainWindow::updateDataAndReplot(bool replot_hidden_tabs)
   //--------------------------------
   if (move_ret.data_pushed)
   {
-    for (const auto& it : TabbedPlotWidget::instances())
+    if (replot_hidden_tabs)
     {
-      if (replot_hidden_tabs)
-      {
-        QTabWidget* tabs = it.second->tabWidget();
-        for (int index = 0; index < tabs->count(); index++)
-        {
-          PlotDocker* matrix = static_cast<PlotDocker*>(tabs->widget(index));
-          matrix->zoomOut();
-        }
-      }
-      else
+      forEachDocker([](PlotDocker* docker) { docker->zoomOut(); });
+    }
+    else
+    {
+      // plots that can not be seen are zoomed out when they become visible
+      for (PlotWidget* plot : updated_plots)
       {
-        PlotDocker* matrix = it.second->currentTab();
-        matrix->zoomOut();  // includes replot
+        plot->zoomOutWhenVisible();  // includes replot
       }
     }
   }
   else
   {
-    forEachWidget([](PlotWidget* plot) { plot->replot(); });
+    forEachWidget([&](PlotWidget* plot) {
+      if (!is_streaming_active || updated_plots.count(plot))
+      {
+        plot->replot();
+      }
+    });
+  }
+  _replot_scheduler->endStage(ReplotScheduler::REPLOT);
+  _replot_scheduler->endFrame();
+
+  if (is_streaming_active)
+  {
+    ui->labelStreamingAnimation->setToolTip(_replot_scheduler->statistics());
   }
 }
 
@@ -2407,6 +2954,7 @@ void MainWindow::on_pushButtonPlay_toggled(bool checked)
 
 void MainWindow::on_actionClearBuffer_triggered()
 {
+  PlotWidgetBase::waitForRendering();
   for (auto& it : _mapped_plot_data.numeric)
   {
     it.second.clear();
@@ -2516,7 +3064,7 @@ void MainWindow::on_pushButtonTimeTracker_pressed()
 
 void MainWindow::closeEvent(QCloseEvent* event)
 {
-  _replot_timer->stop();
+  _replot_scheduler->stop();
   _publish_timer->stop();
 
   if (_active_streamer_plugin)
@@ -2557,7 +3105,7 @@ void MainWindow::onEditCustomPlot(const std::string& plot_name)
     return;
   }
   _function_editor->editExistingPlot(
-      std::dynamic_pointer_cast<LuaCustomFunction>(custom_it->second));
+      std::dynamic_pointer_cast<CustomFunction>(custom_it->second));
 }
 
 void MainWindow::onRefreshCustomPlot(const std::string& plot_name)
@@ -2570,7 +3118,7 @@ void MainWindow::onRefreshCustomPlot(const std::string& plot_name)
       qWarning("failed to find custom equation");
       return;
     }
-    CustomPlotPtr ce = std::dynamic_pointer_cast<LuaCustomFunction>(custom_it->second);
+    CustomPlotPtr ce = std::dynamic_pointer_cast<CustomFunction>(custom_it->second);
     ce->calculateAndAdd(_mapped_plot_data);
 
     onUpdateLeftTableValues();
@@ -2615,7 +3163,10 @@ void MainWindow::onPlaybackLoop()
 
   forEachWidget([&](PlotWidget* plot) {
     plot->setTrackerPosition(_tracker_time);
-    plot->replot();
+    if (plot->isXYPlot())
+    {
+      plot->replot();
+    }
   });
 }
 
@@ -2624,6 +3175,7 @@ void MainWindow::onCustomPlotCreated(CustomPlotPtr custom_plot)
   const std::string& curve_name = custom_plot->aliasName().toStdString();
 
   // clear already existing data first
+  PlotWidgetBase::waitForRendering();
   auto data_it = _mapped_plot_data.numeric.find(curve_name);
   if (data_it != _mapped_plot_data.numeric.end())
   {
@@ -2813,7 +3365,7 @@ QDir::currentPath()).toString();
 
 void MainWindow::on_pushButtonLoadDatafile_clicked()
 {
-  if (_data_loader.empty())
+  if (_data_loader_extensions.empty())
   {
     QMessageBox::warning(this, tr("Warning"),
                          tr("No plugin was loaded to process a data file\n"));
@@ -2826,10 +3378,9 @@ void MainWindow::on_pushButtonLoadDatafile_clicked()
 
   std::set<QString> extensions;
 
-  for (auto& it : _data_loader)
+  for (const auto& it : _data_loader_extensions)
   {
-    DataLoaderPtr loader = it.second;
-    for (QString extension : loader->compatibleFileExtensions())
+    for (const QString& extension : it.second)
     {
       extensions.insert(extension.toLower());
     }
@@ -3111,6 +3662,8 @@ void MainWindow::on_actionPreferences_triggered()
   PreferencesDialog dialog;
   dialog.exec();
 
+  loadStreamingPreferences();
+
   QString theme = settings.value("Preferences::theme").toString();
 
   if (theme != prev_style)
@@ -3119,6 +3672,21 @@ void MainWindow::on_actionPreferences_triggered()
   }
 }
 
+void MainWindow::loadStreamingPreferences()
+{
+  QSettings settings;
+  int max_fps = settings.value("Preferences::streaming_max_fps", 25).toInt();
+  int cpu_budget = settings.value("Preferences::streaming_cpu_budget", 50).toInt();
+
+  _replot_scheduler->setMaximumFrameRate(max_fps);
+  _replot_scheduler->setCpuBudget(0.01 * cpu_budget);
+
+  int memory_budget_mb = settings.value("Preferences::memory_budget_mb", 0).toInt();
+  _memory_budget.setBudget(size_t(memory_budget_mb) * 1024 * 1024);
+  _memory_budget.setCompression(
+      settings.value("Preferences::compress_history", false).toBool());
+}
+
 void MainWindow::on_playbackStep_valueChanged(double step)
 {
   ui->timeSlider->setFocus();
@@ -3188,7 +3756,13 @@ void MainWindow::on_comboStreaming_currentIndexChanged(const QString& current_te
 {
   QSettings settings;
   settings.setValue("MainWindow.previousStreamingPlugin", current_text);
-  auto streamer = _data_streamer.at(current_text);
+  auto streamer = dataStreamer(current_text);
+  if (!streamer)
+  {
+    ui->buttonStreamingOptions->setEnabled(false);
+    ui->buttonStreamingNotifications->setEnabled(false);
+    return;
+  }
   ui->buttonStreamingOptions->setEnabled(!streamer->availableActions().empty());
 
   std::pair<QAction*, int> notifications_pair = streamer->notificationAction();
@@ -3251,7 +3825,11 @@ void MainWindow::on_buttonRecentData_clicked()
 
 void MainWindow::on_buttonStreamingOptions_clicked()
 {
-  auto streamer = _data_streamer.at(ui->comboStreaming->currentText());
+  auto streamer = dataStreamer(ui->comboStreaming->currentText());
+  if (!streamer)
+  {
+    return;
+  }
 
   PopupMenu* menu = new PopupMenu(ui->buttonStreamingOptions, this);
   for (auto action : streamer->availableActions())
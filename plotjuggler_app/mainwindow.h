@@ -17,11 +17,14 @@
 #include "curvelist_panel.h"
 #include "tabbedplotwidget.h"
 #include "realslider.h"
+#include "replot_scheduler.h"
 #include "utils.h"
 #include "PlotJuggler/dataloader_base.h"
 #include "PlotJuggler/statepublisher_base.h"
 #include "PlotJuggler/toolbox_base.h"
 #include "PlotJuggler/datastreamer_base.h"
+#include "PlotJuggler/memory_budget.h"
+#include "plugin_manifest.h"
 #include "transforms/custom_function.h"
 #include "transforms/function_editor.h"
 
@@ -37,10 +40,24 @@ public:
 
   ~MainWindow();
 
-  bool loadLayoutFromFile(QString filename);
+  /**
+   * @brief Load a layout and the data files it refers to.
+   *
+   * @param datafiles  if not empty, they replace the data files of the layout, in the
+   *                   same order, keeping the configuration of the DataLoader.
+   */
+  bool loadLayoutFromFile(QString filename, const QStringList& datafiles = {});
   bool loadDataFromFiles(QStringList filenames);
   std::unordered_set<std::string> loadDataFromFile(const FileLoadInfo& info);
 
+  /**
+   * @brief Load many files, concurrently if their DataLoader supports it, and
+   * replot once at the end.
+   * @return the names of the series loaded from each file.
+   */
+  std::vector<std::unordered_set<std::string>>
+  loadDataFileBatch(const std::vector<FileLoadInfo>& infos);
+
   void stopStreamingPlugin();
   void startStreamingPlugin(QString streamer_name);
   void enableStreamingNotificationsButton(bool enabled);
@@ -115,6 +132,15 @@ private:
   std::map<QString, DataLoaderPtr> _data_loader;
   std::map<QString, StatePublisherPtr> _state_publisher;
   std::map<QString, DataStreamerPtr> _data_streamer;
+  std::map<QString, ToolboxPluginPtr> _toolboxes;
+
+  PluginManifest _plugin_manifest;
+  // DataLoaders, DataStreamers and Toolboxes found in the manifest, loaded on first use
+  std::map<QString, PluginManifest::Entry> _lazy_plugins;
+  // state read from the layout, for the plugins in _lazy_plugins
+  std::map<QString, QDomElement> _lazy_plugins_state;
+  // extensions of all the DataLoaders, including the lazy ones
+  std::map<QString, QStringList> _data_loader_extensions;
 
   QString _default_streamer;
 
@@ -122,8 +148,39 @@ private:
 
   std::shared_ptr<DataStreamer> _active_streamer_plugin;
 
-  std::deque<QDomDocument> _undo_states;
-  std::deque<QDomDocument> _redo_states;
+  // Position of a PlotWidget in the layout. Unlike the pointer, it is still valid
+  // after the layout has been rebuilt.
+  struct PlotPath
+  {
+    QString tabbed_widget;
+    int tab = -1;
+    int index = -1;
+  };
+
+  struct PlotChange
+  {
+    PlotPath path;
+    QDomDocument before;
+    QDomDocument after;
+  };
+
+  // Changes of one or more PlotWidgets are stored as deltas and applied in place.
+  // Changes of the structure of the layout (tabs, splits) store the entire layout.
+  struct UndoEntry
+  {
+    QDomDocument layout;
+    std::vector<PlotChange> plots;
+
+    bool isLayout() const
+    {
+      return plots.empty();
+    }
+  };
+
+  std::deque<UndoEntry> _undo_states;
+  std::deque<UndoEntry> _redo_states;
+  // last known state of each PlotWidget, used as "before" of the next PlotChange
+  std::map<PlotWidget*, QDomDocument> _plot_states;
   QElapsedTimer _undo_timer;
   bool _disable_undo_logging;
 
@@ -131,6 +188,9 @@ private:
 
   bool _autostart_publishers;
 
+  // started with --export: no window is shown and no question is asked
+  bool _headless;
+
   double _tracker_time;
 
   QStringList _enabled_plugins;
@@ -143,7 +203,8 @@ private:
 
   MonitoredValue _time_offset;
 
-  QTimer* _replot_timer;
+  ReplotScheduler* _replot_scheduler;
+  MemoryBudget _memory_budget;
   QTimer* _publish_timer;
   QTimer* _tracker_delaty_timer;
 
@@ -171,11 +232,30 @@ private:
   void initializeActions();
   QStringList initializePlugins(QString subdir_name);
 
+  QObject* instantiatePlugin(PluginManifest::Entry& entry);
+  void registerPlugin(QObject* plugin, const QString& plugin_name);
+  QObject* loadLazyPlugin(const QString& plugin_name);
+  void addToolboxAction(const QString& plugin_name);
+
+  // these load the plugin, if necessary. Return nullptr if not found
+  DataLoaderPtr dataLoader(const QString& plugin_name);
+  DataStreamerPtr dataStreamer(const QString& plugin_name);
+  ToolboxPluginPtr toolboxPlugin(const QString& plugin_name);
+
+  void forEachDocker(std::function<void(PlotDocker*)> op);
   void forEachWidget(std::function<void(PlotWidget*, PlotDocker*, int)> op);
   void forEachWidget(std::function<void(PlotWidget*)> op);
 
   void rearrangeGridLayout();
 
+  void recordPlotChanges(const std::vector<PlotWidget*>& plots);
+  void recordLayoutChange();
+  void pushUndoEntry(UndoEntry&& entry);
+  void applyPlotChanges(const std::vector<PlotChange>& changes, bool undo);
+  void refreshPlotStates();
+  bool findPlotPath(PlotWidget* plot, PlotPath& path) const;
+  PlotWidget* plotFromPath(const PlotPath& path) const;
+
   QDomDocument xmlSaveState() const;
   bool xmlLoadState(QDomDocument state_document);
 
@@ -183,6 +263,8 @@ private:
 
   void importPlotDataMap(PlotDataMapRef& new_data, bool remove_old);
 
+  DataLoaderPtr selectDataLoader(const QString& filename);
+
   bool isStreamingActive() const;
 
   void closeEvent(QCloseEvent* event);
@@ -208,6 +290,8 @@ private:
 
   void updateDerivedSeries();
 
+  void loadStreamingPreferences();
+
 signals:
   void dataSourceRemoved(const std::string& name);
   void dataSourceUpdated(const std::string& name);
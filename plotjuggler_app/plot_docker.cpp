@@ -113,6 +113,11 @@ QDomElement saveChildNodesState(QDomDocument& doc, QWidget* widget)
 
 QDomElement PlotDocker::xmlSaveState(QDomDocument& doc) const
 {
+  if (isDeferred())
+  {
+    return doc.importNode(_deferred_state.documentElement(), true).toElement();
+  }
+
   QDomElement containers_elem = doc.createElement("Tab");
 
   containers_elem.setAttribute("containers", dockContainers().count());
@@ -201,7 +206,11 @@ void PlotDocker::restoreSplitter(QDomElement elem, DockWidget* widget)
 
 bool PlotDocker::xmlLoadState(QDomElement& tab_element)
 {
-  if (!isHidden())
+  _deferred_state.clear();
+
+  // a tab that is not the current one must remain hidden
+  const bool was_hidden = isHidden();
+  if (!was_hidden)
   {
     hide();
   }
@@ -219,13 +228,44 @@ bool PlotDocker::xmlLoadState(QDomElement& tab_element)
     }
   }
 
-  if (isHidden())
+  if (!was_hidden)
   {
     show();
   }
   return true;
 }
 
+void PlotDocker::setDeferredState(const QDomElement& tab_element)
+{
+  _deferred_state = QDomDocument();
+  _deferred_state.appendChild(_deferred_state.importNode(tab_element, true));
+  _deferred_zoom_out = false;
+}
+
+bool PlotDocker::isDeferred() const
+{
+  return !_deferred_state.documentElement().isNull();
+}
+
+void PlotDocker::materialize()
+{
+  if (!isDeferred())
+  {
+    return;
+  }
+  // xmlLoadState() releases _deferred_state
+  QDomDocument state = _deferred_state;
+  QDomElement tab_element = state.documentElement();
+  xmlLoadState(tab_element);
+
+  if (_deferred_zoom_out)
+  {
+    _deferred_zoom_out = false;
+    zoomOut();
+  }
+  emit materialized();
+}
+
 int PlotDocker::plotCount() const
 {
   return dockAreaCount();
@@ -245,6 +285,11 @@ void PlotDocker::setHorizontalLink(bool enabled)
 
 void PlotDocker::zoomOut()
 {
+  if (isDeferred())
+  {
+    _deferred_zoom_out = true;
+    return;
+  }
   for (int index = 0; index < plotCount(); index++)
   {
     plotAt(index)->zoomOut(false);  // TODO is it false?
@@ -1,6 +1,7 @@
 #ifndef PLOT_DOCKER_H
 #define PLOT_DOCKER_H
 
+#include <QDomDocument>
 #include <QDomElement>
 #include <QXmlStreamReader>
 #include "Qads/DockManager.h"
@@ -115,6 +116,18 @@ public:
 
   bool xmlLoadState(QDomElement& tab_element);
 
+  /**
+   * The plots are created by materialize(), when the tab is shown for the first time.
+   * Until then, the docker contains a single empty plot and xmlSaveState() returns a
+   * copy of tab_element.
+   */
+  void setDeferredState(const QDomElement& tab_element);
+
+  bool isDeferred() const;
+
+  /// Load the deferred state, if any.
+  void materialize();
+
   int plotCount() const;
 
   PlotWidget* plotAt(int index);
@@ -136,10 +149,17 @@ private:
 
   PlotDataMapRef& _datamap;
 
+  // see setDeferredState(). Empty if the plots were already created
+  QDomDocument _deferred_state;
+  // zoomOut() was called before materialize()
+  bool _deferred_zoom_out = false;
+
 signals:
 
   void plotWidgetAdded(PlotWidget*);
 
+  void materialized();
+
   void undoableChange();
 };
 
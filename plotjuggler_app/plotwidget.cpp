@@ -11,6 +11,7 @@
 #include <QMenu>
 #include <QMimeData>
 #include <QPainter>
+#include <QPdfWriter>
 #include <QPushButton>
 #include <QWheelEvent>
 #include <QSettings>
@@ -258,7 +259,8 @@ void PlotWidget::canvasContextMenuTriggered(const QPoint& pos)
 }
 
 PlotWidget::CurveInfo* PlotWidget::addCurveXY(std::string name_x, std::string name_y,
-                                              QString curve_name)
+                                              QString curve_name,
+                                              PointSeriesXY::TimeMatching matching)
 {
   std::string name = curve_name.toStdString();
 
@@ -319,7 +321,7 @@ PlotWidget::CurveInfo* PlotWidget::addCurveXY(std::string name_x, std::string na
 
   try
   {
-    auto plot_qwt = createCurveXY(&data_x, &data_y);
+    auto plot_qwt = createCurveXY(&data_x, &data_y, matching);
 
     curve->setPaintAttribute(QwtPlotCurve::ClipPolygons, true);
     curve->setPaintAttribute(QwtPlotCurve::FilterPointsAggressive, true);
@@ -573,6 +575,10 @@ QDomElement PlotWidget::xmlSaveState(QDomDocument& doc) const
                             QString::fromStdString(curve_xy->dataX()->plotName()));
       curve_el.setAttribute("curve_y",
                             QString::fromStdString(curve_xy->dataY()->plotName()));
+      if (curve_xy->timeMatching() == PointSeriesXY::TimeMatching::INTERPOLATE)
+      {
+        curve_el.setAttribute("time_matching", "interpolate");
+      }
     }
     else
     {
@@ -620,6 +626,7 @@ bool PlotWidget::xmlLoadState(QDomElement& plot_widget)
   static bool warning_message_shown = false;
 
   // removeAllCurves simplified
+  PlotWidgetBase::waitForRendering();
   for (auto& it : curveList())
   {
     it.curve->detach();
@@ -678,7 +685,11 @@ bool PlotWidget::xmlLoadState(QDomElement& plot_widget)
       }
       else
       {
-        auto curve_it = addCurveXY(curve_x, curve_y, curve_name);
+        const auto matching =
+            (curve_element.attribute("time_matching") == "interpolate") ?
+                PointSeriesXY::TimeMatching::INTERPOLATE :
+                PointSeriesXY::TimeMatching::EXACT;
+        auto curve_it = addCurveXY(curve_x, curve_y, curve_name, matching);
         if (!curve_it)
         {
           continue;
@@ -820,6 +831,7 @@ void PlotWidget::reloadPlotData()
   // TODO: this needs MUCH more testing
 
   int visible = 0;
+  PlotWidgetBase::waitForRendering();
 
   for (auto& it : curveList())
   {
@@ -904,6 +916,7 @@ void PlotWidget::on_changeTimeOffset(double offset)
 
   if (fabs(prev_offset - offset) > std::numeric_limits<double>::epsilon())
   {
+    PlotWidgetBase::waitForRendering();
     for (auto& it : curveList())
     {
       auto series = dynamic_cast<QwtSeriesWrapper*>(it.curve->data());
@@ -972,15 +985,28 @@ Range PlotWidget::getVisualizationRangeY(Range range_X) const
   return Range({ bottom, top });
 }
 
-void PlotWidget::updateCurves(bool reset_older_data)
+bool PlotWidget::updateCurves(bool reset_older_data)
 {
+  PlotWidgetBase::waitForRendering();
+  bool updated = false;
   for (auto& it : curveList())
   {
     auto series = dynamic_cast<QwtSeriesWrapper*>(it.curve->data());
+    const uint64_t generation = series->dataGeneration();
+    if (!reset_older_data && generation == it.data_generation)
+    {
+      continue;
+    }
     series->updateCache(reset_older_data);
     // TODO check res and do something if false.
+    it.data_generation = generation;
+    updated = true;
   }
-  updateMaximumZoomArea();
+  if (updated || reset_older_data)
+  {
+    updateMaximumZoomArea();
+  }
+  return updated;
 }
 
 void PlotWidget::on_changeCurveColor(const QString& curve_name, QColor new_color)
@@ -1024,6 +1050,7 @@ void PlotWidget::on_externallyResized(const QRectF& rect)
 
 void PlotWidget::zoomOut(bool emit_signal)
 {
+  _zoom_out_pending = false;
   if (curveList().size() == 0)
   {
     QRectF rect(0, 1, 1, -1);
@@ -1106,7 +1133,8 @@ void PlotWidget::on_savePlotToFile()
   QStringList filters;
   filters << "png (*.png)"
           << "jpg (*.jpg *.jpeg)"
-          << "svg (*.svg)";
+          << "svg (*.svg)"
+          << "pdf (*.pdf)";
 
   saveDialog.setNameFilters(filters);
   saveDialog.exec();
@@ -1120,7 +1148,6 @@ void PlotWidget::on_savePlotToFile()
       return;
     }
 
-    bool is_svg = false;
     QFileInfo fileinfo(fileName);
     if (fileinfo.suffix().isEmpty())
     {
@@ -1136,7 +1163,10 @@ void PlotWidget::on_savePlotToFile()
       else if (filter == filters[2])
       {
         fileName.append(".svg");
-        is_svg = true;
+      }
+      else if (filter == filters[3])
+      {
+        fileName.append(".pdf");
       }
     }
 
@@ -1147,25 +1177,7 @@ void PlotWidget::on_savePlotToFile()
       replot();
     }
 
-    QRect documentRect(0, 0, 1200, 900);
-    QwtPlotRenderer rend;
-
-    if (is_svg)
-    {
-      QSvgGenerator generator;
-      generator.setFileName(fileName);
-      generator.setResolution(80);
-      generator.setViewBox(documentRect);
-      QPainter painter(&generator);
-      rend.render(qwtPlot(), &painter, documentRect);
-    }
-    else
-    {
-      QPixmap pixmap(1200, 900);
-      QPainter painter(&pixmap);
-      rend.render(qwtPlot(), &painter, documentRect);
-      pixmap.save(fileName);
-    }
+    exportToFile(fileName, QSize(1200, 900));
 
     if (tracker_enabled)
     {
@@ -1175,6 +1187,56 @@ void PlotWidget::on_savePlotToFile()
   }
 }
 
+bool PlotWidget::exportToFile(const QString& file_name, QSize size)
+{
+  return savePicture(renderToPicture(size), file_name, size);
+}
+
+QPicture PlotWidget::renderToPicture(QSize size)
+{
+  QPicture picture;
+  QPainter painter(&picture);
+  QwtPlotRenderer rend;
+  rend.render(qwtPlot(), &painter, QRect(QPoint(0, 0), size));
+  painter.end();
+  return picture;
+}
+
+bool PlotWidget::savePicture(const QPicture& picture, const QString& file_name,
+                             QSize size)
+{
+  const QString suffix = QFileInfo(file_name).suffix().toLower();
+
+  if (suffix == "svg")
+  {
+    QSvgGenerator generator;
+    generator.setFileName(file_name);
+    generator.setResolution(80);
+    generator.setViewBox(QRect(QPoint(0, 0), size));
+    QPainter painter(&generator);
+    painter.drawPicture(0, 0, picture);
+    return painter.end();
+  }
+  if (suffix == "pdf")
+  {
+    // one point per pixel
+    QPdfWriter writer(file_name);
+    writer.setResolution(72);
+    writer.setPageSize(QPageSize(size, QString(), QPageSize::ExactMatch));
+    writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+    QPainter painter(&writer);
+    painter.drawPicture(0, 0, picture);
+    return painter.end();
+  }
+  // QPixmap can be used only by the GUI thread
+  QImage image(size, QImage::Format_ARGB32);
+  image.fill(Qt::white);
+  QPainter painter(&image);
+  painter.drawPicture(0, 0, picture);
+  painter.end();
+  return image.save(file_name);
+}
+
 void PlotWidget::setCustomAxisLimits(Range range)
 {
   _custom_Y_limits = range;
@@ -1291,10 +1353,44 @@ bool PlotWidget::isZoomLinkEnabled() const
   return true;
 }
 
+bool PlotWidget::isVisibleOnScreen() const
+{
+  const QWidget* canvas = widget();
+  if (!canvas->isVisible() || canvas->window()->isMinimized())
+  {
+    return false;
+  }
+  return !canvas->visibleRegion().isEmpty();
+}
+
+void PlotWidget::zoomOutWhenVisible()
+{
+  if (isVisibleOnScreen())
+  {
+    zoomOut(false);
+  }
+  else
+  {
+    _zoom_out_pending = true;
+  }
+}
+
 bool PlotWidget::canvasEventFilter(QEvent* event)
 {
   switch (event->type())
   {
+    case QEvent::Show:
+    case QEvent::Paint: {
+      // shown, or no longer covered by another window
+      if (_zoom_out_pending)
+      {
+        _zoom_out_pending = false;
+        // not while the canvas is being painted
+        QMetaObject::invokeMethod(
+            this, [this]() { zoomOut(false); }, Qt::QueuedConnection);
+      }
+      return false;
+    }
     case QEvent::MouseButtonPress: {
       if (_dragging.mode != DragInfo::NONE)
       {
@@ -1377,22 +1473,11 @@ bool PlotWidget::canvasEventFilter(QEvent* event)
 
 void PlotWidget::setDefaultRangeX()
 {
-  if (!curveList().empty())
+  auto range = _mapped_data.time_range->range();
+  if (!curveList().empty() && range)
   {
-    double min = std::numeric_limits<double>::max();
-    double max = -std::numeric_limits<double>::max();
-    for (auto& it : _mapped_data.numeric)
-    {
-      const PlotData& data = it.second;
-      if (data.size() > 0)
-      {
-        double A = data.front().x;
-        double B = data.back().x;
-        min = std::min(A, min);
-        max = std::max(B, max);
-      }
-    }
-    qwtPlot()->setAxisScale(QwtPlot::xBottom, min - _time_offset, max - _time_offset);
+    qwtPlot()->setAxisScale(QwtPlot::xBottom, range->min - _time_offset,
+                            range->max - _time_offset);
   }
   else
   {
@@ -1401,13 +1486,14 @@ void PlotWidget::setDefaultRangeX()
 }
 
 QwtSeriesWrapper* PlotWidget::createCurveXY(const PlotData* data_x,
-                                            const PlotData* data_y)
+                                            const PlotData* data_y,
+                                            PointSeriesXY::TimeMatching matching)
 {
   QwtSeriesWrapper* output = nullptr;
 
   try
   {
-    output = new PointSeriesXY(data_x, data_y);
+    output = new PointSeriesXY(data_x, data_y, matching);
   }
   catch (std::runtime_error& ex)
   {
@@ -1418,8 +1504,22 @@ QwtSeriesWrapper* PlotWidget::createCurveXY(const PlotData* data_x,
       msgBox.setText(tr("The creation of the XY plot failed with the following "
                         "message:\n %1")
                          .arg(ex.what()));
-      msgBox.addButton("Continue", QMessageBox::AcceptRole);
+      QPushButton* interpolate = nullptr;
+      if (matching == PointSeriesXY::TimeMatching::EXACT)
+      {
+        msgBox.setInformativeText("The value of X can be interpolated at the time of Y.");
+        interpolate = msgBox.addButton("Interpolate X", QMessageBox::AcceptRole);
+        msgBox.addButton("Cancel", QMessageBox::RejectRole);
+      }
+      else
+      {
+        msgBox.addButton("Continue", QMessageBox::AcceptRole);
+      }
       msgBox.exec();
+      if (interpolate && msgBox.clickedButton() == interpolate)
+      {
+        return createCurveXY(data_x, data_y, PointSeriesXY::TimeMatching::INTERPOLATE);
+      }
     }
     throw std::runtime_error("Creation of XY plot failed");
   }
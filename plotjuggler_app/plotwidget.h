@@ -5,6 +5,7 @@
 #include <deque>
 #include <QObject>
 #include <QTextEdit>
+#include <QPicture>
 #include <QDomDocument>
 #include <QMessageBox>
 #include <QTime>
@@ -12,6 +13,7 @@
 #include "qwt_plot.h"
 #include "qwt_plot_curve.h"
 #include "qwt_plot_grid.h"
+#include "point_series_xy.h"
 #include "qwt_symbol.h"
 #include "qwt_legend.h"
 #include "qwt_plot_rescaler.h"
@@ -57,7 +59,9 @@ public:
     return _mapped_data;
   }
 
-  CurveInfo* addCurveXY(std::string name_x, std::string name_y, QString curve_name = "");
+  CurveInfo* addCurveXY(
+      std::string name_x, std::string name_y, QString curve_name = "",
+      PointSeriesXY::TimeMatching matching = PointSeriesXY::TimeMatching::EXACT);
 
   CurveInfo* addCurve(const std::string& name, QColor color = Qt::transparent);
 
@@ -69,6 +73,30 @@ public:
 
   bool isZoomLinkEnabled() const;
 
+  /// False if the widget is hidden, minimized or entirely covered.
+  bool isVisibleOnScreen() const;
+
+  /// zoomOut() now if isVisibleOnScreen(), otherwise when the plot becomes visible.
+  void zoomOutWhenVisible();
+
+  /**
+   * @brief Render the plot into an image (png, jpg...), svg or pdf file, depending on
+   * the extension of file_name. Same as savePicture(renderToPicture(size), ...).
+   */
+  bool exportToFile(const QString& file_name, QSize size);
+
+  /// Record the painting commands of the plot. Only the GUI thread can call it.
+  QPicture renderToPicture(QSize size);
+
+  /**
+   * @brief Write a picture recorded by renderToPicture() into an image (png, jpg...),
+   * svg or pdf file, depending on the extension of file_name.
+   *
+   * It doesn't use the widget: it can be called by any thread.
+   */
+  static bool savePicture(const QPicture& picture, const QString& file_name,
+                          QSize size);
+
 protected:
   PlotDataMapRef& _mapped_data;
 
@@ -90,7 +118,8 @@ signals:
 
 public slots:
 
-  void updateCurves(bool reset_older_data);
+  /// Return false if none of the curves received new data (nothing to replot).
+  bool updateCurves(bool reset_older_data);
 
   void onDataSourceRemoved(const std::string& src_name);
 
@@ -182,7 +211,8 @@ private:
 
   void setDefaultRangeX();
 
-  QwtSeriesWrapper* createCurveXY(const PlotData* data_x, const PlotData* data_y);
+  QwtSeriesWrapper* createCurveXY(const PlotData* data_x, const PlotData* data_y,
+                                  PointSeriesXY::TimeMatching matching);
 
   QwtSeriesWrapper* createTimeSeries(const QString& transform_ID,
                                      const PlotData* data) override;
@@ -197,6 +227,9 @@ private:
 
   bool _context_menu_enabled;
 
+  // see zoomOutWhenVisible()
+  bool _zoom_out_pending = false;
+
   // void updateMaximumZoomArea();
   void rescaleEqualAxisScaling();
   void overrideCursonMove();
@@ -172,6 +172,7 @@ void DialogTransformEditor::on_listTransforms_itemSelectionChanged()
   auto ts = dynamic_cast<TransformedTimeseries*>(curve_info->curve->data());
 
   QSignalBlocker block(ui->lineEditAlias);
+  PlotWidgetBase::waitForRendering();
 
   if (transform_ID.isEmpty() || transform_ID == ui->listTransforms->item(0)->text())
   {
@@ -212,6 +213,7 @@ void DialogTransformEditor::on_listTransforms_itemSelectionChanged()
     if (_connected_transform_widgets.count(widget) == 0)
     {
       connect(ts->transform().get(), &TransformFunction::parametersChanged, this, [=]() {
+        PlotWidgetBase::waitForRendering();
         ts->updateCache(true);
         _plotwidget->zoomOut(false);
       });
@@ -0,0 +1,133 @@
+#include "plugin_manifest.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace
+{
+const char* MANIFEST_VERSION = PJ_MAJOR_VERSION "." PJ_MINOR_VERSION "." PJ_PATCH_VERSION;
+}
+
+PluginManifest::PluginManifest(QString cache_file) : _cache_file(std::move(cache_file))
+{
+}
+
+QString PluginManifest::defaultCacheFile()
+{
+  return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+         "/plugin_manifest.json";
+}
+
+bool PluginManifest::load()
+{
+  _entries.clear();
+  _used.clear();
+
+  QFile file(_cache_file);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return false;
+  }
+  const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+  if (root["version"].toString() != MANIFEST_VERSION)
+  {
+    return false;
+  }
+
+  for (const auto& value : root["plugins"].toArray())
+  {
+    const QJsonObject obj = value.toObject();
+    Entry entry;
+    entry.file_path = obj["file_path"].toString();
+    entry.file_size = obj["file_size"].toVariant().toLongLong();
+    entry.modified = obj["modified"].toVariant().toLongLong();
+    entry.iid = obj["iid"].toString();
+    entry.class_name = obj["class_name"].toString();
+    entry.name = obj["name"].toString();
+    entry.type = obj["type"].toString();
+    entry.is_debug = obj["is_debug"].toBool();
+    for (const auto& extension : obj["file_extensions"].toArray())
+    {
+      entry.file_extensions.push_back(extension.toString());
+    }
+    _entries[entry.file_path] = entry;
+  }
+  return true;
+}
+
+bool PluginManifest::save() const
+{
+  QJsonArray plugins;
+  for (const auto& path : _used)
+  {
+    const Entry& entry = _entries.at(path);
+    QJsonObject obj;
+    obj["file_path"] = entry.file_path;
+    // stored as strings: a JSON number can not hold all the values of qint64
+    obj["file_size"] = QString::number(entry.file_size);
+    obj["modified"] = QString::number(entry.modified);
+    if (entry.isPlugin())
+    {
+      obj["iid"] = entry.iid;
+      obj["class_name"] = entry.class_name;
+      obj["name"] = entry.name;
+      obj["type"] = entry.type;
+      obj["is_debug"] = entry.is_debug;
+      if (!entry.file_extensions.empty())
+      {
+        obj["file_extensions"] = QJsonArray::fromStringList(entry.file_extensions);
+      }
+    }
+    plugins.append(obj);
+  }
+
+  QJsonObject root;
+  root["version"] = MANIFEST_VERSION;
+  root["plugins"] = plugins;
+
+  QDir().mkpath(QFileInfo(_cache_file).absolutePath());
+  QSaveFile file(_cache_file);
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    return false;
+  }
+  file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+  return file.commit();
+}
+
+std::optional<PluginManifest::Entry> PluginManifest::find(const QFileInfo& file)
+{
+  auto it = _entries.find(file.absoluteFilePath());
+  if (it == _entries.end())
+  {
+    return std::nullopt;
+  }
+  const Entry current = createEntry(file);
+  if (it->second.file_size != current.file_size ||
+      it->second.modified != current.modified)
+  {
+    return std::nullopt;
+  }
+  _used.insert(it->first);
+  return it->second;
+}
+
+PluginManifest::Entry PluginManifest::createEntry(const QFileInfo& file)
+{
+  Entry entry;
+  entry.file_path = file.absoluteFilePath();
+  entry.file_size = file.size();
+  entry.modified = file.lastModified().toMSecsSinceEpoch();
+  return entry;
+}
+
+void PluginManifest::insert(const Entry& entry)
+{
+  _entries[entry.file_path] = entry;
+  _used.insert(entry.file_path);
+}
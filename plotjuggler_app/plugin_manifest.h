@@ -0,0 +1,71 @@
+#ifndef PLUGIN_MANIFEST_H
+#define PLUGIN_MANIFEST_H
+
+#include <map>
+#include <optional>
+#include <set>
+#include <QFileInfo>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Persistent cache of the files found in the plugin folders.
+ *
+ * It stores what MainWindow needs to know about a plugin before loading its library:
+ * the name, the type and, for a DataLoader, the file extensions. Files that are
+ * not plugins are stored too, so that they aren't opened again at the next startup.
+ *
+ * An entry is valid as long as the size and the modification time of the file
+ * don't change, and the cache is discarded when the version of PlotJuggler changes.
+ */
+class PluginManifest
+{
+public:
+  struct Entry
+  {
+    QString file_path;
+    qint64 file_size = 0;
+    // milliseconds since epoch
+    qint64 modified = 0;
+
+    // the fields below are empty if the file is not a PlotJuggler plugin
+    QString iid;
+    QString class_name;
+    QString name;
+    // DataLoader, DataStreamer, StatePublisher, MessageParser or Toolbox
+    QString type;
+    bool is_debug = false;
+    // DataLoader only
+    QStringList file_extensions;
+
+    bool isPlugin() const
+    {
+      return !type.isEmpty();
+    }
+  };
+
+  explicit PluginManifest(QString cache_file = defaultCacheFile());
+
+  static QString defaultCacheFile();
+
+  /// Read the cache file. Return false if missing or not valid.
+  bool load();
+
+  /// Write the entries returned by find() or added by insert() since load().
+  bool save() const;
+
+  /// Entry of the file, if it was not modified since the entry was created.
+  std::optional<Entry> find(const QFileInfo& file);
+
+  /// Entry with the path, size and modification time of the file.
+  static Entry createEntry(const QFileInfo& file);
+
+  void insert(const Entry& entry);
+
+private:
+  QString _cache_file;
+  std::map<QString, Entry> _entries;
+  std::set<QString> _used;
+};
+
+#endif  // PLUGIN_MANIFEST_H
@@ -1,14 +1,25 @@
 #include "point_series_xy.h"
 #include <cmath>
 #include <cstdlib>
+#include <algorithm>
+#include "PlotJuggler/series_join.h"
 
-PointSeriesXY::PointSeriesXY(const PlotData* x_axis, const PlotData* y_axis)
+PointSeriesXY::PointSeriesXY(const PlotData* x_axis, const PlotData* y_axis,
+                             TimeMatching matching)
   : QwtSeriesWrapper(&_cached_curve)
   , _x_axis(x_axis)
   , _y_axis(y_axis)
+  , _x_pin(x_axis->pinHistory())
+  , _y_pin(y_axis->pinHistory())
+  , _matching(matching)
   , _cached_curve("", x_axis->group())
+  , _last_time(-std::numeric_limits<double>::max())
 {
   updateCache(true);
+  if (_unmatched_samples > 0)
+  {
+    throw std::runtime_error("X and Y axis don't share the same time axis");
+  }
 }
 
 size_t PointSeriesXY::size() const
@@ -18,17 +29,24 @@ size_t PointSeriesXY::size() const
 
 std::optional<QPointF> PointSeriesXY::sampleFromTime(double t)
 {
-  if (_cached_curve.size() == 0)
+  if (_cached_time.empty())
   {
     return {};
   }
 
-  int index = _y_axis->getIndexFromX(t);
-  if (index < 0)
+  auto lower = std::lower_bound(_cached_time.begin(), _cached_time.end(), t);
+  size_t index = std::distance(_cached_time.begin(), lower);
+
+  if (index >= _cached_time.size())
   {
-    return {};
+    index = _cached_time.size() - 1;
   }
-  const auto& p = _cached_curve.at(size_t(index));
+  else if (index > 0 && (std::abs(_cached_time[index - 1] - t) <
+                         std::abs(_cached_time[index] - t)))
+  {
+    index = index - 1;
+  }
+  const auto& p = _cached_curve.at(index);
   return QPointF(p.x, p.y);
 }
 
@@ -39,37 +57,84 @@ RangeOpt PointSeriesXY::getVisualizationRangeY(Range)
 
 bool PointSeriesXY::updateCache(bool reset_old_data)
 {
-  // TODO use reset_old_data
-
-  _cached_curve.clear();
-
   if (_x_axis == nullptr)
   {
     throw std::runtime_error("the X axis is null");
   }
 
-  const size_t data_size = std::min(_x_axis->size(), _y_axis->size());
+  // a source cleared and filled again may have points older than _last_time
+  if (_x_axis->clearCount() != _x_clear_count || _y_axis->clearCount() != _y_clear_count)
+  {
+    reset_old_data = true;
+    _x_clear_count = _x_axis->clearCount();
+    _y_clear_count = _y_axis->clearCount();
+  }
+
+  if (reset_old_data || _x_axis->size() == 0 || _y_axis->size() == 0)
+  {
+    _cached_curve.clear();
+    _cached_time.clear();
+    _last_time = -std::numeric_limits<double>::max();
+    _unmatched_samples = 0;
+  }
 
-  if (data_size == 0)
+  if (_x_axis->size() == 0 || _y_axis->size() == 0)
   {
     return true;
   }
 
   const double EPS = std::numeric_limits<double>::epsilon();
 
-  for (size_t i = 0; i < data_size; i++)
+  // mirror the samples removed from the front of the source series
+  const double front_time = std::max(_x_axis->front().x, _y_axis->front().x);
+  while (!_cached_time.empty() && _cached_time.front() < front_time - EPS)
   {
-    if (std::abs(_x_axis->at(i).x - _y_axis->at(i).x) > EPS)
+    _cached_curve.popFront();
+    _cached_time.pop_front();
+  }
+
+  auto time_less = [](double t, const PlotData::Point& p) { return t < p.x; };
+
+  auto y_it = std::upper_bound(_y_axis->begin(), _y_axis->end(), _last_time, time_less);
+
+  // the value of X at the time of each point of Y
+  const auto policy = (_matching == TimeMatching::INTERPOLATE) ? PJ::JoinPolicy::LINEAR :
+                                                                 PJ::JoinPolicy::EXACT;
+  PJ::SeriesCursor x_cursor(*_x_axis, policy);
+
+  for (; y_it != _y_axis->end(); y_it++)
+  {
+    const double t = y_it->x;
+    if (!x_cursor.reached(t))
     {
-      throw std::runtime_error("X and Y axis don't share the same time axis");
+      // X has not been received yet. Try again at the next update.
+      break;
     }
+    _last_time = t;
 
-    const QPointF p(_x_axis->at(i).y, _y_axis->at(i).y);
-    _cached_curve.pushBack({ p.x(), p.y() });
+    // std::nullopt if older than the first sample of X or, with EXACT, if X has
+    // no sample at time t
+    const auto x_value = x_cursor.valueAt(t);
+    if (!x_value && _matching == TimeMatching::EXACT)
+    {
+      _unmatched_samples++;
+    }
+    if (!x_value || !std::isfinite(*x_value) || !std::isfinite(y_it->y))
+    {
+      continue;
+    }
+    _cached_curve.pushBack({ *x_value, y_it->y });
+    _cached_time.push_back(t);
   }
   return true;
 }
 
+uint64_t PointSeriesXY::dataGeneration() const
+{
+  // both counters only increase, therefore the sum changes if either does
+  return _x_axis->generation() + _y_axis->generation();
+}
+
 RangeOpt PointSeriesXY::getVisualizationRangeX()
 {
   return _cached_curve.rangeX();
@@ -1,12 +1,33 @@
 #ifndef POINT_SERIES_H
 #define POINT_SERIES_H
 
+#include <deque>
 #include "timeseries_qwt.h"
 
+/**
+ * @brief PointSeriesXY pairs the values of two timeseries sharing (approximately)
+ * the same time axis.
+ *
+ * Samples are joined by timestamp (see TimeMatching). The cache is updated
+ * incrementally, only the samples of Y newer than the last one processed are used:
+ * samples inserted out of order before it (by a source without a reorder window)
+ * are ignored until the cache is reset. The history of the sources is pinned (see
+ * PlotData::pinHistory).
+ */
 class PointSeriesXY : public QwtSeriesWrapper
 {
 public:
-  PointSeriesXY(const PlotData* x_axis, const PlotData* y_axis);
+  enum class TimeMatching
+  {
+    /// X must have a sample with the same time of Y: the constructor throws if it
+    /// does not. Samples received later without a match are skipped.
+    EXACT,
+    /// X is linearly interpolated at the time of Y.
+    INTERPOLATE
+  };
+
+  PointSeriesXY(const PlotData* x_axis, const PlotData* y_axis,
+                TimeMatching matching = TimeMatching::EXACT);
 
   virtual QPointF sample(size_t i) const override
   {
@@ -22,6 +43,8 @@ public:
 
   bool updateCache(bool reset_old_data) override;
 
+  uint64_t dataGeneration() const override;
+
   RangeOpt getVisualizationRangeX() override;
 
   const PlotData* dataX() const
@@ -33,10 +56,27 @@ public:
     return _y_axis;
   }
 
+  TimeMatching timeMatching() const
+  {
+    return _matching;
+  }
+
 protected:
   const PlotData* _x_axis;
   const PlotData* _y_axis;
+  std::shared_ptr<PlotData::HistoryPin> _x_pin;
+  std::shared_ptr<PlotData::HistoryPin> _y_pin;
+  TimeMatching _matching;
   PlotDataXY _cached_curve;
+  // timestamp of each point in _cached_curve
+  std::deque<double> _cached_time;
+  // timestamp of the last sample of _y_axis that was processed
+  double _last_time;
+  // PlotData::clearCount() of the sources when the cache was updated
+  uint64_t _x_clear_count = 0;
+  uint64_t _y_clear_count = 0;
+  // samples of Y without a sample of X at the same time (EXACT only)
+  size_t _unmatched_samples = 0;
 };
 
 #endif  // POINT_SERIES_H
@@ -36,6 +36,20 @@ PreferencesDialog::PreferencesDialog(QWidget* parent)
 
   bool use_opengl = settings.value("Preferences::use_opengl", true).toBool();
   ui->checkBoxOpenGL->setChecked(use_opengl);
+  bool async_rendering = settings.value("Preferences::async_rendering", false).toBool();
+  ui->checkBoxAsyncRendering->setChecked(async_rendering);
+
+  int max_fps = settings.value("Preferences::streaming_max_fps", 25).toInt();
+  ui->spinBoxMaxFPS->setValue(max_fps);
+
+  int cpu_budget = settings.value("Preferences::streaming_cpu_budget", 50).toInt();
+  ui->spinBoxCpuBudget->setValue(cpu_budget);
+
+  int memory_budget = settings.value("Preferences::memory_budget_mb", 0).toInt();
+  ui->spinBoxMemoryBudget->setValue(memory_budget);
+
+  bool compress_history = settings.value("Preferences::compress_history", false).toBool();
+  ui->checkBoxCompressHistory->setChecked(compress_history);
 
   //---------------
   auto custom_plugin_folders =
@@ -76,6 +90,13 @@ void PreferencesDialog::on_buttonBox_accepted()
                     ui->radioLocalColorIndex->isChecked());
   settings.setValue("Preferences::use_separator", ui->checkBoxSeparator->isChecked());
   settings.setValue("Preferences::use_opengl", ui->checkBoxOpenGL->isChecked());
+  settings.setValue("Preferences::async_rendering",
+                    ui->checkBoxAsyncRendering->isChecked());
+  settings.setValue("Preferences::streaming_max_fps", ui->spinBoxMaxFPS->value());
+  settings.setValue("Preferences::streaming_cpu_budget", ui->spinBoxCpuBudget->value());
+  settings.setValue("Preferences::memory_budget_mb", ui->spinBoxMemoryBudget->value());
+  settings.setValue("Preferences::compress_history",
+                    ui->checkBoxCompressHistory->isChecked());
 
   QStringList plugin_folders;
   for (int row = 0; row < ui->listWidgetCustom->count(); row++)
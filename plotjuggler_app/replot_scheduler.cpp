@@ -0,0 +1,136 @@
+#include "replot_scheduler.h"
+#include <algorithm>
+
+namespace
+{
+// weight of the last measurement in the moving average
+const double SMOOTHING = 0.2;
+// never refresh less than once per second, even if the budget is exceeded
+const int MAX_INTERVAL_MS = 1000;
+}  // namespace
+
+ReplotScheduler::ReplotScheduler(QObject* parent)
+  : QObject(parent)
+  , _timer(new QTimer(this))
+  , _frame_time(0)
+  , _budget(0.5)
+  , _min_interval(40)
+  , _interval(40)
+  , _pending_requests(0)
+  , _coalesced_requests(0)
+{
+  _stage_time.fill(0.0);
+  _timer->setSingleShot(true);
+  connect(_timer, &QTimer::timeout, this, &ReplotScheduler::frameRequested);
+}
+
+void ReplotScheduler::setCpuBudget(double budget)
+{
+  _budget = std::clamp(budget, 0.05, 1.0);
+}
+
+double ReplotScheduler::cpuBudget() const
+{
+  return _budget;
+}
+
+void ReplotScheduler::setMaximumFrameRate(double fps)
+{
+  fps = std::clamp(fps, 1.0, 100.0);
+  _min_interval = static_cast<int>(1000.0 / fps);
+  _interval = std::max(_interval, _min_interval);
+}
+
+double ReplotScheduler::maximumFrameRate() const
+{
+  return 1000.0 / _min_interval;
+}
+
+void ReplotScheduler::requestFrame()
+{
+  _pending_requests++;
+  if (!_timer->isActive())
+  {
+    _timer->start(_interval);
+  }
+}
+
+void ReplotScheduler::stop()
+{
+  _timer->stop();
+}
+
+bool ReplotScheduler::isPending() const
+{
+  return _timer->isActive();
+}
+
+void ReplotScheduler::beginFrame()
+{
+  _timer->stop();
+  _coalesced_requests = _pending_requests;
+  _pending_requests = 0;
+  _frame_clock.start();
+  _stage_clock.start();
+}
+
+void ReplotScheduler::endStage(Stage stage)
+{
+  if (!_stage_clock.isValid())
+  {
+    return;
+  }
+  const double elapsed = _stage_clock.nsecsElapsed() * 1e-6;
+  _stage_time[stage] = (1.0 - SMOOTHING) * _stage_time[stage] + SMOOTHING * elapsed;
+  _stage_clock.restart();
+}
+
+void ReplotScheduler::endFrame()
+{
+  if (!_frame_clock.isValid())
+  {
+    return;
+  }
+  const double elapsed = _frame_clock.nsecsElapsed() * 1e-6;
+  _frame_time = (1.0 - SMOOTHING) * _frame_time + SMOOTHING * elapsed;
+  _frame_clock.invalidate();
+  _stage_clock.invalidate();
+
+  // the GUI thread is idle while waiting for the next frame: keep the ratio
+  // between busy and total time below the budget.
+  const double idle_time = _frame_time * (1.0 - _budget) / _budget;
+  _interval = std::clamp(static_cast<int>(idle_time), _min_interval, MAX_INTERVAL_MS);
+}
+
+double ReplotScheduler::stageTime(Stage stage) const
+{
+  return _stage_time[stage];
+}
+
+double ReplotScheduler::frameTime() const
+{
+  return _frame_time;
+}
+
+int ReplotScheduler::interval() const
+{
+  return _interval;
+}
+
+unsigned ReplotScheduler::coalescedRequests() const
+{
+  return _coalesced_requests;
+}
+
+QString ReplotScheduler::statistics() const
+{
+  return QString("Refresh rate: %1 Hz\n"
+                 "Frame: %2 ms (ingestion %3 ms, transforms %4 ms, replot %5 ms)\n"
+                 "Updates merged into the last frame: %6")
+      .arg(1000.0 / _interval, 0, 'f', 1)
+      .arg(_frame_time, 0, 'f', 1)
+      .arg(_stage_time[INGESTION], 0, 'f', 1)
+      .arg(_stage_time[TRANSFORMS], 0, 'f', 1)
+      .arg(_stage_time[REPLOT], 0, 'f', 1)
+      .arg(_coalesced_requests);
+}
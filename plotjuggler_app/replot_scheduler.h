@@ -0,0 +1,92 @@
+#ifndef REPLOT_SCHEDULER_H
+#define REPLOT_SCHEDULER_H
+
+#include <array>
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QString>
+
+/**
+ * @brief ReplotScheduler decides when the next streaming frame is drawn.
+ *
+ * Multiple calls to requestFrame() are coalesced into a single frameRequested()
+ * signal. The time spent in each stage of a frame is measured and the refresh
+ * interval is adapted, so that updating the plots never uses more than a given
+ * share (the "CPU budget") of the GUI thread.
+ */
+class ReplotScheduler : public QObject
+{
+  Q_OBJECT
+
+public:
+  enum Stage
+  {
+    INGESTION = 0,
+    TRANSFORMS,
+    REPLOT,
+    STAGE_COUNT
+  };
+
+  explicit ReplotScheduler(QObject* parent = nullptr);
+
+  /// Share of the GUI thread, in the range (0, 1], used by streaming.
+  void setCpuBudget(double budget);
+
+  double cpuBudget() const;
+
+  void setMaximumFrameRate(double fps);
+
+  double maximumFrameRate() const;
+
+  /// Schedule a new frame. Requests received before the frame is drawn are merged.
+  void requestFrame();
+
+  void stop();
+
+  bool isPending() const;
+
+  /// Start measuring a new frame.
+  void beginFrame();
+
+  /// Time since beginFrame() or the previous endStage() is assigned to the stage.
+  void endStage(Stage stage);
+
+  /// Update the statistics and the interval used by the next requestFrame().
+  void endFrame();
+
+  /// Smoothed time spent in a stage, in milliseconds.
+  double stageTime(Stage stage) const;
+
+  /// Smoothed duration of an entire frame, in milliseconds.
+  double frameTime() const;
+
+  /// Current interval between frames, in milliseconds.
+  int interval() const;
+
+  /// Number of requests merged into the last frame.
+  unsigned coalescedRequests() const;
+
+  /// Human readable summary of the values above, shown to the user while streaming.
+  QString statistics() const;
+
+signals:
+  void frameRequested();
+
+private:
+  QTimer* _timer;
+  QElapsedTimer _frame_clock;
+  QElapsedTimer _stage_clock;
+
+  std::array<double, STAGE_COUNT> _stage_time;
+  double _frame_time;
+
+  double _budget;
+  int _min_interval;
+  int _interval;
+
+  unsigned _pending_requests;
+  unsigned _coalesced_requests;
+};
+
+#endif  // REPLOT_SCHEDULER_H
@@ -0,0 +1,255 @@
+#include "streaming_benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include "plotwidget.h"
+#include "timeseries_qwt.h"
+#include "utils.h"
+#include "PlotJuggler/fmt/format.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace
+{
+// Resident memory of the process, in bytes. Return 0 if not available.
+size_t ResidentMemory()
+{
+#ifdef __linux__
+  std::ifstream statm("/proc/self/statm");
+  size_t pages_total = 0;
+  size_t pages_resident = 0;
+  if (statm >> pages_total >> pages_resident)
+  {
+    return pages_resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  }
+#endif
+  return 0;
+}
+
+class LatencyStatistics
+{
+public:
+  void add(double value_ms)
+  {
+    _values.push_back(value_ms);
+  }
+
+  void print(std::ostream& out, const char* name)
+  {
+    if (_values.empty())
+    {
+      return;
+    }
+    std::sort(_values.begin(), _values.end());
+    double sum = 0;
+    for (double v : _values)
+    {
+      sum += v;
+    }
+    out << fmt::format("  {:<12} mean {:8.3f}  p50 {:8.3f}  p90 {:8.3f}  p99 {:8.3f}  "
+                       "max {:8.3f} ms\n",
+                       name, sum / _values.size(), percentile(0.5), percentile(0.9),
+                       percentile(0.99), _values.back());
+  }
+
+private:
+  double percentile(double p) const
+  {
+    const size_t index = static_cast<size_t>(p * (_values.size() - 1) + 0.5);
+    return _values[index];
+  }
+
+  std::vector<double> _values;
+};
+
+size_t RetainedSamples(const PlotDataMapRef& data)
+{
+  size_t count = 0;
+  for (const auto& it : data.numeric)
+  {
+    count += it.second.size();
+  }
+  for (const auto& it : data.strings)
+  {
+    count += it.second.size();
+  }
+  return count;
+}
+
+const char* PayloadName(StressGenerator::Payload payload)
+{
+  switch (payload)
+  {
+    case StressGenerator::NUMERIC:
+      return "numeric";
+    case StressGenerator::STRING:
+      return "string";
+    case StressGenerator::JSON:
+      return "json";
+  }
+  return "";
+}
+
+}  // namespace
+
+int RunStreamingBenchmark(const StreamingBenchmarkConfig& config, std::ostream& out)
+{
+  using namespace std::chrono;
+
+  PlotDataMapRef streamer_data;
+  PlotDataMapRef mapped_data;
+  std::mutex mutex;
+
+  const size_t memory_at_start = ResidentMemory();
+
+  StressGenerator generator(config.source, streamer_data, mutex);
+
+  // render() must paint the curves of the current frame, like the application does
+  // while streaming (see MainWindow::updateDataAndReplot)
+  PlotWidgetBase::setBackgroundRendering(false);
+
+  std::vector<std::unique_ptr<PlotWidget>> plots;
+  for (int i = 0; i < config.plots_count; i++)
+  {
+    auto plot = std::make_unique<PlotWidget>(mapped_data);
+    plot->widget()->resize(config.plot_width, config.plot_height);
+    plots.push_back(std::move(plot));
+  }
+  QImage image(config.plot_width, config.plot_height, QImage::Format_ARGB32);
+
+  LatencyStatistics ingestion_stats;
+  LatencyStatistics transforms_stats;
+  LatencyStatistics replot_stats;
+  LatencyStatistics frame_stats;
+
+  bool curves_added = false;
+  size_t frames = 0;
+  const auto frame_period =
+      duration_cast<steady_clock::duration>(duration<double>(1.0 / config.frame_rate));
+
+  generator.start();
+
+  QElapsedTimer total_clock;
+  total_clock.start();
+  QElapsedTimer stage_clock;
+  auto next_frame = steady_clock::now() + frame_period;
+
+  while (total_clock.elapsed() < config.duration * 1000)
+  {
+    std::this_thread::sleep_until(next_frame);
+    next_frame += frame_period;
+    QApplication::processEvents();
+
+    //-------- ingestion --------
+    stage_clock.start();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      MoveData(streamer_data, mapped_data, false);
+    }
+    mapped_data.setMaximumRangeX(config.buffer_size);
+    const double ingestion_time = stage_clock.nsecsElapsed() * 1e-6;
+
+    // curves are added once the series have been created by the first MoveData
+    if (!curves_added && !mapped_data.numeric.empty())
+    {
+      auto series_it = mapped_data.numeric.begin();
+      for (auto& plot : plots)
+      {
+        for (int c = 0; c < config.curves_per_plot; c++)
+        {
+          if (series_it == mapped_data.numeric.end())
+          {
+            series_it = mapped_data.numeric.begin();
+          }
+          auto curve_info = plot->addCurve(series_it->first);
+          // half of the curves are transformed, like a typical layout
+          auto ts = curve_info ? dynamic_cast<TransformedTimeseries*>(
+                                     curve_info->curve->data()) :
+                                 nullptr;
+          if (ts && c % 2 == 1)
+          {
+            ts->setTransform("Derivative");
+          }
+          series_it++;
+        }
+      }
+      curves_added = true;
+    }
+
+    //-------- transforms --------
+    stage_clock.restart();
+    std::vector<PlotWidget*> updated_plots;
+    for (auto& plot : plots)
+    {
+      if (plot->updateCurves(false))
+      {
+        updated_plots.push_back(plot.get());
+      }
+    }
+    const double transforms_time = stage_clock.nsecsElapsed() * 1e-6;
+
+    //-------- replot --------
+    stage_clock.restart();
+    for (auto plot : updated_plots)
+    {
+      plot->zoomOut(false);
+      plot->widget()->render(&image);
+    }
+    const double replot_time = stage_clock.nsecsElapsed() * 1e-6;
+
+    ingestion_stats.add(ingestion_time);
+    transforms_stats.add(transforms_time);
+    replot_stats.add(replot_time);
+    frame_stats.add(ingestion_time + transforms_time + replot_time);
+    frames++;
+  }
+
+  generator.stop();
+  const double elapsed = total_clock.nsecsElapsed() * 1e-9;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    MoveData(streamer_data, mapped_data, false);
+  }
+  mapped_data.setMaximumRangeX(config.buffer_size);
+
+  const size_t samples = generator.samplesCount();
+  const size_t retained = RetainedSamples(mapped_data);
+  const size_t memory_at_end = ResidentMemory();
+
+  out << "---------- streaming benchmark ----------\n";
+  out << fmt::format("  source:      {} series x {} Hz, payload: {}\n",
+                     config.source.series_count, config.source.rate,
+                     PayloadName(config.source.payload));
+  out << fmt::format("  plots:       {} x {} curves, {}x{} pixels\n", config.plots_count,
+                     config.curves_per_plot, config.plot_width, config.plot_height);
+  out << fmt::format("  duration:    {:.2f} s, {} frames ({:.1f} fps)\n", elapsed, frames,
+                     frames / elapsed);
+  out << fmt::format("  throughput:  {:.0f} samples/s ({:.0f} requested)\n",
+                     samples / elapsed,
+                     config.source.rate * generator.samplesCount() /
+                         std::max<size_t>(1, generator.cyclesCount()));
+  out << "latency per frame:\n";
+  ingestion_stats.print(out, "MoveData");
+  transforms_stats.print(out, "transforms");
+  replot_stats.print(out, "replot");
+  frame_stats.print(out, "total");
+
+  out << "memory:\n";
+  out << fmt::format("  retained:    {} samples\n", retained);
+  if (memory_at_start > 0 && retained > 0)
+  {
+    const double delta =
+        double(memory_at_end) - double(std::min(memory_at_start, memory_at_end));
+    out << fmt::format("  resident:    {:.1f} MB ({:.1f} bytes per sample)\n",
+                       memory_at_end / (1024.0 * 1024.0), delta / retained);
+  }
+  out << std::flush;
+  return 0;
+}
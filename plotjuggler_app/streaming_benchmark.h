@@ -0,0 +1,34 @@
+#ifndef STREAMING_BENCHMARK_H
+#define STREAMING_BENCHMARK_H
+
+#include <ostream>
+#include "stress_generator.h"
+
+struct StreamingBenchmarkConfig
+{
+  StressGenerator::Config source;
+  // duration of the measurement, in seconds
+  double duration = 10;
+  // size of the streaming buffer, in seconds
+  double buffer_size = 60;
+  double frame_rate = 25;
+  int plots_count = 4;
+  int curves_per_plot = 4;
+  // size of the plots rendered offscreen, in pixels
+  int plot_width = 800;
+  int plot_height = 400;
+};
+
+/**
+ * Run the whole streaming pipeline without the main window:
+ *
+ * StressGenerator (separate thread) -> MoveData -> transforms -> replot
+ *
+ * Plots are rendered into an image. At the end, ingestion throughput, latency
+ * percentiles of each stage and memory per sample are written to the stream.
+ *
+ * @return 0 on success
+ */
+int RunStreamingBenchmark(const StreamingBenchmarkConfig& config, std::ostream& out);
+
+#endif  // STREAMING_BENCHMARK_H
@@ -0,0 +1,195 @@
+#include "stress_generator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "nlohmann_parsers.h"
+#include "PlotJuggler/fmt/format.h"
+
+using namespace PJ;
+
+namespace
+{
+// number of numeric fields in each JSON message
+const size_t JSON_FIELDS_PER_TOPIC = 10;
+// maximum number of cycles pushed while the mutex is locked
+const int MAX_BURST = 100;
+
+double Random(double range)
+{
+  return range * ((double)rand() / (double)RAND_MAX);
+}
+}  // namespace
+
+StressGenerator::StressGenerator(const Config& config, PlotDataMapRef& data,
+                                 std::mutex& mutex)
+  : _config(config), _data(data), _mutex(mutex), _running(false), _samples(0), _cycles(0)
+{
+  _config.series_count = std::max<size_t>(1, _config.series_count);
+  _config.rate = std::max(1.0, _config.rate);
+
+  for (size_t i = 0; i < _config.series_count; i++)
+  {
+    _parameters.push_back({ Random(6) - 3, Random(3), Random(3), Random(20) });
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  switch (_config.payload)
+  {
+    case NUMERIC:
+      for (size_t i = 0; i < _config.series_count; i++)
+      {
+        auto name = fmt::format("stress/numeric/{}", i);
+        _numeric.push_back(&_data.addNumeric(name)->second);
+      }
+      break;
+    case STRING:
+      for (size_t i = 0; i < _config.series_count; i++)
+      {
+        auto name = fmt::format("stress/string/{}", i);
+        _strings.push_back(&_data.addStringSeries(name)->second);
+      }
+      break;
+    case JSON: {
+      const size_t topics =
+          (_config.series_count + JSON_FIELDS_PER_TOPIC - 1) / JSON_FIELDS_PER_TOPIC;
+      for (size_t i = 0; i < topics; i++)
+      {
+        auto topic = fmt::format("stress/json/{}", i);
+        _parsers.push_back(std::make_shared<JSON_Parser>(topic, _data, false));
+      }
+    }
+    break;
+  }
+}
+
+StressGenerator::~StressGenerator()
+{
+  stop();
+}
+
+bool StressGenerator::parsePayload(const QString& name, Payload& payload)
+{
+  const QString lower = name.toLower();
+  if (lower == "numeric")
+  {
+    payload = NUMERIC;
+  }
+  else if (lower == "string")
+  {
+    payload = STRING;
+  }
+  else if (lower == "json")
+  {
+    payload = JSON;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+void StressGenerator::pushSingleCycle(double timestamp)
+{
+  const size_t cycle = _cycles;
+  const char* states[] = { "IDLE", "RUNNING", "WARNING", "ERROR" };
+
+  auto value = [&](size_t index) {
+    const Parameters& p = _parameters[index];
+    return p.A * std::sin(p.B * timestamp + p.C) + p.D;
+  };
+
+  switch (_config.payload)
+  {
+    case NUMERIC:
+      for (size_t i = 0; i < _numeric.size(); i++)
+      {
+        _numeric[i]->pushBack({ timestamp, value(i) });
+      }
+      _samples += _numeric.size();
+      break;
+
+    case STRING:
+      for (size_t i = 0; i < _strings.size(); i++)
+      {
+        // change state every 10 cycles; few distinct values, like most enums
+        _strings[i]->pushBack({ timestamp, states[((cycle / 10) + i) % 4] });
+      }
+      _samples += _strings.size();
+      break;
+
+    case JSON:
+      for (size_t t = 0; t < _parsers.size(); t++)
+      {
+        nlohmann::json msg;
+        msg["header"]["seq"] = cycle;
+        const size_t first = t * JSON_FIELDS_PER_TOPIC;
+        const size_t last = std::min(first + JSON_FIELDS_PER_TOPIC, _config.series_count);
+        for (size_t i = first; i < last; i++)
+        {
+          msg["data"][fmt::format("field_{}", i - first)] = value(i);
+        }
+        const std::string str = msg.dump();
+        _buffer.assign(str.begin(), str.end());
+
+        double stamp = timestamp;
+        _parsers[t]->parseMessage(MessageRef(_buffer), stamp);
+        _samples += 1 + (last - first);
+      }
+      break;
+  }
+  _cycles++;
+}
+
+void StressGenerator::start()
+{
+  stop();
+  _running = true;
+  _thread = std::thread([this]() { this->loop(); });
+}
+
+void StressGenerator::stop()
+{
+  _running = false;
+  if (_thread.joinable())
+  {
+    _thread.join();
+  }
+}
+
+size_t StressGenerator::samplesCount() const
+{
+  return _samples;
+}
+
+size_t StressGenerator::cyclesCount() const
+{
+  return _cycles;
+}
+
+void StressGenerator::loop()
+{
+  using namespace std::chrono;
+  const auto period = duration_cast<high_resolution_clock::duration>(
+      duration<double>(1.0 / _config.rate));
+  const auto initial_time = high_resolution_clock::now();
+  auto next_cycle = initial_time;
+
+  while (_running)
+  {
+    // if the generator falls behind, the missing cycles are pushed in a burst,
+    // to keep the requested rate on average. The burst is limited, to avoid
+    // keeping the mutex locked for too long.
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      const auto now = high_resolution_clock::now();
+      for (int burst = 0; burst < MAX_BURST && next_cycle <= now; burst++)
+      {
+        const double stamp = duration<double>(next_cycle - initial_time).count();
+        pushSingleCycle(stamp);
+        next_cycle += period;
+      }
+    }
+    std::this_thread::sleep_until(next_cycle);
+  }
+}
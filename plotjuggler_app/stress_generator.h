@@ -0,0 +1,80 @@
+#ifndef STRESS_GENERATOR_H
+#define STRESS_GENERATOR_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <QString>
+#include "PlotJuggler/messageparser_base.h"
+
+/**
+ * @brief StressGenerator produces synthetic data at a configurable rate, to
+ * reproduce the load of a real streaming source.
+ *
+ * Each cycle pushes one sample into every series. Depending on the payload,
+ * samples are numbers, strings or JSON messages that are serialized and then
+ * decoded by the builtin JSON parser, exactly like a streamer would do.
+ */
+class StressGenerator
+{
+public:
+  enum Payload
+  {
+    NUMERIC,
+    STRING,
+    JSON
+  };
+
+  struct Config
+  {
+    size_t series_count = 100;
+    double rate = 100;  // Hz
+    Payload payload = NUMERIC;
+  };
+
+  StressGenerator(const Config& config, PJ::PlotDataMapRef& data, std::mutex& mutex);
+
+  ~StressGenerator();
+
+  static bool parsePayload(const QString& name, Payload& payload);
+
+  /// Push a single sample in each series. The mutex must be locked by the caller.
+  void pushSingleCycle(double timestamp);
+
+  /// Generate data in a separate thread, until stop() is called.
+  void start();
+
+  void stop();
+
+  /// Total number of samples pushed so far (a JSON message counts as many samples as
+  /// its numeric fields).
+  size_t samplesCount() const;
+
+  size_t cyclesCount() const;
+
+private:
+  void loop();
+
+  Config _config;
+  PJ::PlotDataMapRef& _data;
+  std::mutex& _mutex;
+
+  struct Parameters
+  {
+    double A, B, C, D;
+  };
+  std::vector<Parameters> _parameters;
+  std::vector<PJ::PlotData*> _numeric;
+  std::vector<PJ::StringSeries*> _strings;
+  std::vector<std::shared_ptr<PJ::MessageParser>> _parsers;
+  std::vector<uint8_t> _buffer;
+
+  std::thread _thread;
+  std::atomic_bool _running;
+  std::atomic<size_t> _samples;
+  std::atomic<size_t> _cycles;
+};
+
+#endif  // STRESS_GENERATOR_H
@@ -195,16 +195,30 @@ bool TabbedPlotWidget::xmlLoadState(QDomElement& tabbed_area)
 {
   int prev_count = tabWidget()->count();
 
+  QDomElement current_tab = tabbed_area.firstChildElement("currentTabIndex");
+  int current_index = current_tab.attribute("index").toInt();
+
+  // the plots of the other tabs are created when they are shown (see
+  // on_tabWidget_currentChanged)
+  _loading_state = true;
+  int index = 0;
   for (auto docker_elem = tabbed_area.firstChildElement("Tab"); !docker_elem.isNull();
-       docker_elem = docker_elem.nextSiblingElement("Tab"))
+       docker_elem = docker_elem.nextSiblingElement("Tab"), index++)
   {
     QString tab_name = docker_elem.attribute("tab_name");
     PlotDocker* docker = addTab(tab_name);
 
+    if (index != current_index)
+    {
+      docker->setDeferredState(docker_elem);
+      continue;
+    }
+
     bool success = docker->xmlLoadState(docker_elem);
 
     if (!success)
     {
+      _loading_state = false;
       return false;
     }
   }
@@ -214,14 +228,17 @@ bool TabbedPlotWidget::xmlLoadState(QDomElement& tabbed_area)
   {
     tabWidget()->removeTab(0);
   }
-
-  QDomElement current_tab = tabbed_area.firstChildElement("currentTabIndex");
-  int current_index = current_tab.attribute("index").toInt();
+  _loading_state = false;
 
   if (current_index >= 0 && current_index < tabWidget()->count())
   {
     tabWidget()->setCurrentIndex(current_index);
   }
+  // if current_index was not valid, the current tab may be a deferred one
+  if (auto docker = currentTab())
+  {
+    docker->materialize();
+  }
 
   emit undoableChange();
   return true;
@@ -278,6 +295,10 @@ void TabbedPlotWidget::on_tabWidget_currentChanged(int index)
   PlotDocker* tab = dynamic_cast<PlotDocker*>(tabWidget()->widget(index));
   if (tab)
   {
+    if (!_loading_state)
+    {
+      tab->materialize();
+    }
     tab->replot();
   }
   for (int i = 0; i < tabWidget()->count(); i++)
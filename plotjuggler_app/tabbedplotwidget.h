@@ -95,6 +95,9 @@ private:
 
   QString _parent_type;
 
+  // true while xmlLoadState() adds the tabs
+  bool _loading_state = false;
+
   virtual void closeEvent(QCloseEvent* event) override;
 
   // void printPlotsNames();
@@ -1,10 +1,21 @@
 #include "custom_function.h"
 
+#include <algorithm>
 #include <limits>
 #include <QFile>
 #include <QMessageBox>
 #include <QElapsedTimer>
 #include "lua_custom_function.h"
+#include "expression_custom_function.h"
+
+CustomPlotPtr CreateCustomFunction(const SnippetData& snippet)
+{
+  if (ExpressionCustomFunction::isSupported(snippet))
+  {
+    return std::make_shared<ExpressionCustomFunction>(snippet);
+  }
+  return std::make_shared<LuaCustomFunction>(snippet);
+}
 
 CustomFunction::CustomFunction(SnippetData snippet)
 {
@@ -70,49 +81,135 @@ void CustomFunction::calculate()
 {
   auto dst_data = _dst_vector.front();
 
-  auto data_it = plotData()->numeric.find(_linked_plot_name);
-  if (data_it == plotData()->numeric.end())
+  if (!updateSources(true))
   {
     // failed! keep it empty
     return;
   }
-  _src_vector.clear();
-  _src_vector.push_back(&data_it->second);
+  const PlotData* main_data_source = _src_vector.front();
 
-  for (const auto& channel : _used_channels)
+  // clean up old data
+  dst_data->setMaximumRangeX(main_data_source->maximumRangeX());
+
+  double last_updated_stamp = -std::numeric_limits<double>::max();
+  if (dst_data->size() != 0)
   {
-    auto it = plotData()->numeric.find(channel);
-    if (it == plotData()->numeric.end())
+    last_updated_stamp = dst_data->back().x;
+  }
+
+  // first point newer than last_updated_stamp (the points are sorted by time)
+  size_t first = 0;
+  size_t count = main_data_source->size();
+  while (count > 0)
+  {
+    const size_t step = count / 2;
+    if (main_data_source->at(first + step).x <= last_updated_stamp)
     {
-      throw std::runtime_error("Invalid channel name");
+      first += step + 1;
+      count -= step + 1;
+    }
+    else
+    {
+      count = step;
     }
-    const PlotData* chan_data = &(it->second);
-    _src_vector.push_back(chan_data);
   }
 
-  const PlotData* main_data_source = _src_vector.front();
+  calculateRange(_src_vector, first, main_data_source->size(), 1, *dst_data);
+}
 
-  // clean up old data
+bool CustomFunction::calculateDecimated(size_t stride,
+                                        const std::function<bool()>& cancelled)
+{
+  auto dst_data = _dst_vector.front();
+
+  // called in background by the preview of FunctionEditorWidget
+  if (!updateSources(false))
+  {
+    return true;
+  }
+  const PlotData* main_data_source = _src_vector.front();
   dst_data->setMaximumRangeX(main_data_source->maximumRangeX());
 
-  double last_updated_stamp = -std::numeric_limits<double>::max();
+  // first sample newer than the last point computed
+  size_t start = 0;
   if (dst_data->size() != 0)
   {
-    last_updated_stamp = dst_data->back().x;
+    const double last_updated_stamp = dst_data->back().x;
+    auto it = std::upper_bound(
+        main_data_source->begin(), main_data_source->end(), last_updated_stamp,
+        [](double t, const PlotData::Point& p) { return t < p.x; });
+    start = std::distance(main_data_source->begin(), it);
   }
 
-  std::vector<PlotData::Point> points;
-  for (size_t i = 0; i < main_data_source->size(); ++i)
+  // check "cancelled" every CHUNK samples evaluated
+  const size_t CHUNK = 10000;
+  const size_t size = main_data_source->size();
+
+  for (size_t first = start; first < size; first += CHUNK * stride)
   {
-    if (main_data_source->at(i).x > last_updated_stamp)
+    if (cancelled())
+    {
+      return false;
+    }
+    const size_t last = std::min(size, first + CHUNK * stride);
+    calculateRange(_src_vector, first, last, stride, *dst_data);
+  }
+  return true;
+}
+
+bool CustomFunction::updateSources(bool pin_history)
+{
+  auto data_it = plotData()->numeric.find(_linked_plot_name);
+  if (data_it == plotData()->numeric.end())
+  {
+    return false;
+  }
+  std::vector<PlotData*> sources = { &data_it->second };
+
+  for (const auto& channel : _used_channels)
+  {
+    auto it = plotData()->numeric.find(channel);
+    if (it == plotData()->numeric.end())
     {
-      points.clear();
-      calculatePoints(_src_vector, i, points);
+      throw std::runtime_error("Invalid channel name");
+    }
+    sources.push_back(&it->second);
+  }
 
-      for (PlotData::Point const& point : points)
+  _src_vector.assign(sources.begin(), sources.end());
+  if (pin_history)
+  {
+    if (_pinned_sources != _src_vector)
+    {
+      _source_pins.clear();
+      for (const PlotData* source : _src_vector)
       {
-        dst_data->pushBack(point);
+        _source_pins.push_back(source->pinHistory());
       }
+      _pinned_sources = _src_vector;
+    }
+    // compressed before this function was created
+    for (PlotData* source : sources)
+    {
+      source->restoreHistory();
+    }
+  }
+  return true;
+}
+
+void CustomFunction::calculateRange(const std::vector<const PlotData*>& src_data,
+                                    size_t first, size_t last, size_t stride,
+                                    PlotData& dst_data)
+{
+  std::vector<PlotData::Point> points;
+  for (size_t i = first; i < last; i += stride)
+  {
+    points.clear();
+    calculatePoints(src_data, i, points);
+
+    for (PlotData::Point const& point : points)
+    {
+      dst_data.pushBack(point);
     }
   }
 }
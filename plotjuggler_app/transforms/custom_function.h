@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -37,6 +38,10 @@ QDomElement ExportSnippetToXML(const SnippetData& snippet, QDomDocument& destina
 
 QDomElement ExportSnippets(const SnippetsMap& snippets, QDomDocument& destination_doc);
 
+/// Uses ExpressionCustomFunction when the snippet is a simple expression, otherwise
+/// LuaCustomFunction.
+CustomPlotPtr CreateCustomFunction(const SnippetData& snippet);
+
 class CustomFunction : public PJ::TransformFunction
 {
 public:
@@ -63,6 +68,12 @@ public:
 
   void calculate() override;
 
+  /// Like calculate(), but only for one sample every "stride" of the linked source.
+  /// Used to preview the result progressively: returns false, leaving the result
+  /// incomplete, as soon as "cancelled" returns true. Like calculate(), it continues
+  /// after the last point of the destination.
+  bool calculateDecimated(size_t stride, const std::function<bool()>& cancelled);
+
   bool xmlSaveState(QDomDocument& doc, QDomElement& parent_element) const override;
 
   bool xmlLoadState(const QDomElement& parent_element) override;
@@ -79,10 +90,25 @@ public:
                                size_t point_index,
                                std::vector<PlotData::Point>& new_points) = 0;
 
+  /// Adds to dst_data the points computed from the samples first, first + stride...
+  /// of the linked source, up to last (excluded). By default, calls calculatePoints()
+  /// for each of them.
+  virtual void calculateRange(const std::vector<const PlotData*>& src_data,
+                              size_t first, size_t last, size_t stride,
+                              PlotData& dst_data);
+
 protected:
+  // set _src_vector; false if the linked source doesn't exist.
+  // If pin_history, the history of the sources is pinned and restored (see
+  // PlotData::pinHistory): it modifies them, only in the GUI thread.
+  bool updateSources(bool pin_history);
+
   SnippetData _snippet;
   std::string _linked_plot_name;
   std::string _plot_name;
 
   std::vector<std::string> _used_channels;
+
+  std::vector<const PlotData*> _pinned_sources;
+  std::vector<std::shared_ptr<PlotData::HistoryPin>> _source_pins;
 };
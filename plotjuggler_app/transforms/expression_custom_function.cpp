@@ -0,0 +1,817 @@
+#include "expression_custom_function.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <QByteArray>
+#include "PlotJuggler/series_join.h"
+
+namespace
+{
+enum class Op
+{
+  Add,
+  Sub,
+  Mul,
+  Div,
+  FloorDiv,
+  Mod,
+  Pow,
+  Neg,
+  Abs,
+  Ceil,
+  Floor,
+  Sqrt,
+  Exp,
+  Log,
+  LogBase,
+  Sin,
+  Cos,
+  Tan,
+  Asin,
+  Acos,
+  Atan,
+  Atan2,
+  Fmod,
+  Deg,
+  Rad,
+  Min,
+  Max
+};
+
+const double kPi = 3.141592653589793238462643383279502884;
+
+template <typename Function>
+void Map(double* dst, const double* a, const double* b, size_t count, Function function)
+{
+  for (size_t k = 0; k < count; k++)
+  {
+    dst[k] = function(a[k], b[k]);
+  }
+}
+
+// Same arithmetic of Lua 5.4 (see luai_nummod, luai_numpow and lmathlib.c).
+// The unary operations ignore "b".
+void Execute(Op op, double* dst, const double* a, const double* b, size_t count)
+{
+  switch (op)
+  {
+    case Op::Add:
+      return Map(dst, a, b, count, [](double x, double y) { return x + y; });
+    case Op::Sub:
+      return Map(dst, a, b, count, [](double x, double y) { return x - y; });
+    case Op::Mul:
+      return Map(dst, a, b, count, [](double x, double y) { return x * y; });
+    case Op::Div:
+      return Map(dst, a, b, count, [](double x, double y) { return x / y; });
+    case Op::FloorDiv:
+      return Map(dst, a, b, count,
+                 [](double x, double y) { return std::floor(x / y); });
+    case Op::Mod:
+      return Map(dst, a, b, count, [](double x, double y) {
+        double m = std::fmod(x, y);
+        if ((m > 0) ? y < 0 : (m < 0 && y > 0))
+        {
+          m += y;
+        }
+        return m;
+      });
+    case Op::Pow:
+      return Map(dst, a, b, count,
+                 [](double x, double y) { return (y == 2) ? x * x : std::pow(x, y); });
+    case Op::Neg:
+      return Map(dst, a, b, count, [](double x, double) { return -x; });
+    case Op::Abs:
+      return Map(dst, a, b, count, [](double x, double) { return std::fabs(x); });
+    case Op::Ceil:
+      return Map(dst, a, b, count, [](double x, double) { return std::ceil(x); });
+    case Op::Floor:
+      return Map(dst, a, b, count, [](double x, double) { return std::floor(x); });
+    case Op::Sqrt:
+      return Map(dst, a, b, count, [](double x, double) { return std::sqrt(x); });
+    case Op::Exp:
+      return Map(dst, a, b, count, [](double x, double) { return std::exp(x); });
+    case Op::Log:
+      return Map(dst, a, b, count, [](double x, double) { return std::log(x); });
+    case Op::LogBase:
+      return Map(dst, a, b, count, [](double x, double base) {
+        if (base == 2.0)
+        {
+          return std::log2(x);
+        }
+        if (base == 10.0)
+        {
+          return std::log10(x);
+        }
+        return std::log(x) / std::log(base);
+      });
+    case Op::Sin:
+      return Map(dst, a, b, count, [](double x, double) { return std::sin(x); });
+    case Op::Cos:
+      return Map(dst, a, b, count, [](double x, double) { return std::cos(x); });
+    case Op::Tan:
+      return Map(dst, a, b, count, [](double x, double) { return std::tan(x); });
+    case Op::Asin:
+      return Map(dst, a, b, count, [](double x, double) { return std::asin(x); });
+    case Op::Acos:
+      return Map(dst, a, b, count, [](double x, double) { return std::acos(x); });
+    case Op::Atan:
+      return Map(dst, a, b, count, [](double x, double) { return std::atan2(x, 1.0); });
+    case Op::Atan2:
+      return Map(dst, a, b, count, [](double y, double x) { return std::atan2(y, x); });
+    case Op::Fmod:
+      return Map(dst, a, b, count, [](double x, double y) { return std::fmod(x, y); });
+    case Op::Deg:
+      return Map(dst, a, b, count, [](double x, double) { return x * (180.0 / kPi); });
+    case Op::Rad:
+      return Map(dst, a, b, count, [](double x, double) { return x * (kPi / 180.0); });
+    case Op::Min:
+      return Map(dst, a, b, count, [](double x, double y) { return (y < x) ? y : x; });
+    case Op::Max:
+      return Map(dst, a, b, count, [](double x, double y) { return (x < y) ? y : x; });
+  }
+}
+
+struct MathFunction
+{
+  const char* name;
+  // operation used with one and with two arguments
+  std::optional<Op> unary;
+  std::optional<Op> binary;
+  // any number of arguments, applying "binary" from left to right
+  bool variadic = false;
+};
+
+const MathFunction kMathFunctions[] = {
+  { "abs", Op::Abs, {} },         { "ceil", Op::Ceil, {} },
+  { "floor", Op::Floor, {} },     { "sqrt", Op::Sqrt, {} },
+  { "exp", Op::Exp, {} },         { "log", Op::Log, Op::LogBase },
+  { "sin", Op::Sin, {} },         { "cos", Op::Cos, {} },
+  { "tan", Op::Tan, {} },         { "asin", Op::Asin, {} },
+  { "acos", Op::Acos, {} },       { "atan", Op::Atan, Op::Atan2 },
+  { "fmod", {}, Op::Fmod },       { "deg", Op::Deg, {} },
+  { "rad", Op::Rad, {} },         { "min", {}, Op::Min, true },
+  { "max", {}, Op::Max, true },
+};
+
+//---------------------------------------------------
+struct Token
+{
+  enum Type
+  {
+    NUMBER,
+    NAME,
+    SYMBOL,
+    END
+  };
+  Type type = END;
+  std::string text;
+  double number = 0;
+};
+
+// Returns false if the text contains something that is not supported.
+bool Tokenize(const std::string& text, std::vector<Token>& tokens)
+{
+  auto is_digit = [](char c) { return std::isdigit(static_cast<unsigned char>(c)); };
+  auto is_alnum = [](char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+  };
+
+  size_t i = 0;
+  while (i < text.size())
+  {
+    const char c = text[i];
+    if (std::isspace(static_cast<unsigned char>(c)))
+    {
+      i++;
+    }
+    else if (text.compare(i, 2, "--") == 0)
+    {
+      // long comments, "--[[ ... ]]", are not supported
+      if (text.compare(i + 2, 1, "[") == 0)
+      {
+        return false;
+      }
+      i = text.find('\n', i);
+      if (i == std::string::npos)
+      {
+        break;
+      }
+    }
+    else if (is_digit(c) || (c == '.' && i + 1 < text.size() && is_digit(text[i + 1])))
+    {
+      // same characters consumed by the Lua lexer
+      size_t end = i;
+      while (end < text.size() &&
+             (is_alnum(text[end]) || text[end] == '.' ||
+              ((text[end] == '+' || text[end] == '-') &&
+               (text[end - 1] == 'e' || text[end - 1] == 'E'))))
+      {
+        end++;
+      }
+      Token token;
+      token.type = Token::NUMBER;
+      token.text = text.substr(i, end - i);
+      // hexadecimal numbers are not supported
+      if (token.text.find_first_of("xX") != std::string::npos)
+      {
+        return false;
+      }
+      bool ok = false;
+      token.number = QByteArray::fromStdString(token.text).toDouble(&ok);
+      if (!ok)
+      {
+        return false;
+      }
+      tokens.push_back(token);
+      i = end;
+    }
+    else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_')
+    {
+      size_t end = i;
+      while (end < text.size() && is_alnum(text[end]))
+      {
+        end++;
+      }
+      Token token;
+      token.type = Token::NAME;
+      token.text = text.substr(i, end - i);
+      tokens.push_back(token);
+      i = end;
+    }
+    else
+    {
+      Token token;
+      token.type = Token::SYMBOL;
+      if (text.compare(i, 2, "//") == 0)
+      {
+        token.text = "//";
+      }
+      else if (std::string("+-*/%^(),.;").find(c) != std::string::npos)
+      {
+        token.text = std::string(1, c);
+      }
+      else
+      {
+        return false;
+      }
+      tokens.push_back(token);
+      i += token.text.size();
+    }
+  }
+  tokens.push_back(Token());
+  return true;
+}
+
+//---------------------------------------------------
+struct Node;
+using NodePtr = std::unique_ptr<Node>;
+
+struct Node
+{
+  enum Kind
+  {
+    NUMBER,
+    INPUT,
+    OPERATION
+  };
+  Kind kind = NUMBER;
+  double number = 0;
+  // register of the input
+  int input = 0;
+  Op op = Op::Add;
+  std::vector<NodePtr> args;
+};
+
+NodePtr MakeNumber(double number)
+{
+  auto node = std::make_unique<Node>();
+  node->kind = Node::NUMBER;
+  node->number = number;
+  return node;
+}
+
+// The operations on constants are computed here.
+NodePtr MakeOperation(Op op, std::vector<NodePtr> args)
+{
+  bool constant = true;
+  for (const auto& arg : args)
+  {
+    if (!arg)
+    {
+      return nullptr;
+    }
+    constant = constant && arg->kind == Node::NUMBER;
+  }
+  if (constant)
+  {
+    double result;
+    Execute(op, &result, &args.front()->number, &args.back()->number, 1);
+    return MakeNumber(result);
+  }
+  auto node = std::make_unique<Node>();
+  node->kind = Node::OPERATION;
+  node->op = op;
+  node->args = std::move(args);
+  return node;
+}
+
+NodePtr MakeOperation(Op op, NodePtr a)
+{
+  std::vector<NodePtr> args;
+  args.push_back(std::move(a));
+  return MakeOperation(op, std::move(args));
+}
+
+NodePtr MakeOperation(Op op, NodePtr a, NodePtr b)
+{
+  std::vector<NodePtr> args;
+  args.push_back(std::move(a));
+  args.push_back(std::move(b));
+  return MakeOperation(op, std::move(args));
+}
+
+/**
+ * Recursive descent parser of the body of the Lua function
+ *
+ *   function calc(time, value, v1, v2, ...)
+ *
+ * with the same precedence and associativity of the operators. Any method returns
+ * nullptr (or false) if the text is not supported.
+ */
+class Parser
+{
+public:
+  Parser(std::vector<Token> tokens, int num_sources)
+    : _tokens(std::move(tokens)), _num_sources(num_sources)
+  {
+  }
+
+  // return exp [, exp] [;]
+  bool parseReturn(std::vector<NodePtr>& results)
+  {
+    if (!acceptName("return"))
+    {
+      return false;
+    }
+    do
+    {
+      auto expression = parseExpression();
+      if (!expression)
+      {
+        return false;
+      }
+      results.push_back(std::move(expression));
+    } while (acceptSymbol(","));
+
+    acceptSymbol(";");
+    return current().type == Token::END && results.size() <= 2;
+  }
+
+private:
+  // the END token after the last one
+  const Token& current() const
+  {
+    static const Token end_token;
+    return (_pos < _tokens.size()) ? _tokens[_pos] : end_token;
+  }
+
+  bool acceptSymbol(const char* symbol)
+  {
+    if (current().type == Token::SYMBOL && current().text == symbol)
+    {
+      _pos++;
+      return true;
+    }
+    return false;
+  }
+
+  bool acceptName(const char* name)
+  {
+    if (current().type == Token::NAME && current().text == name)
+    {
+      _pos++;
+      return true;
+    }
+    return false;
+  }
+
+  // + and -, left associative
+  NodePtr parseExpression()
+  {
+    auto node = parseTerm();
+    while (node)
+    {
+      if (acceptSymbol("+"))
+      {
+        node = MakeOperation(Op::Add, std::move(node), parseTerm());
+      }
+      else if (acceptSymbol("-"))
+      {
+        node = MakeOperation(Op::Sub, std::move(node), parseTerm());
+      }
+      else
+      {
+        break;
+      }
+    }
+    return node;
+  }
+
+  // * / // %, left associative
+  NodePtr parseTerm()
+  {
+    auto node = parseUnary();
+    while (node)
+    {
+      std::optional<Op> op;
+      if (acceptSymbol("*"))
+      {
+        op = Op::Mul;
+      }
+      else if (acceptSymbol("/"))
+      {
+        op = Op::Div;
+      }
+      else if (acceptSymbol("//"))
+      {
+        op = Op::FloorDiv;
+      }
+      else if (acceptSymbol("%"))
+      {
+        op = Op::Mod;
+      }
+      else
+      {
+        break;
+      }
+      node = MakeOperation(*op, std::move(node), parseUnary());
+    }
+    return node;
+  }
+
+  // "-x^2" is "-(x^2)"
+  NodePtr parseUnary()
+  {
+    if (acceptSymbol("-"))
+    {
+      return MakeOperation(Op::Neg, parseUnary());
+    }
+    return parsePower();
+  }
+
+  // right associative: "a^b^c" is "a^(b^c)" and "a^-b" is valid
+  NodePtr parsePower()
+  {
+    auto node = parsePrimary();
+    if (node && acceptSymbol("^"))
+    {
+      node = MakeOperation(Op::Pow, std::move(node), parseUnary());
+    }
+    return node;
+  }
+
+  NodePtr parsePrimary()
+  {
+    const Token token = current();
+    if (token.type == Token::END)
+    {
+      return nullptr;
+    }
+    _pos++;
+
+    if (token.type == Token::NUMBER)
+    {
+      return MakeNumber(token.number);
+    }
+    if (token.type == Token::SYMBOL && token.text == "(")
+    {
+      auto node = parseExpression();
+      if (!acceptSymbol(")"))
+      {
+        return nullptr;
+      }
+      return node;
+    }
+    if (token.type != Token::NAME)
+    {
+      return nullptr;
+    }
+    if (token.text == "math")
+    {
+      return parseMath();
+    }
+    // arguments of the function: time, value, v1, v2...
+    auto node = std::make_unique<Node>();
+    node->kind = Node::INPUT;
+    if (token.text == "time")
+    {
+      node->input = 0;
+      return node;
+    }
+    if (token.text == "value")
+    {
+      node->input = 1;
+      return node;
+    }
+    if (token.text.size() > 1 && token.text[0] == 'v' && token.text[1] != '0' &&
+        token.text.find_first_not_of("0123456789", 1) == std::string::npos &&
+        token.text.size() < 6)
+    {
+      const int index = std::stoi(token.text.substr(1));
+      if (index <= _num_sources)
+      {
+        node->input = 1 + index;
+        return node;
+      }
+    }
+    // global variable
+    return nullptr;
+  }
+
+  NodePtr parseMath()
+  {
+    if (!acceptSymbol(".") || current().type != Token::NAME)
+    {
+      return nullptr;
+    }
+    const std::string name = current().text;
+    _pos++;
+
+    if (name == "pi")
+    {
+      return MakeNumber(kPi);
+    }
+    if (name == "huge")
+    {
+      return MakeNumber(std::numeric_limits<double>::infinity());
+    }
+    const MathFunction* function = nullptr;
+    for (const auto& it : kMathFunctions)
+    {
+      if (name == it.name)
+      {
+        function = &it;
+      }
+    }
+    if (!function || !acceptSymbol("("))
+    {
+      return nullptr;
+    }
+    std::vector<NodePtr> args;
+    do
+    {
+      auto arg = parseExpression();
+      if (!arg)
+      {
+        return nullptr;
+      }
+      args.push_back(std::move(arg));
+    } while (acceptSymbol(","));
+
+    if (!acceptSymbol(")"))
+    {
+      return nullptr;
+    }
+    if (function->variadic)
+    {
+      NodePtr node = std::move(args.front());
+      for (size_t i = 1; i < args.size(); i++)
+      {
+        node = MakeOperation(*function->binary, std::move(node), std::move(args[i]));
+      }
+      return node;
+    }
+    // Lua ignores additional arguments, but a missing one is an error
+    if (args.size() == 1 && function->unary)
+    {
+      return MakeOperation(*function->unary, std::move(args[0]));
+    }
+    if (args.size() == 2 && function->binary)
+    {
+      return MakeOperation(*function->binary, std::move(args[0]), std::move(args[1]));
+    }
+    return nullptr;
+  }
+
+  std::vector<Token> _tokens;
+  size_t _pos = 0;
+  int _num_sources;
+};
+
+}  // namespace
+
+//---------------------------------------------------
+struct ExpressionCustomFunction::Program
+{
+  struct Instruction
+  {
+    Op op;
+    int dst;
+    int a;
+    int b;
+  };
+
+  // the first registers are the inputs: time, value, v1, v2...
+  int num_registers = 0;
+  // registers containing a constant
+  std::vector<std::pair<int, double>> constants;
+  std::vector<Instruction> code;
+  // registers of the returned values: (value) or (time, value)
+  std::vector<int> results;
+
+  int compile(const Node& node)
+  {
+    switch (node.kind)
+    {
+      case Node::NUMBER:
+        constants.push_back({ num_registers, node.number });
+        return num_registers++;
+      case Node::INPUT:
+        return node.input;
+      case Node::OPERATION: {
+        const int a = compile(*node.args[0]);
+        const int b = (node.args.size() > 1) ? compile(*node.args[1]) : a;
+        code.push_back({ node.op, num_registers, a, b });
+        return num_registers++;
+      }
+    }
+    return -1;
+  }
+
+  static std::shared_ptr<const Program> create(const SnippetData& snippet)
+  {
+    std::vector<Token> tokens;
+    // the global variables could be used by the function
+    if (!Tokenize(snippet.global_vars.toStdString(), tokens) || tokens.size() != 1)
+    {
+      return nullptr;
+    }
+    tokens.clear();
+    if (!Tokenize(snippet.function.toStdString(), tokens))
+    {
+      return nullptr;
+    }
+    const int num_sources = snippet.additional_sources.size();
+    Parser parser(std::move(tokens), num_sources);
+    std::vector<NodePtr> results;
+    if (!parser.parseReturn(results))
+    {
+      return nullptr;
+    }
+    auto program = std::make_shared<Program>();
+    program->num_registers = 2 + num_sources;
+    for (const auto& node : results)
+    {
+      program->results.push_back(program->compile(*node));
+    }
+    return program;
+  }
+};
+
+namespace
+{
+// Executes the program on a block of points of the main source. Create one for each
+// pass over the data: the lookup of the other channels only moves forward.
+class Evaluator
+{
+public:
+  static constexpr size_t BLOCK_SIZE = 256;
+
+  Evaluator(const ExpressionCustomFunction::Program& program,
+            const std::vector<const PlotData*>& channels)
+    : _program(program)
+    , _channels(channels)
+    , _registers(size_t(program.num_registers) * BLOCK_SIZE)
+    , _join(channels, PJ::JoinPolicy::NEAREST)
+  {
+    for (const auto& [index, value] : _program.constants)
+    {
+      std::fill_n(reg(index), BLOCK_SIZE, value);
+    }
+  }
+
+  // the points first, first + stride... count must not be larger than BLOCK_SIZE
+  void run(size_t first, size_t count, size_t stride,
+           std::vector<PlotData::Point>& points)
+  {
+    double* time = reg(0);
+    const PlotData& main_data = *_channels.front();
+    for (size_t k = 0; k < count; k++)
+    {
+      time[k] = main_data.at(first + k * stride).x;
+    }
+    // the main source is sorted: its lookup returns the first point with the same time
+    double* values = reg(1);
+    size_t index = size_t(main_data.getIndexFromX(time[0]));
+    for (size_t k = 0; k < count; k++)
+    {
+      if (k > 0 && time[k] != time[k - 1])
+      {
+        index = first + k * stride;
+        // with stride > 1, the points in between may have the same time
+        while (main_data.at(index - 1).x == time[k])
+        {
+          index--;
+        }
+      }
+      values[k] = main_data.at(index).y;
+    }
+    for (size_t channel = 1; channel < _channels.size(); channel++)
+    {
+      double* values = reg(1 + channel);
+      for (size_t k = 0; k < count; k++)
+      {
+        values[k] = valueAt(channel, time[k]);
+      }
+    }
+    for (const auto& ins : _program.code)
+    {
+      Execute(ins.op, reg(ins.dst), reg(ins.a), reg(ins.b), count);
+    }
+    const double* xs = (_program.results.size() == 2) ? reg(_program.results[0]) : time;
+    const double* ys = reg(_program.results.back());
+    for (size_t k = 0; k < count; k++)
+    {
+      points.push_back({ xs[k], ys[k] });
+    }
+  }
+
+private:
+  double* reg(size_t index)
+  {
+    return _registers.data() + index * BLOCK_SIZE;
+  }
+
+  // same lookup of LuaCustomFunction. The time must not decrease between calls
+  double valueAt(size_t channel, double time)
+  {
+    const auto value = _join.cursor(channel).valueAt(time);
+    return value.value_or(std::numeric_limits<double>::quiet_NaN());
+  }
+
+  const ExpressionCustomFunction::Program& _program;
+  const std::vector<const PlotData*>& _channels;
+  std::vector<double> _registers;
+  PJ::SeriesJoin _join;
+};
+}  // namespace
+
+ExpressionCustomFunction::ExpressionCustomFunction(SnippetData snippet)
+  : CustomFunction(snippet)
+{
+  initEngine();
+}
+
+bool ExpressionCustomFunction::isSupported(const SnippetData& snippet)
+{
+  return Program::create(snippet) != nullptr;
+}
+
+void ExpressionCustomFunction::initEngine()
+{
+  _program = Program::create(_snippet);
+  if (!_program)
+  {
+    throw std::runtime_error("Expression Engine : the function is not a simple "
+                             "expression");
+  }
+}
+
+void ExpressionCustomFunction::calculatePoints(
+    const std::vector<const PlotData*>& channels_data, size_t point_index,
+    std::vector<PlotData::Point>& points)
+{
+  Evaluator evaluator(*_program, channels_data);
+  evaluator.run(point_index, 1, 1, points);
+}
+
+void ExpressionCustomFunction::calculateRange(
+    const std::vector<const PlotData*>& channels_data, size_t first, size_t last,
+    size_t stride, PlotData& dst_data)
+{
+  Evaluator evaluator(*_program, channels_data);
+  std::vector<PlotData::Point> points;
+  points.reserve(Evaluator::BLOCK_SIZE);
+
+  const size_t block = Evaluator::BLOCK_SIZE * stride;
+  for (size_t index = first; index < last; index += block)
+  {
+    points.clear();
+    const size_t count = std::min(block, last - index);
+    evaluator.run(index, (count + stride - 1) / stride, stride, points);
+    for (const auto& point : points)
+    {
+      dst_data.pushBack(point);
+    }
+  }
+}
+
+bool ExpressionCustomFunction::xmlLoadState(const QDomElement& parent_element)
+{
+  bool ret = CustomFunction::xmlLoadState(parent_element);
+  initEngine();
+  return ret;
+}
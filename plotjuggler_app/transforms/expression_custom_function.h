@@ -0,0 +1,55 @@
+#ifndef EXPRESSION_CUSTOM_FUNCTION_H
+#define EXPRESSION_CUSTOM_FUNCTION_H
+
+#include "custom_function.h"
+
+/**
+ * Evaluates, without Lua, the snippets that contain only a "return" of arithmetic
+ * expressions, such as:
+ *
+ *     return math.sqrt(v1^2 + v2^2)
+ *
+ * Supported: numbers, the arguments (time, value, v1...), the operators
+ * + - * / // % ^, the parenthesis and the functions/constants of the "math" library
+ * that don't have side effects. Anything else (global variables, statements,
+ * comparisons, ...) requires LuaCustomFunction: use CreateCustomFunction().
+ *
+ * The expression is compiled into a list of operations, each of them applied to
+ * a block of samples at a time.
+ */
+class ExpressionCustomFunction : public CustomFunction
+{
+public:
+  ExpressionCustomFunction(SnippetData snippet);
+
+  /// True if the snippet can be evaluated by this class, with the same result of Lua.
+  static bool isSupported(const SnippetData& snippet);
+
+  void initEngine() override;
+
+  void calculatePoints(const std::vector<const PlotData*>& channels_data,
+                       size_t point_index, std::vector<PlotData::Point>& points) override;
+
+  void calculateRange(const std::vector<const PlotData*>& channels_data, size_t first,
+                      size_t last, size_t stride, PlotData& dst_data) override;
+
+  // it is still a Lua snippet, executed by a different engine
+  QString language() const override
+  {
+    return "LUA";
+  }
+
+  const char* name() const override
+  {
+    return "ExpressionCustomFunction";
+  }
+
+  bool xmlLoadState(const QDomElement& parent_element) override;
+
+  struct Program;
+
+private:
+  std::shared_ptr<const Program> _program;
+};
+
+#endif  // EXPRESSION_CUSTOM_FUNCTION_H
@@ -25,7 +25,7 @@
 #include <QTimer>
 #include <QSyntaxHighlighter>
 
-#include "lua_custom_function.h"
+#include "expression_custom_function.h"
 #include "PlotJuggler/svg_util.h"
 #include "ui_function_editor_help.h"
 
@@ -122,6 +122,8 @@ FunctionEditorWidget::FunctionEditorWidget(PlotDataMapRef& plotMapData,
 
 FunctionEditorWidget::~FunctionEditorWidget()
 {
+  *_preview_cancelled = true;
+  PlotWidgetBase::waitForRendering();
   delete _preview_widget;
 
   QSettings settings;
@@ -283,7 +285,7 @@ void FunctionEditorWidget::importSnippets(const QByteArray& xml_text)
 
   for (const auto& custom_it : _transform_maps)
   {
-    auto math_plot = dynamic_cast<LuaCustomFunction*>(custom_it.second.get());
+    auto math_plot = dynamic_cast<CustomFunction*>(custom_it.second.get());
     if (!math_plot)
     {
       continue;
@@ -570,7 +572,7 @@ void FunctionEditorWidget::on_pushButtonCreate_clicked()
           ui->listAdditionalSources->item(row, 1)->text());
     }
 
-    CustomPlotPtr plot = std::make_unique<LuaCustomFunction>(snippet);
+    CustomPlotPtr plot = CreateCustomFunction(snippet);
     accept(plot);
   }
   catch (const std::runtime_error& e)
@@ -688,10 +690,10 @@ void FunctionEditorWidget::on_updatePreview()
     snippet.additional_sources.push_back(ui->listAdditionalSources->item(row, 1)->text());
   }
 
-  CustomPlotPtr lua_function;
+  CustomPlotPtr custom_function;
   try
   {
-    lua_function = std::make_unique<LuaCustomFunction>(snippet);
+    custom_function = CreateCustomFunction(snippet);
     ui->buttonSaveCurrent->setEnabled(true);
   }
   catch (...)
@@ -700,21 +702,49 @@ void FunctionEditorWidget::on_updatePreview()
     ui->buttonSaveCurrent->setEnabled(false);
   }
 
-  if (lua_function)
+  // the previous preview is not needed anymore
+  *_preview_cancelled = true;
+  _preview_cancelled = std::make_shared<std::atomic_bool>(false);
+
+  if (custom_function)
   {
     try
     {
-      std::string name = new_plot_name.empty() ? "no_name" : new_plot_name;
-      PlotData& out_data = _local_plot_data.getOrCreateNumeric(name);
-      out_data.clear();
+      _preview_snippet = snippet;
+      _preview_name = new_plot_name.empty() ? "no_name" : new_plot_name;
+
+      // the preview is computed from the first sample of the sources (see
+      // PlotData::restoreHistory). The passes in background must not be reading them.
+      QStringList source_names = snippet.additional_sources;
+      source_names.push_back(snippet.linked_source);
+      for (const auto& source_name : source_names)
+      {
+        auto it = _plot_map_data.numeric.find(source_name.toStdString());
+        if (it != _plot_map_data.numeric.end() && !it->second.archive().empty())
+        {
+          PlotWidgetBase::waitForRendering();
+          it->second.restoreHistory();
+        }
+      }
 
-      std::vector<PlotData*> out_vector = { &out_data };
-      lua_function->setData(&_plot_map_data, {}, out_vector);
-      lua_function->calculate();
+      // Evaluate at most PREVIEW_POINTS samples, spread over the whole source, now:
+      // this reports the errors immediately. The result is refined in background.
+      size_t stride = 1;
+      auto source_it = _plot_map_data.numeric.find(snippet.linked_source.toStdString());
+      if (source_it != _plot_map_data.numeric.end())
+      {
+        stride = std::max<size_t>(1, source_it->second.size() / PREVIEW_POINTS);
+      }
+      PlotData preview_data(_preview_name, {});
+      std::vector<PlotData*> out_vector = { &preview_data };
+      custom_function->setData(&_plot_map_data, {}, out_vector);
+      custom_function->calculateDecimated(stride, []() { return false; });
 
-      _preview_widget->removeAllCurves();
-      _preview_widget->addCurve(name, Qt::blue);
-      _preview_widget->zoomOut(false);
+      showPreview(preview_data);
+      if (stride > 1)
+      {
+        startPreviewPass(std::max<size_t>(1, stride / PREVIEW_REFINE_FACTOR));
+      }
     }
     catch (...)
     {
@@ -723,11 +753,25 @@ void FunctionEditorWidget::on_updatePreview()
   }
   //----------------------------------
 
+  QString engine;
+  if (dynamic_cast<ExpressionCustomFunction*>(custom_function.get()))
+  {
+    engine = "Simple expression: evaluated without the Lua engine.";
+  }
+  showPreviewStatus(errors, engine);
+}
+
+void FunctionEditorWidget::showPreviewStatus(QString errors, const QString& engine)
+{
   QFile file(":/resources/svg/red_circle.svg");
 
   if (errors.isEmpty())
   {
     errors = "Everything is fine :)";
+    if (!engine.isEmpty())
+    {
+      errors += "\n" + engine;
+    }
     file.setFileName(":/resources/svg/green_circle.svg");
     ui->pushButtonCreate->setEnabled(true);
   }
@@ -752,6 +796,85 @@ void FunctionEditorWidget::on_updatePreview()
   ui->labelSemaphore->setPixmap(QPixmap::fromImage(image));
 }
 
+void FunctionEditorWidget::showPreview(PlotData& data)
+{
+  // the preview could be drawn in background
+  PlotWidgetBase::waitForRendering();
+  _preview_widget->removeAllCurves();
+
+  PlotData& out_data = _local_plot_data.getOrCreateNumeric(_preview_name);
+  out_data = std::move(data);
+  out_data.setTimeRangeIndex(_local_plot_data.time_range);
+
+  _preview_widget->addCurve(_preview_name, Qt::blue);
+  _preview_widget->zoomOut(false);
+}
+
+void FunctionEditorWidget::startPreviewPass(size_t stride, CustomPlotPtr function,
+                                            std::shared_ptr<PlotData> partial)
+{
+  auto token = _preview_cancelled;
+  auto snippet = _preview_snippet;
+  auto name = _preview_name;
+  PlotDataMapRef* plot_data = &_plot_map_data;
+  auto result = partial ? partial : std::make_shared<PlotData>(name, PlotGroup::Ptr());
+
+  PlotWidgetBase::runInBackground([=](const std::function<bool()>& cancelled) {
+    bool completed = false;
+    bool failed = false;
+    CustomPlotPtr pass_function = function;
+    try
+    {
+      // a new instance for each pass: the state of the Lua engine depends on the
+      // previous calls. An interrupted pass continues with the same one.
+      if (!pass_function)
+      {
+        pass_function = CreateCustomFunction(snippet);
+        std::vector<PlotData*> out_vector = { result.get() };
+        pass_function->setData(plot_data, {}, out_vector);
+      }
+      completed = pass_function->calculateDecimated(
+          stride, [&]() { return *token || cancelled(); });
+    }
+    catch (...)
+    {
+      failed = true;
+    }
+    // the destructor waits for this function, after setting the token
+    if (*token)
+    {
+      return;
+    }
+    QMetaObject::invokeMethod(
+        this,
+        [=]() {
+          if (token != _preview_cancelled)
+          {
+            return;
+          }
+          if (failed)
+          {
+            showPreviewStatus("- The Lua function can not compute the result.\n", {});
+          }
+          else if (completed)
+          {
+            showPreview(*result);
+            if (stride > 1)
+            {
+              startPreviewPass(std::max<size_t>(1, stride / PREVIEW_REFINE_FACTOR));
+            }
+          }
+          else
+          {
+            // interrupted by PlotWidgetBase::waitForRendering(), that is called at
+            // every update while streaming: continue after the last point computed
+            startPreviewPass(stride, pass_function, result);
+          }
+        },
+        Qt::QueuedConnection);
+  });
+}
+
 void FunctionEditorWidget::on_globalVarsTextField_textChanged()
 {
   updatePreview();
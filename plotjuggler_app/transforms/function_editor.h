@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QTimer>
 #include <QListWidgetItem>
+#include <atomic>
 #include <unordered_map>
 #include "PlotJuggler/plotdata.h"
 #include "custom_function.h"
@@ -95,8 +96,30 @@ private:
 
   void updatePreview();
 
+  void showPreviewStatus(QString errors, const QString& engine);
+
+  // replace the curve of the preview
+  void showPreview(PlotData& data);
+
+  // evaluate in background one sample every "stride", then the next pass.
+  // If the same pass was interrupted, "function" is the instance that computed
+  // "partial", and it continues from its last point.
+  void startPreviewPass(size_t stride, CustomPlotPtr function = {},
+                        std::shared_ptr<PlotData> partial = {});
+
   QTimer _update_preview_timer;
 
+  // samples evaluated by the first pass of the preview, in the GUI thread
+  static constexpr size_t PREVIEW_POINTS = 2000;
+  // ratio between the strides of two consecutive passes
+  static constexpr size_t PREVIEW_REFINE_FACTOR = 8;
+
+  // set when the preview running in background is outdated
+  std::shared_ptr<std::atomic_bool> _preview_cancelled =
+      std::make_shared<std::atomic_bool>(false);
+  SnippetData _preview_snippet;
+  std::string _preview_name;
+
   PlotDataMapRef& _plot_map_data;
   const TransformsMap& _transform_maps;
   Ui::FunctionEditor* ui;
@@ -31,25 +31,37 @@ void LuaCustomFunction::calculatePoints(const std::vector<const PlotData*>& src_
 {
   std::unique_lock<std::mutex> lk(mutex_);
 
-  _chan_values.resize(src_data.size());
+  PJ::SeriesJoin channels(src_data, PJ::JoinPolicy::NEAREST);
+  evaluate(channels, src_data.front()->at(point_index).x, points);
+}
 
-  const PlotData::Point& old_point = src_data.front()->at(point_index);
+void LuaCustomFunction::calculateRange(const std::vector<const PlotData*>& src_data,
+                                       size_t first, size_t last, size_t stride,
+                                       PlotData& dst_data)
+{
+  std::unique_lock<std::mutex> lk(mutex_);
 
-  for (size_t chan_index = 0; chan_index < src_data.size(); chan_index++)
+  // the times of the linked source are sorted: each channel is visited only once
+  PJ::SeriesJoin channels(src_data, PJ::JoinPolicy::NEAREST);
+  std::vector<PlotData::Point> points;
+  for (size_t i = first; i < last; i += stride)
   {
-    double value;
-    const PlotData* chan_data = src_data[chan_index];
-    int index = chan_data->getIndexFromX(old_point.x);
-    if (index != -1)
-    {
-      value = chan_data->at(index).y;
-    }
-    else
+    points.clear();
+    evaluate(channels, src_data.front()->at(i).x, points);
+
+    for (PlotData::Point const& point : points)
     {
-      value = std::numeric_limits<double>::quiet_NaN();
+      dst_data.pushBack(point);
     }
-    _chan_values[chan_index] = value;
   }
+}
+
+void LuaCustomFunction::evaluate(PJ::SeriesJoin& channels, double time,
+                                 std::vector<PlotData::Point>& points)
+{
+  // NaN if the channel is empty
+  _chan_values.resize(channels.size());
+  channels.valuesAt(time, _chan_values.data());
 
   sol::safe_function_result result;
   const auto& v = _chan_values;
@@ -57,31 +69,31 @@ void LuaCustomFunction::calculatePoints(const std::vector<const PlotData*>& src_
   switch (_snippet.additional_sources.size())
   {
     case 0:
-      result = _lua_function(old_point.x, v[0]);
+      result = _lua_function(time, v[0]);
       break;
     case 1:
-      result = _lua_function(old_point.x, v[0], v[1]);
+      result = _lua_function(time, v[0], v[1]);
       break;
     case 2:
-      result = _lua_function(old_point.x, v[0], v[1], v[2]);
+      result = _lua_function(time, v[0], v[1], v[2]);
       break;
     case 3:
-      result = _lua_function(old_point.x, v[0], v[1], v[2], v[3]);
+      result = _lua_function(time, v[0], v[1], v[2], v[3]);
       break;
     case 4:
-      result = _lua_function(old_point.x, v[0], v[1], v[2], v[3], v[4]);
+      result = _lua_function(time, v[0], v[1], v[2], v[3], v[4]);
       break;
     case 5:
-      result = _lua_function(old_point.x, v[0], v[1], v[2], v[3], v[4], v[5]);
+      result = _lua_function(time, v[0], v[1], v[2], v[3], v[4], v[5]);
       break;
     case 6:
-      result = _lua_function(old_point.x, v[0], v[1], v[2], v[3], v[4], v[5], v[6]);
+      result = _lua_function(time, v[0], v[1], v[2], v[3], v[4], v[5], v[6]);
       break;
     case 7:
-      result = _lua_function(old_point.x, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+      result = _lua_function(time, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
       break;
     case 8:
-      result = _lua_function(old_point.x, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7],
+      result = _lua_function(time, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7],
                              v[8]);
       break;
     default:
@@ -103,7 +115,7 @@ void LuaCustomFunction::calculatePoints(const std::vector<const PlotData*>& src_
   else if (result.return_count() == 1 && result.get_type(0) == sol::type::number)
   {
     PlotData::Point new_point;
-    new_point.x = old_point.x;
+    new_point.x = time;
     new_point.y = result.get<double>(0);
     points.push_back(new_point);
   }
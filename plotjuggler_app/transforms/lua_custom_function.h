@@ -2,6 +2,7 @@
 #define LUA_CUSTOM_FUNCTION_H
 
 #include "custom_function.h"
+#include "PlotJuggler/series_join.h"
 #include "sol.hpp"
 
 class LuaCustomFunction : public CustomFunction
@@ -14,6 +15,9 @@ public:
   void calculatePoints(const std::vector<const PlotData*>& channels_data,
                        size_t point_index, std::vector<PlotData::Point>& points) override;
 
+  void calculateRange(const std::vector<const PlotData*>& channels_data, size_t first,
+                      size_t last, size_t stride, PlotData& dst_data) override;
+
   QString language() const override
   {
     return "LUA";
@@ -27,6 +31,11 @@ public:
   bool xmlLoadState(const QDomElement& parent_element) override;
 
 private:
+  // call the Lua function with the values of the channels at the given time.
+  // mutex_ must be locked
+  void evaluate(PJ::SeriesJoin& channels, double time,
+                std::vector<PlotData::Point>& points);
+
   std::unique_ptr<sol::state> _lua_engine;
   sol::protected_function _lua_function;
   std::vector<double> _chan_values;
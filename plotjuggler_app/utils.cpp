@@ -27,6 +27,14 @@ MoveDataRet MoveData(PlotDataMapRef& source, PlotDataMapRef& destination,
                            .emplace(std::piecewise_construct, std::forward_as_tuple(ID),
                                     std::forward_as_tuple(plot_name, group))
                            .first;
+        if constexpr (std::is_same_v<std::decay_t<decltype(source_plot)>, StringSeries>)
+        {
+          dest_plot_it->second.setStringPool(destination.string_pool);
+        }
+        if constexpr (std::is_same_v<std::decay_t<decltype(source_plot)>, PlotData>)
+        {
+          dest_plot_it->second.setTimeRangeIndex(destination.time_range);
+        }
         ret.curves_updated = true;
       }
 
@@ -67,15 +75,24 @@ MoveDataRet MoveData(PlotDataMapRef& source, PlotDataMapRef& destination,
         destination_plot.clear();
       }
 
+      source_plot.flushReorderBuffer();
+
       if (source_plot.size() > 0)
       {
         ret.data_pushed = true;
       }
 
+      // samples older than the ones already in destination are merged once,
+      // at the end of the batch, instead of being inserted one by one
+      const double lateness = destination_plot.reorderWindow();
+      destination_plot.setReorderWindow(std::numeric_limits<double>::max());
+
       for (size_t i = 0; i < source_plot.size(); i++)
       {
         destination_plot.pushBack(source_plot.at(i));
       }
+      destination_plot.flushReorderBuffer();
+      destination_plot.setReorderWindow(lateness);
 
       double max_range_x = source_plot.maximumRangeX();
       destination_plot.setMaximumRangeX(max_range_x);
@@ -89,5 +106,10 @@ MoveDataRet MoveData(PlotDataMapRef& source, PlotDataMapRef& destination,
   moveDataImpl(source.strings, destination.strings);
   moveDataImpl(source.user_defined, destination.user_defined);
 
+  // the strings of the cleared source series are still in its pool, the ones
+  // of destination may have been trimmed
+  source.sweepStringPool();
+  destination.sweepStringPool();
+
   return ret;
 }
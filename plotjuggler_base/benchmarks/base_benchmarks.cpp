@@ -0,0 +1,525 @@
+/*
+ * Microbenchmarks of the data structures of plotjuggler_base.
+ *
+ * Usage: plotjuggler_base_benchmarks [--format=console|csv|json] [--filter=substring]
+ *                                    [--max_size=N] [--min_time=seconds]
+ *
+ * The json format follows the layout of Google Benchmark ("benchmarks" array with
+ * "name", "iterations", "real_time", "time_unit"), to reuse the existing comparison
+ * tools.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "PlotJuggler/plotdata.h"
+#include "PlotJuggler/series_join.h"
+#include "PlotJuggler/fmt/format.h"
+#include "utils.h"
+
+using namespace PJ;
+
+namespace
+{
+struct Result
+{
+  std::string name;
+  size_t size;
+  size_t iterations;
+  // median time per item, in nanoseconds
+  double ns_per_item;
+  double items_per_second;
+};
+
+struct Options
+{
+  std::string format = "console";
+  std::string filter;
+  size_t max_size = 10000000;
+  double min_time = 0.2;
+};
+
+/**
+ * A benchmark function processes "size" items and returns the time spent in the
+ * measured section, in seconds. Setup and cleanup are not measured.
+ */
+using BenchmarkFunction = std::function<double(size_t size)>;
+
+struct Benchmark
+{
+  std::string name;
+  BenchmarkFunction function;
+  size_t min_size;
+  size_t max_size;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::vector<size_t> Sizes(size_t min_size, size_t max_size)
+{
+  std::vector<size_t> sizes;
+  for (size_t size = 1000; size <= max_size; size *= 10)
+  {
+    if (size >= min_size)
+    {
+      sizes.push_back(size);
+    }
+  }
+  return sizes;
+}
+
+Result Run(const Benchmark& benchmark, size_t size, double min_time)
+{
+  std::vector<double> times;
+  double total = 0;
+  // at least 3 repetitions, to get a meaningful median
+  while (times.size() < 3 || (total < min_time && times.size() < 1000))
+  {
+    const double t = benchmark.function(size);
+    times.push_back(t);
+    total += t;
+  }
+  std::sort(times.begin(), times.end());
+  const double median = times[times.size() / 2];
+
+  Result result;
+  result.name = fmt::format("{}/{}", benchmark.name, size);
+  result.size = size;
+  result.iterations = times.size();
+  result.ns_per_item = median * 1e9 / double(size);
+  result.items_per_second = double(size) / median;
+  return result;
+}
+
+//------------------------------------------------------
+
+PlotData CreateSeries(size_t size)
+{
+  PlotData series("series", {});
+  for (size_t i = 0; i < size; i++)
+  {
+    series.pushBack({ double(i) * 0.001, double(i) });
+  }
+  return series;
+}
+
+double PushBackInOrder(size_t size)
+{
+  PlotData series("series", {});
+  const auto start = Clock::now();
+  for (size_t i = 0; i < size; i++)
+  {
+    series.pushBack({ double(i) * 0.001, double(i) });
+  }
+  return Seconds(start);
+}
+
+// one sample every 10 arrives late, by up to 5 positions (network jitter)
+double PushBackOutOfOrder(size_t size, double reorder_window)
+{
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> delay(1, 5);
+  std::vector<double> timestamps(size);
+  for (size_t i = 0; i < size; i++)
+  {
+    timestamps[i] = double(i) * 0.001;
+  }
+  for (size_t i = 10; i < size; i += 10)
+  {
+    std::swap(timestamps[i], timestamps[i - delay(rng)]);
+  }
+
+  PlotData series("series", {});
+  series.setReorderWindow(reorder_window);
+  const auto start = Clock::now();
+  for (size_t i = 0; i < size; i++)
+  {
+    series.pushBack({ timestamps[i], double(i) });
+  }
+  series.flushReorderBuffer();
+  return Seconds(start);
+}
+
+// streaming steady state: every new sample removes the oldest one
+double PushBackTrimRange(size_t size)
+{
+  PlotData series("series", {});
+  series.setMaximumRangeX(1.0);  // 1000 samples
+  const auto start = Clock::now();
+  for (size_t i = 0; i < size; i++)
+  {
+    series.pushBack({ double(i) * 0.001, double(i) });
+  }
+  return Seconds(start);
+}
+
+double SetMaximumRangeX(size_t size)
+{
+  PlotData series = CreateSeries(size);
+  const auto start = Clock::now();
+  series.setMaximumRangeX(double(size) * 0.0001);  // keep 10%
+  return Seconds(start);
+}
+
+// quantized values with regular sampling, like most signals parsed from ULog
+PlotData CreateQuantizedSeries(size_t size)
+{
+  PlotData series("series", {});
+  for (size_t i = 0; i < size; i++)
+  {
+    series.pushBack({ 1.7e9 + double(i) * 0.001, double((i / 100) % 16) });
+  }
+  return series;
+}
+
+double CompressHistory(size_t size)
+{
+  PlotData series = CreateQuantizedSeries(size);
+  const auto start = Clock::now();
+  series.compressHistory(series.back().x);
+  return Seconds(start);
+}
+
+double ReadCompressedHistory(size_t size)
+{
+  PlotData series = CreateQuantizedSeries(size);
+  series.compressHistory(series.back().x);
+  double checksum = 0;
+  const auto start = Clock::now();
+  CompressedSeries::Reader reader(series.archive());
+  CompressedSeries::Point p;
+  while (reader.next(p))
+  {
+    checksum += p.y;
+  }
+  const double elapsed = Seconds(start);
+  if (checksum == -1)
+  {
+    std::cerr << checksum;
+  }
+  return elapsed;
+}
+
+// "size" random lookups in a series with "size" points
+double GetIndexFromX(size_t size)
+{
+  static PlotData series("series", {});
+  if (series.size() != size)
+  {
+    series = CreateSeries(size);
+  }
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> time(0.0, double(size) * 0.001);
+  std::vector<double> queries(std::min<size_t>(size, 1000000));
+  for (auto& t : queries)
+  {
+    t = time(rng);
+  }
+
+  int checksum = 0;
+  const auto start = Clock::now();
+  for (size_t i = 0; i < size; i++)
+  {
+    checksum += series.getIndexFromX(queries[i % queries.size()]);
+  }
+  const double elapsed = Seconds(start);
+  // prevent the compiler from removing the loop
+  if (checksum == -1)
+  {
+    std::cerr << checksum;
+  }
+  return elapsed;
+}
+
+// the value of a series with "size" points at the times of another one, with a
+// different sampling rate (like a transform with more sources)
+double SeriesCursorNearest(size_t size)
+{
+  static PlotData series("series", {});
+  if (series.size() != size)
+  {
+    series = CreateSeries(size);
+  }
+  double checksum = 0;
+  const auto start = Clock::now();
+  SeriesCursor cursor(series, JoinPolicy::NEAREST);
+  for (size_t i = 0; i < size; i++)
+  {
+    checksum += *cursor.valueAt(double(i) * 0.00099);
+  }
+  const double elapsed = Seconds(start);
+  if (checksum == -1)
+  {
+    std::cerr << checksum;
+  }
+  return elapsed;
+}
+
+// "size" points in 10 series with different sampling rates, exported as CSV rows
+double SeriesMergeJoinRows(size_t size)
+{
+  const size_t SERIES = 10;
+  std::vector<PlotData> data;
+  for (size_t s = 0; s < SERIES; s++)
+  {
+    data.emplace_back("series", PlotGroup::Ptr());
+    const double period = 0.001 * double(s + 1);
+    for (size_t i = 0; i < size / SERIES; i++)
+    {
+      data.back().pushBack({ double(i) * period, double(i) });
+    }
+  }
+  std::vector<const PlotData*> series;
+  for (const auto& s : data)
+  {
+    series.push_back(&s);
+  }
+
+  double checksum = 0;
+  const auto start = Clock::now();
+  SeriesMergeJoin join(series, 0, std::numeric_limits<double>::max());
+  while (join.next())
+  {
+    for (size_t s = 0; s < SERIES; s++)
+    {
+      if (const auto* point = join.point(s))
+      {
+        checksum += point->y;
+      }
+    }
+  }
+  const double elapsed = Seconds(start);
+  if (checksum == -1)
+  {
+    std::cerr << checksum;
+  }
+  return elapsed;
+}
+
+// typical enum-like data: few distinct values
+double StringPushBackRepeated(size_t size)
+{
+  const std::vector<std::string> values = { "IDLE", "RUNNING", "WARNING", "ERROR",
+                                            "a longer string, stored in the heap" };
+  StringSeries series("series", {});
+  const auto start = Clock::now();
+  for (size_t i = 0; i < size; i++)
+  {
+    series.pushBack({ double(i) * 0.001, values[(i / 10) % values.size()] });
+  }
+  return Seconds(start);
+}
+
+// worst case: every value is different
+double StringPushBackUnique(size_t size)
+{
+  std::vector<std::string> values(size);
+  for (size_t i = 0; i < size; i++)
+  {
+    values[i] = fmt::format("message number {}", i);
+  }
+  StringSeries series("series", {});
+  const auto start = Clock::now();
+  for (size_t i = 0; i < size; i++)
+  {
+    series.pushBack({ double(i) * 0.001, values[i] });
+  }
+  return Seconds(start);
+}
+
+// "size" series with 10 points each
+double AddPrefix(size_t size)
+{
+  PlotDataMapRef data;
+  for (size_t i = 0; i < size; i++)
+  {
+    auto& series = data.addNumeric(fmt::format("topic/{}/value", i))->second;
+    for (int p = 0; p < 10; p++)
+    {
+      series.pushBack({ double(p), double(p) });
+    }
+  }
+  const auto start = Clock::now();
+  AddPrefixToPlotData("prefix", data.numeric);
+  return Seconds(start);
+}
+
+// "size" points in 100 series, moved into a destination that already has them
+double MoveDataStreaming(size_t size)
+{
+  const size_t SERIES = 100;
+  PlotDataMapRef source;
+  PlotDataMapRef destination;
+  for (size_t i = 0; i < SERIES; i++)
+  {
+    const auto name = fmt::format("series/{}", i);
+    source.addNumeric(name);
+    destination.addNumeric(name)->second.pushBack({ -1.0, 0.0 });
+  }
+  size_t index = 0;
+  for (auto& it : source.numeric)
+  {
+    for (size_t p = 0; p < size / SERIES; p++)
+    {
+      it.second.pushBack({ double(p) * 0.001, double(index) });
+    }
+    index++;
+  }
+  const auto start = Clock::now();
+  MoveData(source, destination, false);
+  return Seconds(start);
+}
+
+void PrintConsole(const std::vector<Result>& results)
+{
+  std::cout << fmt::format("{:<36} {:>12} {:>14} {:>16}\n", "benchmark", "iterations",
+                           "ns/item", "items/s");
+  for (const auto& r : results)
+  {
+    std::cout << fmt::format("{:<36} {:>12} {:>14.2f} {:>16.0f}\n", r.name, r.iterations,
+                             r.ns_per_item, r.items_per_second);
+  }
+}
+
+void PrintCSV(const std::vector<Result>& results)
+{
+  std::cout << "name,size,iterations,ns_per_item,items_per_second\n";
+  for (const auto& r : results)
+  {
+    std::cout << fmt::format("{},{},{},{:.3f},{:.0f}\n", r.name, r.size, r.iterations,
+                             r.ns_per_item, r.items_per_second);
+  }
+}
+
+void PrintJSON(const std::vector<Result>& results)
+{
+  std::cout << "{\n  \"benchmarks\": [\n";
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const auto& r = results[i];
+    std::cout << fmt::format("    {{\"name\": \"{}\", \"size\": {}, \"iterations\": {}, "
+                             "\"real_time\": {:.3f}, \"time_unit\": \"ns\", "
+                             "\"items_per_second\": {:.0f}}}{}\n",
+                             r.name, r.size, r.iterations, r.ns_per_item,
+                             r.items_per_second, (i + 1 < results.size()) ? "," : "");
+  }
+  std::cout << "  ]\n}\n";
+}
+
+bool ParseOptions(int argc, char* argv[], Options& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    auto value = [&](const char* name) -> const char* {
+      const std::string key = std::string(name) + "=";
+      return (arg.rfind(key, 0) == 0) ? argv[i] + key.size() : nullptr;
+    };
+
+    if (auto v = value("--format"))
+    {
+      options.format = v;
+    }
+    else if (auto v = value("--filter"))
+    {
+      options.filter = v;
+    }
+    else if (auto v = value("--max_size"))
+    {
+      options.max_size = static_cast<size_t>(std::stod(v));
+    }
+    else if (auto v = value("--min_time"))
+    {
+      options.min_time = std::stod(v);
+    }
+    else
+    {
+      std::cerr << "Usage: " << argv[0]
+                << " [--format=console|csv|json] [--filter=substring]"
+                   " [--max_size=N] [--min_time=seconds]\n";
+      return false;
+    }
+  }
+  if (options.format != "console" && options.format != "csv" && options.format != "json")
+  {
+    std::cerr << "Unknown format: " << options.format << "\n";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  Options options;
+  if (!ParseOptions(argc, argv, options))
+  {
+    return 1;
+  }
+
+  // name, function, min_size, max_size
+  const std::vector<Benchmark> benchmarks = {
+    { "PushBack/InOrder", PushBackInOrder, 1000, 100000000 },
+    { "PushBack/OutOfOrder",
+      [](size_t size) { return PushBackOutOfOrder(size, -1); }, 1000, 100000000 },
+    { "PushBack/OutOfOrderWindow",
+      [](size_t size) { return PushBackOutOfOrder(size, 0.01); }, 1000, 100000000 },
+    { "PushBack/TrimRange", PushBackTrimRange, 1000, 100000000 },
+    { "SetMaximumRangeX", SetMaximumRangeX, 1000, 100000000 },
+    { "GetIndexFromX", GetIndexFromX, 1000, 100000000 },
+    { "SeriesJoin/Cursor", SeriesCursorNearest, 1000, 100000000 },
+    { "SeriesJoin/MergeJoin", SeriesMergeJoinRows, 1000, 10000000 },
+    { "Compressed/Write", CompressHistory, 1000, 100000000 },
+    { "Compressed/Read", ReadCompressedHistory, 1000, 100000000 },
+    { "StringSeries/Repeated", StringPushBackRepeated, 1000, 10000000 },
+    { "StringSeries/Unique", StringPushBackUnique, 1000, 10000000 },
+    { "AddPrefixToPlotData", AddPrefix, 1000, 1000000 },
+    { "MoveData", MoveDataStreaming, 1000, 100000000 },
+  };
+
+  std::vector<Result> results;
+  for (const auto& benchmark : benchmarks)
+  {
+    if (benchmark.name.find(options.filter) == std::string::npos)
+    {
+      continue;
+    }
+    for (size_t size : Sizes(benchmark.min_size, std::min(benchmark.max_size,
+                                                          options.max_size)))
+    {
+      results.push_back(Run(benchmark, size, options.min_time));
+      if (options.format == "console")
+      {
+        std::cerr << "." << std::flush;
+      }
+    }
+  }
+  if (options.format == "console")
+  {
+    std::cerr << "\n";
+  }
+
+  if (options.format == "json")
+  {
+    PrintJSON(results);
+  }
+  else if (options.format == "csv")
+  {
+    PrintCSV(results);
+  }
+  else
+  {
+    PrintConsole(results);
+  }
+  return 0;
+}
@@ -0,0 +1,211 @@
+#ifndef PJ_COMPRESSED_SERIES_H
+#define PJ_COMPRESSED_SERIES_H
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+#include "plotdatabase.h"
+
+namespace PJ
+{
+/**
+ * @brief Lossless compressed storage of up to MAX_SIZE points, sorted by time.
+ *
+ * Timestamps are stored as the delta-of-delta of their binary representation:
+ * with regular sampling most of them take 1 to 10 bits.
+ * Values are XORed with the previous one (Gorilla encoding): repeated values take a
+ * single bit, slowly varying or quantized values a few more.
+ */
+class CompressedBlock
+{
+public:
+  using Point = PlotDataBase<double, double>::Point;
+
+  static constexpr size_t MAX_SIZE = 1024;
+
+  CompressedBlock();
+
+  /// The block must not be full() and x must not be older than lastX().
+  void pushBack(double x, double y);
+
+  size_t size() const
+  {
+    return _size;
+  }
+
+  bool full() const
+  {
+    return _size >= MAX_SIZE;
+  }
+
+  double firstX() const
+  {
+    return _first_x;
+  }
+
+  double lastX() const
+  {
+    return _last_x;
+  }
+
+  Range rangeY() const
+  {
+    return _range_y;
+  }
+
+  size_t memoryUsage() const;
+
+  /// Release the memory reserved for points that will never be added.
+  void shrinkToFit();
+
+  /// Append all the points of the block to "output".
+  void decode(std::vector<Point>& output) const;
+
+  /// Sequential decoder of a block.
+  class Reader
+  {
+  public:
+    Reader(const CompressedBlock& block);
+
+    /// Return false when all the points have been read.
+    bool next(Point& point);
+
+  private:
+    const CompressedBlock* _block;
+    size_t _index;
+    uint64_t _bit_pos;
+    uint64_t _prev_x;
+    int64_t _prev_delta;
+    uint64_t _prev_y;
+    int _prev_leading;
+    int _prev_trailing;
+
+    uint64_t readBits(int count);
+  };
+
+private:
+  void writeBits(uint64_t value, int count);
+
+  std::vector<uint64_t> _words;
+  uint64_t _bit_count;
+  uint32_t _size;
+
+  double _first_x;
+  double _first_y;
+  double _last_x;
+  Range _range_y;
+
+  // state of the encoder
+  uint64_t _prev_x;
+  int64_t _prev_delta;
+  uint64_t _prev_y;
+  int _prev_leading;
+  int _prev_trailing;
+};
+
+/**
+ * @brief Sequence of CompressedBlocks, used to store the history of a PlotData
+ * with a fraction of the memory (see TimeseriesBase::compressHistory).
+ *
+ * Points can only be appended at the end and removed from the front, one block
+ * at a time.
+ */
+class CompressedSeries
+{
+public:
+  using Point = CompressedBlock::Point;
+
+  CompressedSeries();
+
+  void pushBack(double x, double y);
+
+  size_t size() const
+  {
+    return _size;
+  }
+
+  bool empty() const
+  {
+    return _size == 0;
+  }
+
+  void clear();
+
+  size_t memoryUsage() const;
+
+  /// Incremented every time the series is modified.
+  uint64_t revision() const
+  {
+    return _revision;
+  }
+
+  RangeOpt rangeX() const;
+
+  RangeOpt rangeY() const;
+
+  /// Remove the blocks whose points are all older than x.
+  /// @return number of points removed.
+  size_t trimBefore(double x);
+
+  const std::deque<CompressedBlock>& blocks() const
+  {
+    return _blocks;
+  }
+
+  /// Sequential decoder of the entire series.
+  class Reader
+  {
+  public:
+    Reader(const CompressedSeries& series);
+
+    bool next(Point& point);
+
+  private:
+    const CompressedSeries* _series;
+    size_t _block_index;
+    std::optional<CompressedBlock::Reader> _block_reader;
+  };
+
+  /**
+   * @brief Random access to the points, by index or time.
+   * The last decoded block is cached, therefore reading consecutive points is fast.
+   */
+  class Cursor
+  {
+  public:
+    Cursor();
+
+    /// The reference is valid until the next call.
+    const Point& at(const CompressedSeries& series, size_t index);
+
+    /// Index of the point closest to x, like TimeseriesBase::getIndexFromX.
+    int indexFromX(const CompressedSeries& series, double x);
+
+  private:
+    void load(const CompressedSeries& series, size_t block_index);
+
+    const CompressedSeries* _series;
+    uint64_t _revision;
+    size_t _block_index;
+    size_t _block_offset;
+    std::vector<Point> _points;
+  };
+
+private:
+  std::deque<CompressedBlock> _blocks;
+  // index of the first point of each block, counted from the first point ever pushed
+  std::deque<size_t> _block_offsets;
+  // number of points removed from the front
+  size_t _removed;
+  size_t _size;
+  uint64_t _revision;
+  mutable Range _range_y;
+  mutable bool _range_y_dirty;
+
+  size_t blockFromIndex(size_t index) const;
+};
+
+}  // namespace PJ
+
+#endif  // PJ_COMPRESSED_SERIES_H
@@ -40,6 +40,22 @@ public:
 
   virtual bool readDataFromFile(FileLoadInfo* fileload_info,
                                 PlotDataMapRef& destination) = 0;
+
+  /**
+   * @brief Return true if readDataFromFile() can be called from a worker thread,
+   * concurrently with other calls, when many files are loaded at once.
+   * Such a loader must not create widgets or dialogs in readDataFromFile();
+   * it can do it in finishLoading() instead.
+   */
+  virtual bool supportsConcurrentLoading() const
+  {
+    return false;
+  }
+
+  /// Called in the main thread, after readDataFromFile() returned true.
+  virtual void finishLoading(const FileLoadInfo& fileload_info)
+  {
+  }
 };
 
 using DataLoaderPtr = std::shared_ptr<DataLoader>;
@@ -0,0 +1,82 @@
+#ifndef PJ_MEMORY_BUDGET_H
+#define PJ_MEMORY_BUDGET_H
+
+#include "plotdata.h"
+
+namespace PJ
+{
+/**
+ * @brief MemoryBudget limits the memory used by the series of a PlotDataMapRef.
+ *
+ * If compression is enabled, the history of the numeric series older than
+ * fullResolutionWindow() is compressed without loss
+ * (see TimeseriesBase::compressHistory).
+ *
+ * When the budget is exceeded, the same history is compacted, using a coarser
+ * resolution at each pass, until the memory usage falls below 80% of the budget.
+ * The resolution is kept between calls and enforce() stops at the first pass
+ * that doesn't free anything.
+ * Old data is summarized (see TimeseriesBase::compact), instead of being deleted.
+ *
+ * Strings and user defined series are counted, but never compacted.
+ */
+class MemoryBudget
+{
+public:
+  struct Usage
+  {
+    size_t numeric = 0;
+    size_t strings = 0;
+    size_t user_defined = 0;
+
+    size_t total() const
+    {
+      return numeric + strings + user_defined;
+    }
+  };
+
+  MemoryBudget();
+
+  static Usage memoryUsage(const PlotDataMapRef& data);
+
+  /// Maximum number of bytes. Zero means unlimited.
+  void setBudget(size_t bytes);
+
+  size_t budget() const
+  {
+    return _budget;
+  }
+
+  void setCompression(bool enabled);
+
+  bool compression() const
+  {
+    return _compression;
+  }
+
+  /// The most recent "seconds" of each series are never compacted.
+  void setFullResolutionWindow(double seconds);
+
+  double fullResolutionWindow() const
+  {
+    return _full_resolution_window;
+  }
+
+  /**
+   * @brief Compress the history and compact it, if the budget is exceeded.
+   * The history of a pinned series is not compressed (see TimeseriesBase::pinHistory).
+   * @return true if any series was compacted.
+   */
+  bool enforce(PlotDataMapRef& data);
+
+private:
+  size_t _budget;
+  bool _compression;
+  double _full_resolution_window;
+  // resolution used by the last pass of enforce()
+  double _resolution;
+};
+
+}  // namespace PJ
+
+#endif  // PJ_MEMORY_BUDGET_H
@@ -0,0 +1,122 @@
+#ifndef PJ_MESSAGE_BUFFER_H
+#define PJ_MESSAGE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace PJ
+{
+class MessageBufferPool;
+
+/**
+ * @brief Reference counted buffer, used by the DataStreamers to receive a message and
+ * pass it to a MessageParser (see MessageRef) without copying it.
+ *
+ * Copying a MessageBuffer shares the same memory. When the last copy is destroyed,
+ * the memory goes back to the MessageBufferPool that created it, to be recycled by
+ * the next message.
+ */
+class MessageBuffer
+{
+public:
+  /// Empty buffer, not associated to any pool.
+  MessageBuffer() : _storage(nullptr)
+  {
+  }
+
+  MessageBuffer(const MessageBuffer& other);
+  MessageBuffer(MessageBuffer&& other) noexcept;
+
+  MessageBuffer& operator=(const MessageBuffer& other);
+  MessageBuffer& operator=(MessageBuffer&& other) noexcept;
+
+  ~MessageBuffer();
+
+  uint8_t* data();
+
+  const uint8_t* data() const;
+
+  size_t size() const;
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  /// Reduce the size, when the message is shorter than requested to the pool.
+  void truncate(size_t size);
+
+private:
+  friend class MessageBufferPool;
+
+  struct Storage;
+
+  explicit MessageBuffer(Storage* storage) : _storage(storage)
+  {
+  }
+
+  void release();
+
+  Storage* _storage;
+};
+
+/**
+ * @brief Pool of MessageBuffers. Memory is allocated only when all the buffers are in
+ * use or when a message is larger than any previous one.
+ *
+ * acquire() can be called from any thread; the buffers can be released by a thread
+ * different from the one that acquired them. They remain valid even if the pool is
+ * destroyed first.
+ */
+class MessageBufferPool
+{
+public:
+  struct Statistics
+  {
+    /// Number of calls to acquire()
+    uint64_t acquired = 0;
+    /// Number of memory allocations done by acquire()
+    uint64_t allocations = 0;
+
+    double allocationsPerMessage() const
+    {
+      return acquired == 0 ? 0.0 : double(allocations) / double(acquired);
+    }
+  };
+
+  /// @param max_free_buffers  buffers released when this many are already free
+  ///                          are deleted, instead of being recycled.
+  explicit MessageBufferPool(size_t max_free_buffers = 64);
+
+  MessageBufferPool(const MessageBufferPool& other) = delete;
+  MessageBufferPool& operator=(const MessageBufferPool& other) = delete;
+
+  ~MessageBufferPool();
+
+  /// Buffer with the given size. Its content is not initialized.
+  MessageBuffer acquire(size_t size);
+
+  Statistics statistics() const;
+
+private:
+  friend class MessageBuffer;
+
+  struct State
+  {
+    std::mutex mutex;
+    std::vector<MessageBuffer::Storage*> free_buffers;
+    size_t max_free_buffers = 0;
+    bool closed = false;
+    std::atomic<uint64_t> acquired = { 0 };
+    std::atomic<uint64_t> allocations = { 0 };
+  };
+
+  std::shared_ptr<State> _state;
+};
+
+}  // namespace PJ
+
+#endif  // PJ_MESSAGE_BUFFER_H
@@ -10,6 +10,7 @@
 #include <set>
 #include "PlotJuggler/plotdata.h"
 #include "PlotJuggler/pj_plugin.h"
+#include "PlotJuggler/message_buffer.h"
 
 namespace PJ
 {
@@ -37,6 +38,12 @@ public:
   {
   }
 
+  /// The buffer must not be released before the message is parsed.
+  explicit MessageRef(MessageBuffer& buffer)
+    : _first_ptr(buffer.data()), _size(buffer.size())
+  {
+  }
+
   const uint8_t* data() const
   {
     return _first_ptr;
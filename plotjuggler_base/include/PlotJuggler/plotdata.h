@@ -38,6 +38,23 @@ struct PlotDataMapRef
    */
   std::unordered_map<std::string, PlotGroup::Ptr> groups;
 
+  /// Strings shared by all the series in "strings". Released by clear() and,
+  /// when they are not used anymore, by sweepStringPool().
+  std::shared_ptr<StringPool> string_pool = std::make_shared<StringPool>();
+
+  /// Time extent of the series in "numeric", updated when they change.
+  std::shared_ptr<TimeRangeIndex> time_range = std::make_shared<TimeRangeIndex>();
+
+  /**
+   * @brief If not empty, it is added to the name of the numeric and string series
+   * created (or searched) by the methods below, like AddPrefixToPlotData would do
+   * afterwards. Used to load a file without colliding with the series of another one.
+   */
+  std::string name_prefix;
+
+  /// The name of the series, with name_prefix.
+  std::string prefixedName(const std::string& name) const;
+
   PlotDataMap::iterator addNumeric(const std::string& name, PlotGroup::Ptr group = {});
 
   AnySeriesMap::iterator addUserDefined(const std::string& name,
@@ -62,6 +79,20 @@ struct PlotDataMapRef
   void setMaximumRangeX(double range);
 
   bool erase(const std::string& name);
+
+  /**
+   * @brief Release the strings of string_pool not used anymore by the series in
+   * "strings" (because they were cleared or trimmed): the others are moved into a
+   * new pool.
+   *
+   * The cost is proportional to the number of points. To amortize it, nothing is
+   * done until the pool has doubled its size since the previous sweep.
+   */
+  void sweepStringPool();
+
+private:
+  // string_pool->size() after the last sweepStringPool()
+  size_t _swept_pool_size = 0;
 };
 
 template <typename Value>
@@ -150,7 +150,11 @@ public:
   typedef typename std::deque<Point>::const_iterator ConstIterator;
 
   PlotDataBase(const std::string& name, PlotGroup::Ptr group)
-    : _name(name), _range_x_dirty(true), _range_y_dirty(true), _group(group)
+    : _name(name)
+    , _range_x_dirty(true)
+    , _range_y_dirty(true)
+    , _group(group)
+    , _generation(0)
   {
   }
 
@@ -182,6 +186,31 @@ public:
     return _points.size();
   }
 
+  /**
+   * @brief Counter incremented every time points are added or removed.
+   * Use it to know if the series changed since the last time you looked at it.
+   * Note that points modified in-place using at() are not tracked.
+   */
+  uint64_t generation() const
+  {
+    return _generation;
+  }
+
+  /**
+   * @brief Counter incremented when all the points are replaced at once (clear() or
+   * assignment). A cache built incrementally from the series must then be rebuilt.
+   */
+  uint64_t clearCount() const
+  {
+    return _clear_count;
+  }
+
+  /// Approximate number of bytes used to store the points of this series.
+  virtual size_t memoryUsage() const
+  {
+    return _points.size() * sizeof(Point);
+  }
+
   const Point& at(size_t index) const
   {
     return _points[index];
@@ -207,6 +236,8 @@ public:
     _points.clear();
     _range_x_dirty = true;
     _range_y_dirty = true;
+    _generation++;
+    _clear_count++;
   }
 
   void setAttribute(const std::string& name, const QVariant& value)
@@ -354,6 +385,7 @@ public:
     }
 
     _points.emplace_back(p);
+    _generation++;
   }
 
   virtual void insert(Iterator it, Point&& p)
@@ -376,6 +408,7 @@ public:
     }
 
     _points.insert(it, p);
+    _generation++;
   }
 
   virtual void popFront()
@@ -398,6 +431,7 @@ public:
       }
     }
     _points.pop_front();
+    _generation++;
   }
 
 protected:
@@ -410,6 +444,8 @@ protected:
   mutable bool _range_x_dirty;
   mutable bool _range_y_dirty;
   mutable std::shared_ptr<PlotGroup> _group;
+  uint64_t _generation;
+  uint64_t _clear_count = 0;
 
   // template specialization for types that support compare operator
   virtual void pushUpdateRangeX(const Point& p)
@@ -424,6 +460,7 @@ protected:
       }
       if (!_range_x_dirty)
       {
+        // a new point can only extend the range
         if (p.x > _range_x.max)
         {
           _range_x.max = p.x;
@@ -432,10 +469,6 @@ protected:
         {
           _range_x.min = p.x;
         }
-        else
-        {
-          _range_x_dirty = true;
-        }
       }
     }
   }
@@ -447,6 +480,7 @@ protected:
     {
       if (!_range_y_dirty)
       {
+        // a new point can only extend the range
         if (p.y > _range_y.max)
         {
           _range_y.max = p.y;
@@ -455,10 +489,6 @@ protected:
         {
           _range_y.min = p.y;
         }
-        else
-        {
-          _range_y_dirty = true;
-        }
       }
     }
   }
@@ -2,6 +2,7 @@
 #define PLOTWIDGET_BASE_H
 
 #include <QWidget>
+#include <functional>
 #include "plotdata.h"
 #include "timeseries_qwt.h"
 
@@ -34,6 +35,10 @@ public:
     std::string src_name;
     QwtPlotCurve* curve;
     QwtPlotMarker* marker;
+    // value of QwtSeriesWrapper::dataGeneration() when the cache was updated
+    uint64_t data_generation = 0;
+    // includes src_name in PlotDataMapRef::time_range->viewedRange()
+    std::shared_ptr<TimeRangeIndex::Viewer> time_range_viewer;
   };
 
   PlotWidgetBase(QWidget* parent);
@@ -94,6 +99,20 @@ public:
 
   void setAcceptDrops(bool accept);
 
+  /// Wait for the curves rendered in background (see Preferences::async_rendering).
+  /// Must be called before modifying the data displayed by any plot.
+  static void waitForRendering();
+
+  /// Run a function that reads the data in a background thread. Like the rendering,
+  /// it is cancelled and awaited by waitForRendering(): it must return as soon as
+  /// "cancelled" returns true. It must not throw.
+  static void runInBackground(
+      std::function<void(const std::function<bool()>& cancelled)> function);
+
+  /// Draw the curves in the GUI thread, even when Preferences::async_rendering is set.
+  /// Used while streaming: the plots are redrawn before a new image could be ready.
+  static void setBackgroundRendering(bool enabled);
+
 public slots:
 
   void replot();
@@ -0,0 +1,284 @@
+#ifndef PJ_SERIES_JOIN_H
+#define PJ_SERIES_JOIN_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <vector>
+#include "plotdata.h"
+
+namespace PJ
+{
+/// How the value of a series is computed at a time that may fall between two points.
+enum class JoinPolicy
+{
+  /// Value of the closest point. If two points are equally close, the newer one.
+  /// Same result as PlotData::getIndexFromX().
+  NEAREST,
+  /// Value of the newest point that is not newer than the time (sample and hold).
+  PREVIOUS,
+  /// Linear interpolation of the points before and after the time.
+  LINEAR,
+  /// Value of the first point with the same time. None if there is no such point.
+  EXACT
+};
+
+/**
+ * @brief Value of a series at a sequence of non-decreasing times (as-of join).
+ *
+ * The first lookup is a binary search, the following ones move the cursor forward.
+ * Aligning M times to a series with N points costs O(M + N), instead of the
+ * O(M log N) of calling getIndexFromX() for each of them.
+ *
+ * The series must not be modified while the cursor is in use.
+ */
+class SeriesCursor
+{
+public:
+  SeriesCursor(const PlotData& series, JoinPolicy policy)
+    : _series(&series), _policy(policy)
+  {
+  }
+
+  /**
+   * Value of the series at time t. It is std::nullopt if the series is empty or if,
+   * with PREVIOUS, t is older than the first point or, with LINEAR, t is outside the
+   * time range of the series or, with EXACT, there is no point at time t.
+   *
+   * t must not be older than the one of the previous call.
+   */
+  std::optional<double> valueAt(double t)
+  {
+    seek(t);
+    const PlotData& series = *_series;
+    const size_t size = series.size();
+    if (size == 0)
+    {
+      return std::nullopt;
+    }
+    switch (_policy)
+    {
+      case JoinPolicy::NEAREST: {
+        if (_pos >= size)
+        {
+          return series[size - 1].y;
+        }
+        if (_pos > 0 && std::abs(series[_pos - 1].x - t) < std::abs(series[_pos].x - t))
+        {
+          return series[_pos - 1].y;
+        }
+        return series[_pos].y;
+      }
+      case JoinPolicy::PREVIOUS: {
+        if (_pos == 0)
+        {
+          return std::nullopt;
+        }
+        return series[_pos - 1].y;
+      }
+      case JoinPolicy::LINEAR: {
+        if (_pos >= size)
+        {
+          return std::nullopt;
+        }
+        const auto& next = series[_pos];
+        if (next.x == t)
+        {
+          return next.y;
+        }
+        if (_pos == 0)
+        {
+          return std::nullopt;
+        }
+        const auto& prev = series[_pos - 1];
+        const double ratio = (t - prev.x) / (next.x - prev.x);
+        return prev.y + ratio * (next.y - prev.y);
+      }
+      case JoinPolicy::EXACT: {
+        if (_pos < size && series[_pos].x == t)
+        {
+          return series[_pos].y;
+        }
+        return std::nullopt;
+      }
+    }
+    return std::nullopt;
+  }
+
+  /// False if the series has no point at or after time t: if the series is
+  /// streamed, its value at t may still change when new points are added.
+  bool reached(double t) const
+  {
+    return _series->size() > 0 && _series->back().x >= t;
+  }
+
+  const PlotData& series() const
+  {
+    return *_series;
+  }
+
+private:
+  // move _pos to the first point newer than t (PREVIOUS) or not older than t
+  void seek(double t)
+  {
+    const PlotData& series = *_series;
+    const bool include_equal = (_policy == JoinPolicy::PREVIOUS);
+    if (!_started)
+    {
+      _started = true;
+      auto it = include_equal ?
+                    std::upper_bound(series.begin(), series.end(), t, TimeLess) :
+                    std::lower_bound(series.begin(), series.end(), t, PointLess);
+      _pos = std::distance(series.begin(), it);
+      return;
+    }
+    const size_t size = series.size();
+    while (_pos < size && (series[_pos].x < t || (include_equal && series[_pos].x == t)))
+    {
+      _pos++;
+    }
+  }
+
+  static bool TimeLess(double t, const PlotData::Point& p)
+  {
+    return t < p.x;
+  }
+
+  static bool PointLess(const PlotData::Point& p, double t)
+  {
+    return p.x < t;
+  }
+
+  const PlotData* _series;
+  JoinPolicy _policy;
+  size_t _pos = 0;
+  bool _started = false;
+};
+
+/**
+ * @brief SeriesCursor applied to N series at once: the value of each of them at
+ * the times of another one (typically, the first source of a transform).
+ */
+class SeriesJoin
+{
+public:
+  SeriesJoin(const std::vector<const PlotData*>& series, JoinPolicy policy)
+  {
+    _cursors.reserve(series.size());
+    for (const PlotData* s : series)
+    {
+      _cursors.emplace_back(*s, policy);
+    }
+  }
+
+  size_t size() const
+  {
+    return _cursors.size();
+  }
+
+  SeriesCursor& cursor(size_t index)
+  {
+    return _cursors[index];
+  }
+
+  /// Write into values[i] the value of the i-th series at time t, or NaN if it has
+  /// none. Return false if at least one of them is NaN for that reason.
+  /// t must not be older than the one of the previous call.
+  bool valuesAt(double t, double* values)
+  {
+    bool all = true;
+    for (size_t i = 0; i < _cursors.size(); i++)
+    {
+      const auto value = _cursors[i].valueAt(t);
+      all = all && value.has_value();
+      values[i] = value.value_or(std::numeric_limits<double>::quiet_NaN());
+    }
+    return all;
+  }
+
+  /// True if all the series have a point at or after time t (see SeriesCursor).
+  bool reached(double t) const
+  {
+    return std::all_of(_cursors.begin(), _cursors.end(),
+                       [t](const SeriesCursor& c) { return c.reached(t); });
+  }
+
+private:
+  std::vector<SeriesCursor> _cursors;
+};
+
+/**
+ * @brief Merge join of N series: visits in chronological order the distinct times of
+ * their points in [time_start, time_end], and the point of each series at that time.
+ *
+ * Times closer than std::numeric_limits<double>::epsilon() are considered the same.
+ * If a series has more points with the same time, they are visited one at a time.
+ * Each step costs O(log N) for each series that has a point at that time.
+ *
+ * The compressed history of the series (see PlotData::archive()) is visited too,
+ * decoding one block at a time.
+ */
+class SeriesMergeJoin
+{
+public:
+  SeriesMergeJoin(const std::vector<const PlotData*>& series, double time_start,
+                  double time_end);
+
+  /// Move to the next time. Return false if there are no more points in range.
+  bool next();
+
+  double time() const
+  {
+    return _time;
+  }
+
+  /// Point of the i-th series at time(), nullptr if it has none. It is valid until
+  /// the next call of next().
+  const PlotData::Point* point(size_t index) const
+  {
+    return _row[index];
+  }
+
+private:
+  // sequential reader of the compressed history, followed by the points
+  struct Source
+  {
+    const PlotData* series;
+    size_t block;
+    std::optional<CompressedBlock::Reader> reader;
+    size_t pos;
+    // next point, valid if "available"
+    PlotData::Point point;
+    bool available;
+  };
+
+  // move source.point to the next point of the series
+  static void advance(Source& source);
+
+  struct Head
+  {
+    double x;
+    size_t series;
+    bool operator>(const Head& other) const
+    {
+      return x > other.x || (x == other.x && series > other.series);
+    }
+  };
+
+  void pushHead(size_t series);
+
+  std::vector<Source> _sources;
+  double _time_end;
+  // min-heap of the time of the next point of the series
+  std::vector<Head> _heads;
+  // copies of the points of the current row
+  std::vector<PlotData::Point> _row_points;
+  std::vector<const PlotData::Point*> _row;
+  std::vector<size_t> _row_series;
+  double _time = std::numeric_limits<double>::lowest();
+};
+
+}  // namespace PJ
+
+#endif  // PJ_SERIES_JOIN_H
@@ -0,0 +1,71 @@
+#ifndef PJ_STRING_POOL_H
+#define PJ_STRING_POOL_H
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include "PlotJuggler/string_ref_sso.h"
+
+namespace PJ
+{
+/**
+ * @brief Set of unique strings, shared by the StringSeries of a PlotDataMapRef.
+ *
+ * Each string is stored once and never moved: the StringRef returned by intern()
+ * is valid as long as the pool exists and clear() is not called.
+ * The lookup uses std::string_view, without any temporary copy of the string.
+ *
+ * The pool is not thread-safe; it is protected by the same mutex that
+ * protects the PlotDataMapRef that owns it.
+ */
+class StringPool
+{
+public:
+  StringPool() : _bytes(0)
+  {
+  }
+
+  StringPool(const StringPool& other) = delete;
+  StringPool& operator=(const StringPool& other) = delete;
+
+  StringRef intern(std::string_view str)
+  {
+    auto it = _index.find(str);
+    if (it == _index.end())
+    {
+      const std::string& stored = _storage.emplace_back(str);
+      // approximate size of the string and of the node of the index
+      _bytes += sizeof(std::string) + stored.capacity() + 3 * sizeof(void*);
+      it = _index.insert(std::string_view(stored)).first;
+    }
+    return StringRef(it->data(), it->size());
+  }
+
+  /// Number of unique strings.
+  size_t size() const
+  {
+    return _storage.size();
+  }
+
+  size_t memoryUsage() const
+  {
+    return _bytes + _index.bucket_count() * sizeof(void*);
+  }
+
+  void clear()
+  {
+    _index.clear();
+    _storage.clear();
+    _bytes = 0;
+  }
+
+private:
+  std::deque<std::string> _storage;
+  std::unordered_set<std::string_view> _index;
+  size_t _bytes;
+};
+
+}  // namespace PJ
+
+#endif  // PJ_STRING_POOL_H
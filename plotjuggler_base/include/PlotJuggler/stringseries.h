@@ -3,8 +3,9 @@
 
 #include "PlotJuggler/timeseries.h"
 #include "PlotJuggler/string_ref_sso.h"
+#include "PlotJuggler/string_pool.h"
 #include <algorithm>
-#include <unordered_set>
+#include <memory>
 
 namespace PJ
 {
@@ -14,7 +15,7 @@ public:
   using TimeseriesBase<StringRef>::_points;
 
   StringSeries(const std::string& name, PlotGroup::Ptr group)
-    : TimeseriesBase<StringRef>(name, group)
+    : TimeseriesBase<StringRef>(name, group), _pool(std::make_shared<StringPool>())
   {
   }
 
@@ -24,12 +25,53 @@ public:
   StringSeries& operator=(const StringSeries& other) = delete;
   StringSeries& operator=(StringSeries&& other) = default;
 
+  /**
+   * @brief Store the strings in a pool shared with other series (usually, the one of
+   * PlotDataMapRef). The strings already stored are moved into the new pool.
+   */
+  void setStringPool(std::shared_ptr<StringPool> pool)
+  {
+    if (!pool || pool == _pool)
+    {
+      return;
+    }
+    auto reintern = [&pool](Point& p) {
+      if (!p.y.isSSO())
+      {
+        p.y = pool->intern(std::string_view(p.y.data(), p.y.size()));
+      }
+    };
+    std::for_each(_points.begin(), _points.end(), reintern);
+    std::for_each(_reorder_buffer.begin(), _reorder_buffer.end(), reintern);
+    _pool = std::move(pool);
+  }
+
+  const std::shared_ptr<StringPool>& stringPool() const
+  {
+    return _pool;
+  }
+
   virtual void clear() override
   {
-    _storage.clear();
+    // a shared pool is released by its owner (see PlotDataMapRef::sweepStringPool)
+    if (_pool.use_count() == 1)
+    {
+      _pool->clear();
+    }
     TimeseriesBase<StringRef>::clear();
   }
 
+  size_t memoryUsage() const override
+  {
+    // short strings are stored inside StringRef, the others in the pool
+    size_t bytes = TimeseriesBase<StringRef>::memoryUsage();
+    if (_pool.use_count() == 1)
+    {
+      bytes += _pool->memoryUsage();
+    }
+    return bytes;
+  }
+
   void pushBack(const Point& p) override
   {
     auto temp = p;
@@ -51,22 +93,14 @@ public:
     }
     else
     {
-      // save a copy of the string in the flywheel structure _storage
-      // create a reference to that cached value.
-      _tmp_str.assign(str.data(), str.size());
-
-      auto it = _storage.find(_tmp_str);
-      if (it == _storage.end())
-      {
-        it = _storage.insert(_tmp_str).first;
-      }
-      TimeseriesBase<StringRef>::pushBack({ p.x, StringRef(*it) });
+      // store the string in the pool (once) and reference that value.
+      const StringRef ref = _pool->intern(std::string_view(str.data(), str.size()));
+      TimeseriesBase<StringRef>::pushBack({ p.x, ref });
     }
   }
 
 private:
-  std::string _tmp_str;
-  std::unordered_set<std::string> _storage;
+  std::shared_ptr<StringPool> _pool;
 };
 
 }  // namespace PJ
@@ -0,0 +1,136 @@
+#ifndef PJ_TIME_RANGE_INDEX_H
+#define PJ_TIME_RANGE_INDEX_H
+
+#include <limits>
+#include <memory>
+#include <optional>
+#include <set>
+#include <vector>
+#include "PlotJuggler/plotdatabase.h"
+
+namespace PJ
+{
+/**
+ * @brief Time extent (time of the first and last point) of a set of series, updated
+ * by the series themselves when they change (see TimeseriesBase::setTimeRangeIndex).
+ *
+ * Two extents are available: the one of all the series and the one of the series
+ * displayed by at least one plot (see Viewer).
+ *
+ * A query costs O(log N) for each series modified since the previous one, instead of
+ * visiting all the series. Not thread safe: the index must be used by the thread that
+ * modifies its series.
+ */
+class TimeRangeIndex : public std::enable_shared_from_this<TimeRangeIndex>
+{
+  struct Extent
+  {
+    double front = 0;
+    double back = 0;
+    size_t size = 0;
+  };
+
+public:
+  /// Owned by the series. Use TimeRangeIndex::createEntry().
+  class Entry
+  {
+  public:
+    explicit Entry(std::shared_ptr<TimeRangeIndex> index);
+
+    Entry(const Entry& other) = delete;
+    Entry& operator=(const Entry& other) = delete;
+
+    ~Entry();
+
+    /// Called when the points of the series change. Cheap enough to be called at
+    /// each pushBack().
+    void update(double front, double back, size_t size)
+    {
+      _current = { front, back, size };
+      markDirty();
+    }
+
+    /// The series is empty (or destroyed).
+    void reset()
+    {
+      _current = {};
+      markDirty();
+    }
+
+  private:
+    friend class TimeRangeIndex;
+    friend class Viewer;
+
+    void markDirty()
+    {
+      if (_dirty_slot == NOT_DIRTY)
+      {
+        _dirty_slot = _index->_dirty.size();
+        _index->_dirty.push_back(this);
+      }
+    }
+
+    static constexpr size_t NOT_DIRTY = std::numeric_limits<size_t>::max();
+
+    std::shared_ptr<TimeRangeIndex> _index;
+    Extent _current;
+    // values stored into the index (size 0 if none)
+    Extent _indexed;
+    bool _indexed_viewed = false;
+    int _viewers = 0;
+    // position in TimeRangeIndex::_dirty, to be removed in O(1) when destroyed
+    size_t _dirty_slot = NOT_DIRTY;
+  };
+
+  /// Marks a series as displayed, while it exists.
+  class Viewer
+  {
+  public:
+    explicit Viewer(std::shared_ptr<Entry> entry);
+
+    Viewer(const Viewer& other) = delete;
+    Viewer& operator=(const Viewer& other) = delete;
+
+    ~Viewer();
+
+  private:
+    std::shared_ptr<Entry> _entry;
+  };
+
+  std::shared_ptr<Entry> createEntry();
+
+  /// Extent of all the series. Empty if all of them are empty.
+  RangeOpt range();
+
+  /// Largest number of points in a series.
+  size_t maxSize();
+
+  /// Extent of the series with at least one Viewer.
+  RangeOpt viewedRange();
+
+  size_t viewedMaxSize();
+
+private:
+  struct ExtentSet
+  {
+    std::multiset<double> fronts;
+    std::multiset<double> backs;
+    std::multiset<size_t> sizes;
+
+    void insert(const Extent& extent);
+    void erase(const Extent& extent);
+    RangeOpt range() const;
+    size_t maxSize() const;
+  };
+
+  void refresh();
+  void removeIndexed(Entry* entry);
+
+  ExtentSet _all;
+  ExtentSet _viewed;
+  std::vector<Entry*> _dirty;
+};
+
+}  // namespace PJ
+
+#endif  // PJ_TIME_RANGE_INDEX_H
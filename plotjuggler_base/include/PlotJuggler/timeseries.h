@@ -2,7 +2,13 @@
 #define PJ_TIMESERIES_H
 
 #include "plotdatabase.h"
+#include "compressed_series.h"
+#include "time_range_index.h"
 #include <algorithm>
+#include <cmath>
+#include <deque>
+#include <iterator>
+#include <vector>
 
 namespace PJ
 {
@@ -13,12 +19,58 @@ protected:
   double _max_range_x;
   using PlotDataBase<double, Value>::_points;
 
+  // samples older than back(), waiting to be merged into _points
+  std::vector<typename PlotDataBase<double, Value>::Point> _reorder_buffer;
+  double _reorder_lateness;
+  double _reorder_min_x;
+
+  double _compacted_until;
+  double _compacted_resolution;
+  // all the points older than this were compacted with _compacted_resolution
+  double _compacted_uniform_until;
+
+  // history older than _points, see compressHistory()
+  CompressedSeries _archive;
+
+  // see setTimeRangeIndex()
+  std::shared_ptr<TimeRangeIndex::Entry> _time_range;
+
+  // number of HistoryPin alive, see pinHistory(). Shared with them, because the
+  // series may be moved.
+  mutable std::shared_ptr<int> _history_pins;
+
 public:
   using Point = typename PlotDataBase<double, Value>::Point;
 
+  /// Created by pinHistory().
+  class HistoryPin
+  {
+  public:
+    explicit HistoryPin(std::shared_ptr<int> count) : _count(std::move(count))
+    {
+      (*_count)++;
+    }
+
+    HistoryPin(const HistoryPin& other) = delete;
+    HistoryPin& operator=(const HistoryPin& other) = delete;
+
+    ~HistoryPin()
+    {
+      (*_count)--;
+    }
+
+  private:
+    std::shared_ptr<int> _count;
+  };
+
   TimeseriesBase(const std::string& name, PlotGroup::Ptr group)
     : PlotDataBase<double, Value>(name, group)
     , _max_range_x(std::numeric_limits<double>::max())
+    , _reorder_lateness(-1)
+    , _reorder_min_x(std::numeric_limits<double>::max())
+    , _compacted_until(-std::numeric_limits<double>::max())
+    , _compacted_resolution(0)
+    , _compacted_uniform_until(-std::numeric_limits<double>::max())
   {
   }
 
@@ -28,16 +80,81 @@ public:
   TimeseriesBase& operator=(const TimeseriesBase& other) = delete;
   TimeseriesBase& operator=(TimeseriesBase&& other) = default;
 
+  ~TimeseriesBase() override
+  {
+    // the entry may be kept alive by a Viewer
+    if (_time_range)
+    {
+      _time_range->reset();
+    }
+  }
+
+  /**
+   * @brief Keep the time extent of this series in an index, usually the one of the
+   * PlotDataMapRef that contains it (see PlotDataMapRef::time_range).
+   */
+  void setTimeRangeIndex(const std::shared_ptr<TimeRangeIndex>& index)
+  {
+    if (_time_range)
+    {
+      _time_range->reset();
+    }
+    _time_range = index ? index->createEntry() : nullptr;
+    updateTimeRange();
+  }
+
+  /// Null if setTimeRangeIndex() was not called.
+  std::shared_ptr<TimeRangeIndex::Viewer> createTimeRangeViewer() const
+  {
+    return _time_range ? std::make_shared<TimeRangeIndex::Viewer>(_time_range) :
+                         nullptr;
+  }
+
+  /**
+   * @brief Keep all the history in the points while the returned object exists:
+   * compressHistory() doesn't compress a pinned series.
+   *
+   * Taken by the derived series (transforms, XY curves...) that read their sources
+   * by index from the first point. A series pinned when its history is already
+   * compressed must be restored with restoreHistory() by the owner of the data.
+   */
+  std::shared_ptr<HistoryPin> pinHistory() const
+  {
+    if (!_history_pins)
+    {
+      _history_pins = std::make_shared<int>(0);
+    }
+    return std::make_shared<HistoryPin>(_history_pins);
+  }
+
+  bool historyPinned() const
+  {
+    return _history_pins && *_history_pins > 0;
+  }
+
   void clone(const TimeseriesBase& other)
   {
     _max_range_x = other._max_range_x;
     _points = other._points;
+    _reorder_buffer = other._reorder_buffer;
+    _reorder_lateness = other._reorder_lateness;
+    _reorder_min_x = other._reorder_min_x;
+    _compacted_until = other._compacted_until;
+    _compacted_resolution = other._compacted_resolution;
+    _compacted_uniform_until = other._compacted_uniform_until;
+    _archive = other._archive;
+    this->_range_x_dirty = true;
+    this->_range_y_dirty = true;
+    this->_generation++;
+    this->_clear_count++;
+    updateTimeRange();
   }
 
   void setMaximumRangeX(double max_range)
   {
     _max_range_x = max_range;
     trimRange();
+    updateTimeRange();
   }
 
   double maximumRangeX() const
@@ -45,10 +162,135 @@ public:
     return _max_range_x;
   }
 
+  /**
+   * @brief Samples older than back() are not inserted one by one (that is O(N) for
+   * each sample). They are kept in a buffer and merged in a single pass once the
+   * oldest of them is older than back() by more than "lateness" seconds.
+   *
+   * Until then, they are not visible. A negative value (default) disables the
+   * buffer: late samples are inserted immediately.
+   */
+  void setReorderWindow(double lateness)
+  {
+    _reorder_lateness = lateness;
+    mergeExpiredSamples();
+  }
+
+  double reorderWindow() const
+  {
+    return _reorder_lateness;
+  }
+
+  /// Number of late samples waiting to be merged.
+  size_t pendingSamples() const
+  {
+    return _reorder_buffer.size();
+  }
+
+  /// Merge all the late samples, regardless of the reorder window.
+  void flushReorderBuffer();
+
+  void clear() override
+  {
+    _reorder_buffer.clear();
+    _reorder_min_x = std::numeric_limits<double>::max();
+    _compacted_until = -std::numeric_limits<double>::max();
+    _compacted_resolution = 0;
+    _compacted_uniform_until = -std::numeric_limits<double>::max();
+    _archive.clear();
+    PlotDataBase<double, Value>::clear();
+    updateTimeRange();
+  }
+
+  size_t memoryUsage() const override
+  {
+    return PlotDataBase<double, Value>::memoryUsage() +
+           _reorder_buffer.capacity() * sizeof(Point) + _archive.memoryUsage();
+  }
+
+  RangeOpt rangeX() const override
+  {
+    return MergeRanges(_archive.rangeX(), PlotDataBase<double, Value>::rangeX());
+  }
+
+  RangeOpt rangeY() const override
+  {
+    return MergeRanges(_archive.rangeY(), PlotDataBase<double, Value>::rangeY());
+  }
+
+  /**
+   * @brief Move the points older than before_x into a compressed (lossless) history.
+   *
+   * The compressed points are not accessible through at(), begin() or end() and they
+   * are not counted by size(); use archive() to read them. The last two points are
+   * never compressed. Only series of double can be compressed.
+   *
+   * Code that reads the series by index from the first point (e.g. a transform
+   * computed from scratch) must pin it, see pinHistory(). Pinned series are not
+   * compressed.
+   *
+   * @return number of points moved.
+   */
+  size_t compressHistory(double before_x);
+
+  /// Move the history compressed by compressHistory() back into the points.
+  /// @return number of points restored.
+  size_t restoreHistory();
+
+  /// History compressed by compressHistory(). All its points are older than front().
+  const CompressedSeries& archive() const
+  {
+    return _archive;
+  }
+
+  /// Time of the oldest point, including the compressed history.
+  double frontX() const
+  {
+    return _archive.empty() ? this->front().x : _archive.blocks().front().firstX();
+  }
+
+  /**
+   * @brief Reduce the resolution of the points older than before_x.
+   *
+   * Points are grouped in intervals of "resolution" seconds and each group is
+   * replaced by its minimum and maximum, in their original order. The envelope
+   * and the range Y of the curve are preserved, using at most two points per interval.
+   * Only series with numeric values can be compacted.
+   *
+   * Calling it again with the same resolution visits only the points that were not
+   * compacted yet. The history that is not compressed is compacted in place: the
+   * points newer than before_x are not moved.
+   *
+   * @return number of points removed.
+   */
+  size_t compact(double before_x, double resolution);
+
+  /// Points older than this time have been compacted by compact().
+  double compactedUntil() const
+  {
+    return _compacted_until;
+  }
+
+  /// Coarsest resolution used by compact(), 0 if the series was never compacted.
+  double compactedResolution() const
+  {
+    return _compacted_resolution;
+  }
+
   int getIndexFromX(double x) const;
 
   std::optional<Value> getYfromX(double x) const
   {
+    if constexpr (std::is_same_v<Value, double>)
+    {
+      if (!_archive.empty() && x < _points.front().x)
+      {
+        // the series may be read by several threads at once
+        thread_local CompressedSeries::Cursor cursor;
+        const int index = cursor.indexFromX(_archive, x);
+        return cursor.at(_archive, size_t(index)).y;
+      }
+    }
     int index = getIndexFromX(x);
     return (index < 0) ? std::nullopt : std::optional(_points[index].y);
   }
@@ -63,7 +305,12 @@ public:
   {
     bool need_sorting = (!_points.empty() && p.x < this->back().x);
 
-    if (need_sorting)
+    if (need_sorting && _reorder_lateness >= 0)
+    {
+      _reorder_min_x = std::min(_reorder_min_x, p.x);
+      _reorder_buffer.push_back(std::move(p));
+    }
+    else if (need_sorting)
     {
       auto it = std::upper_bound(_points.begin(), _points.end(), p, TimeCompare);
       PlotDataBase<double, Value>::insert(it, std::move(p));
@@ -72,12 +319,54 @@ public:
     {
       PlotDataBase<double, Value>::pushBack(std::move(p));
     }
+    mergeExpiredSamples();
     trimRange();
+    updateTimeRange();
   }
 
 private:
+  void updateTimeRange()
+  {
+    if (_time_range)
+    {
+      if (_points.empty())
+      {
+        _time_range->reset();
+      }
+      else
+      {
+        _time_range->update(frontX(), _points.back().x, _points.size());
+      }
+    }
+  }
+
+  void mergeExpiredSamples()
+  {
+    if (!_reorder_buffer.empty() &&
+        (_reorder_lateness < 0 || _reorder_buffer.size() >= MAX_REORDER_BUFFER ||
+         (this->back().x - _reorder_min_x) > _reorder_lateness))
+    {
+      flushReorderBuffer();
+    }
+  }
+
+  static constexpr size_t MAX_REORDER_BUFFER = 4096;
+
   void trimRange()
   {
+    if (!_archive.empty())
+    {
+      // the compressed history is removed one block at a time, before any
+      // point of _points
+      if (_archive.trimBefore(_points.back().x - _max_range_x) > 0)
+      {
+        this->_generation++;
+      }
+      if (!_archive.empty())
+      {
+        return;
+      }
+    }
     while (_points.size() > 2 && (_points.back().x - _points.front().x) > _max_range_x)
     {
       this->popFront();
@@ -88,10 +377,282 @@ private:
   {
     return a.x < b.x;
   }
+
+  static RangeOpt MergeRanges(const RangeOpt& a, const RangeOpt& b)
+  {
+    if (!a || !b)
+    {
+      return a ? a : b;
+    }
+    return Range{ std::min(a->min, b->min), std::max(a->max, b->max) };
+  }
 };
 
 //--------------------
 
+template <typename Value>
+inline void TimeseriesBase<Value>::flushReorderBuffer()
+{
+  if (_reorder_buffer.empty())
+  {
+    return;
+  }
+  // stable: samples with the same time are kept in the order they were received
+  std::stable_sort(_reorder_buffer.begin(), _reorder_buffer.end(), TimeCompare);
+
+  // the samples newer than the oldest late one are removed and pushed again,
+  // merged with the late ones.
+  auto first = std::upper_bound(_points.begin(), _points.end(), _reorder_buffer.front(),
+                                TimeCompare);
+  std::vector<Point> tail(std::make_move_iterator(first),
+                          std::make_move_iterator(_points.end()));
+  _points.erase(first, _points.end());
+
+  std::vector<Point> merged;
+  merged.reserve(tail.size() + _reorder_buffer.size());
+  std::merge(std::make_move_iterator(tail.begin()), std::make_move_iterator(tail.end()),
+             std::make_move_iterator(_reorder_buffer.begin()),
+             std::make_move_iterator(_reorder_buffer.end()), std::back_inserter(merged),
+             TimeCompare);
+  _reorder_buffer.clear();
+  _reorder_min_x = std::numeric_limits<double>::max();
+
+  for (auto& p : merged)
+  {
+    PlotDataBase<double, Value>::pushBack(std::move(p));
+  }
+  trimRange();
+  updateTimeRange();
+}
+
+template <typename Value>
+inline size_t TimeseriesBase<Value>::compressHistory(double before_x)
+{
+  if constexpr (!std::is_same_v<Value, double>)
+  {
+    return 0;
+  }
+  else
+  {
+    if (historyPinned())
+    {
+      return 0;
+    }
+    // late samples waiting in the reorder buffer must be merged after the history
+    before_x = std::min(before_x, _reorder_min_x);
+    if (_points.size() <= 2)
+    {
+      return 0;
+    }
+    auto end_it = std::lower_bound(_points.begin(), _points.end(), Point(before_x, {}),
+                                   TimeCompare);
+    end_it = std::min(end_it, _points.end() - 2);
+    if (end_it <= _points.begin())
+    {
+      return 0;
+    }
+    for (auto it = _points.begin(); it != end_it; it++)
+    {
+      _archive.pushBack(it->x, it->y);
+    }
+    const size_t moved = std::distance(_points.begin(), end_it);
+    _points.erase(_points.begin(), end_it);
+
+    this->_range_x_dirty = true;
+    this->_range_y_dirty = true;
+    this->_generation++;
+    updateTimeRange();
+    return moved;
+  }
+}
+
+template <typename Value>
+inline size_t TimeseriesBase<Value>::restoreHistory()
+{
+  if constexpr (!std::is_same_v<Value, double>)
+  {
+    return 0;
+  }
+  else
+  {
+    if (_archive.empty())
+    {
+      return 0;
+    }
+    std::vector<Point> history;
+    history.reserve(_archive.size());
+    for (const auto& block : _archive.blocks())
+    {
+      block.decode(history);
+    }
+    _archive.clear();
+    _points.insert(_points.begin(), history.begin(), history.end());
+
+    this->_range_x_dirty = true;
+    this->_range_y_dirty = true;
+    this->_generation++;
+    updateTimeRange();
+    return history.size();
+  }
+}
+
+template <typename Value>
+inline size_t TimeseriesBase<Value>::compact(double before_x, double resolution)
+{
+  if constexpr (!std::is_arithmetic_v<Value>)
+  {
+    return 0;
+  }
+  else
+  {
+    if (!(resolution > 0))
+    {
+      return 0;
+    }
+    // if the history is compressed, the result is compressed too
+    const bool archived = !_archive.empty();
+
+    auto end_it = std::lower_bound(_points.begin(), _points.end(), Point(before_x, {}),
+                                   TimeCompare);
+    if (archived)
+    {
+      // like compressHistory(), keep the last two points
+      end_it = (_points.size() > 2) ? std::min(end_it, _points.end() - 2) :
+                                      _points.begin();
+    }
+    auto begin_it = _points.begin();
+    if (!archived && resolution == _compacted_resolution)
+    {
+      // the intervals that end before _compacted_uniform_until have at most two
+      // points already
+      const double start_x =
+          std::floor(_compacted_uniform_until / resolution) * resolution;
+      begin_it = std::lower_bound(begin_it, end_it, Point(start_x, {}), TimeCompare);
+    }
+    const size_t input_count = _archive.size() + std::distance(begin_it, end_it);
+    if (input_count < 3)
+    {
+      return 0;
+    }
+    CompressedSeries compacted_archive;
+    // the output is never ahead of the point being read: it can overwrite _points
+    auto output_it = begin_it;
+    size_t output_count = 0;
+    auto output = [&](const Point& p) {
+      if (archived)
+      {
+        compacted_archive.pushBack(p.x, double(p.y));
+      }
+      else
+      {
+        *output_it = p;
+        output_it++;
+      }
+      output_count++;
+    };
+
+    // minimum and maximum of the current interval, with their position in the sequence
+    double interval_end = 0;
+    Point min_point, max_point;
+    size_t min_pos = 0, max_pos = 0, pos = 0;
+    bool open = false;
+
+    auto close_interval = [&]() {
+      if (open)
+      {
+        output((min_pos <= max_pos) ? min_point : max_point);
+        if (min_pos != max_pos)
+        {
+          output((min_pos <= max_pos) ? max_point : min_point);
+        }
+        open = false;
+      }
+    };
+
+    auto add = [&](const Point& p) {
+      if (open && p.x < interval_end)
+      {
+        if (p.y < min_point.y)
+        {
+          min_point = p;
+          min_pos = pos;
+        }
+        if (p.y > max_point.y)
+        {
+          max_point = p;
+          max_pos = pos;
+        }
+      }
+      else
+      {
+        close_interval();
+        interval_end = (std::floor(p.x / resolution) + 1.0) * resolution;
+        min_point = max_point = p;
+        min_pos = max_pos = pos;
+        open = true;
+      }
+      pos++;
+    };
+
+    if (archived)
+    {
+      CompressedSeries::Reader reader(_archive);
+      CompressedSeries::Point p;
+      while (reader.next(p))
+      {
+        if (p.x < before_x)
+        {
+          add(Point(p.x, static_cast<Value>(p.y)));
+        }
+        else
+        {
+          close_interval();
+          output(Point(p.x, static_cast<Value>(p.y)));
+        }
+      }
+    }
+    for (auto it = begin_it; it != end_it; it++)
+    {
+      add(*it);
+    }
+    close_interval();
+
+    if (resolution > _compacted_resolution)
+    {
+      _compacted_uniform_until = before_x;
+    }
+    else if (resolution == _compacted_resolution)
+    {
+      _compacted_uniform_until = std::max(_compacted_uniform_until, before_x);
+    }
+    _compacted_until = std::max(_compacted_until, before_x);
+    _compacted_resolution = std::max(_compacted_resolution, resolution);
+
+    const size_t removed = input_count - output_count;
+    if (removed == 0)
+    {
+      return 0;
+    }
+    if (archived)
+    {
+      _archive = std::move(compacted_archive);
+      _points.erase(_points.begin(), end_it);
+      this->_range_y_dirty = true;
+    }
+    else
+    {
+      // only the points older than output_it are moved
+      _points.erase(output_it, end_it);
+    }
+
+    // the first point may have been removed
+    this->_range_x_dirty = true;
+    this->_generation++;
+    updateTimeRange();
+    return removed;
+  }
+}
+
 template <typename Value>
 inline int TimeseriesBase<Value>::getIndexFromX(double x) const
 {
@@ -112,7 +673,8 @@ inline int TimeseriesBase<Value>::getIndexFromX(double x) const
     return 0;
   }
 
-  if (index > 0 && (abs(_points[index - 1].x - x) < abs(_points[index].x - x)))
+  if (index > 0 &&
+      (std::abs(_points[index - 1].x - x) < std::abs(_points[index].x - x)))
   {
     index = index - 1;
   }
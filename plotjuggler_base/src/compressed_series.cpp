@@ -0,0 +1,502 @@
+#include "PlotJuggler/compressed_series.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace PJ
+{
+namespace
+{
+uint64_t ToBits(double value)
+{
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+double FromBits(uint64_t bits)
+{
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// value must not be zero
+int LeadingZeros(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_clzll(value);
+#else
+  int count = 0;
+  for (uint64_t mask = uint64_t(1) << 63; (value & mask) == 0; mask >>= 1)
+  {
+    count++;
+  }
+  return count;
+#endif
+}
+
+// value must not be zero
+int TrailingZeros(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(value);
+#else
+  int count = 0;
+  for (uint64_t mask = 1; (value & mask) == 0; mask <<= 1)
+  {
+    count++;
+  }
+  return count;
+#endif
+}
+
+// delta-of-delta buckets: number of bits of the zigzag-encoded value.
+// The prefix identifying each bucket is 0, 10, 110, 1110 and 1111.
+const int DOD_BITS[] = { 8, 14, 20, 64 };
+
+uint64_t ZigZag(int64_t value)
+{
+  return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value)
+{
+  return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+// revisions are unique across all the series, so that a Cursor can never
+// confuse a series with another one allocated at the same address.
+uint64_t NextRevision()
+{
+  static std::atomic<uint64_t> counter(0);
+  return ++counter;
+}
+
+}  // namespace
+
+CompressedBlock::CompressedBlock()
+  : _bit_count(0)
+  , _size(0)
+  , _first_x(0)
+  , _first_y(0)
+  , _last_x(0)
+  , _range_y({ 0, 0 })
+  , _prev_x(0)
+  , _prev_delta(0)
+  , _prev_y(0)
+  , _prev_leading(-1)
+  , _prev_trailing(0)
+{
+}
+
+void CompressedBlock::writeBits(uint64_t value, int count)
+{
+  if (count < 64)
+  {
+    value &= (uint64_t(1) << count) - 1;
+  }
+  const int used = _bit_count % 64;
+  if (used == 0)
+  {
+    _words.push_back(0);
+  }
+  _words.back() |= value << used;
+  const int available = 64 - used;
+  if (count > available)
+  {
+    _words.push_back(value >> available);
+  }
+  _bit_count += count;
+}
+
+void CompressedBlock::pushBack(double x, double y)
+{
+  const uint64_t x_bits = ToBits(x);
+  const uint64_t y_bits = ToBits(y);
+
+  if (_size == 0)
+  {
+    // the first point is stored uncompressed
+    _first_x = x;
+    _first_y = y;
+    _range_y = { y, y };
+    _prev_x = x_bits;
+    _prev_y = y_bits;
+    _prev_delta = 0;
+    _last_x = x;
+    _size = 1;
+    return;
+  }
+
+  //------ timestamp ------
+  const int64_t delta = int64_t(x_bits - _prev_x);
+  const uint64_t dod = ZigZag(int64_t(uint64_t(delta) - uint64_t(_prev_delta)));
+  if (dod == 0)
+  {
+    writeBits(0, 1);
+  }
+  else
+  {
+    for (int bucket = 0; bucket < 4; bucket++)
+    {
+      const int bits = DOD_BITS[bucket];
+      if (bits == 64 || dod < (uint64_t(1) << bits))
+      {
+        // prefix: "bucket+1" ones, followed by a zero (except for the last bucket)
+        const int prefix_length = (bucket < 3) ? bucket + 2 : 4;
+        const uint64_t prefix = (uint64_t(1) << (bucket + 1)) - 1;
+        writeBits(prefix, prefix_length);
+        writeBits(dod, bits);
+        break;
+      }
+    }
+  }
+  _prev_delta = delta;
+  _prev_x = x_bits;
+
+  //------ value ------
+  const uint64_t xor_value = y_bits ^ _prev_y;
+  if (xor_value == 0)
+  {
+    writeBits(0, 1);
+  }
+  else
+  {
+    writeBits(1, 1);
+    const int leading = LeadingZeros(xor_value);
+    const int trailing = TrailingZeros(xor_value);
+    if (_prev_leading >= 0 && leading >= _prev_leading && trailing >= _prev_trailing)
+    {
+      // the meaningful bits fit in the window of the previous value
+      writeBits(0, 1);
+      writeBits(xor_value >> _prev_trailing, 64 - _prev_leading - _prev_trailing);
+    }
+    else
+    {
+      const int length = 64 - leading - trailing;
+      writeBits(1, 1);
+      writeBits(leading, 6);
+      writeBits(length - 1, 6);
+      writeBits(xor_value >> trailing, length);
+      _prev_leading = leading;
+      _prev_trailing = trailing;
+    }
+  }
+  _prev_y = y_bits;
+
+  _last_x = x;
+  _range_y.min = std::min(_range_y.min, y);
+  _range_y.max = std::max(_range_y.max, y);
+  _size++;
+}
+
+size_t CompressedBlock::memoryUsage() const
+{
+  return sizeof(CompressedBlock) + _words.capacity() * sizeof(uint64_t);
+}
+
+void CompressedBlock::shrinkToFit()
+{
+  _words.shrink_to_fit();
+}
+
+void CompressedBlock::decode(std::vector<Point>& output) const
+{
+  output.reserve(output.size() + _size);
+  Reader reader(*this);
+  Point point;
+  while (reader.next(point))
+  {
+    output.push_back(point);
+  }
+}
+
+//-----------------------------------------------
+
+CompressedBlock::Reader::Reader(const CompressedBlock& block)
+  : _block(&block)
+  , _index(0)
+  , _bit_pos(0)
+  , _prev_x(0)
+  , _prev_delta(0)
+  , _prev_y(0)
+  , _prev_leading(0)
+  , _prev_trailing(0)
+{
+}
+
+uint64_t CompressedBlock::Reader::readBits(int count)
+{
+  const auto& words = _block->_words;
+  const size_t word = _bit_pos / 64;
+  const int used = _bit_pos % 64;
+  uint64_t value = words[word] >> used;
+  const int available = 64 - used;
+  if (count > available)
+  {
+    value |= words[word + 1] << available;
+  }
+  if (count < 64)
+  {
+    value &= (uint64_t(1) << count) - 1;
+  }
+  _bit_pos += count;
+  return value;
+}
+
+bool CompressedBlock::Reader::next(Point& point)
+{
+  if (_index >= _block->_size)
+  {
+    return false;
+  }
+  if (_index == 0)
+  {
+    point.x = _block->_first_x;
+    point.y = _block->_first_y;
+    _prev_x = ToBits(point.x);
+    _prev_y = ToBits(point.y);
+    _index++;
+    return true;
+  }
+
+  //------ timestamp ------
+  int bucket = 0;
+  while (bucket < 4 && readBits(1) == 1)
+  {
+    bucket++;
+  }
+  int64_t dod = 0;
+  if (bucket > 0)
+  {
+    dod = UnZigZag(readBits(DOD_BITS[bucket - 1]));
+  }
+  _prev_delta = int64_t(uint64_t(_prev_delta) + uint64_t(dod));
+  _prev_x += uint64_t(_prev_delta);
+
+  //------ value ------
+  if (readBits(1) == 1)
+  {
+    if (readBits(1) == 1)
+    {
+      _prev_leading = int(readBits(6));
+      _prev_trailing = 64 - _prev_leading - (int(readBits(6)) + 1);
+    }
+    const int length = 64 - _prev_leading - _prev_trailing;
+    _prev_y ^= readBits(length) << _prev_trailing;
+  }
+
+  point.x = FromBits(_prev_x);
+  point.y = FromBits(_prev_y);
+  _index++;
+  return true;
+}
+
+//-----------------------------------------------
+
+CompressedSeries::CompressedSeries()
+  : _removed(0)
+  , _size(0)
+  , _revision(NextRevision())
+  , _range_y({ 0, 0 })
+  , _range_y_dirty(false)
+{
+}
+
+void CompressedSeries::pushBack(double x, double y)
+{
+  if (_blocks.empty() || _blocks.back().full())
+  {
+    if (!_blocks.empty())
+    {
+      _blocks.back().shrinkToFit();
+    }
+    _block_offsets.push_back(_removed + _size);
+    _blocks.emplace_back();
+  }
+  _blocks.back().pushBack(x, y);
+
+  if (_size == 0)
+  {
+    _range_y = { y, y };
+    _range_y_dirty = false;
+  }
+  else if (!_range_y_dirty)
+  {
+    _range_y.min = std::min(_range_y.min, y);
+    _range_y.max = std::max(_range_y.max, y);
+  }
+  _size++;
+  _revision = NextRevision();
+}
+
+void CompressedSeries::clear()
+{
+  _blocks.clear();
+  _block_offsets.clear();
+  _removed = 0;
+  _size = 0;
+  _range_y_dirty = false;
+  _revision = NextRevision();
+}
+
+size_t CompressedSeries::memoryUsage() const
+{
+  size_t bytes = _block_offsets.size() * sizeof(size_t);
+  for (const auto& block : _blocks)
+  {
+    bytes += block.memoryUsage();
+  }
+  return bytes;
+}
+
+RangeOpt CompressedSeries::rangeX() const
+{
+  if (_blocks.empty())
+  {
+    return std::nullopt;
+  }
+  return Range{ _blocks.front().firstX(), _blocks.back().lastX() };
+}
+
+RangeOpt CompressedSeries::rangeY() const
+{
+  if (_blocks.empty())
+  {
+    return std::nullopt;
+  }
+  if (_range_y_dirty)
+  {
+    _range_y = _blocks.front().rangeY();
+    for (const auto& block : _blocks)
+    {
+      _range_y.min = std::min(_range_y.min, block.rangeY().min);
+      _range_y.max = std::max(_range_y.max, block.rangeY().max);
+    }
+    _range_y_dirty = false;
+  }
+  return _range_y;
+}
+
+size_t CompressedSeries::trimBefore(double x)
+{
+  size_t removed = 0;
+  while (!_blocks.empty() && _blocks.front().lastX() < x)
+  {
+    removed += _blocks.front().size();
+    _blocks.pop_front();
+    _block_offsets.pop_front();
+  }
+  if (removed > 0)
+  {
+    _removed += removed;
+    _size -= removed;
+    _range_y_dirty = true;
+    _revision = NextRevision();
+  }
+  return removed;
+}
+
+size_t CompressedSeries::blockFromIndex(size_t index) const
+{
+  // last block whose offset is not greater than the index
+  auto it = std::upper_bound(_block_offsets.begin(), _block_offsets.end(),
+                             index + _removed);
+  return std::distance(_block_offsets.begin(), it) - 1;
+}
+
+//-----------------------------------------------
+
+CompressedSeries::Reader::Reader(const CompressedSeries& series)
+  : _series(&series), _block_index(0)
+{
+}
+
+bool CompressedSeries::Reader::next(Point& point)
+{
+  while (_block_index < _series->_blocks.size())
+  {
+    if (!_block_reader)
+    {
+      _block_reader.emplace(_series->_blocks[_block_index]);
+    }
+    if (_block_reader->next(point))
+    {
+      return true;
+    }
+    _block_reader.reset();
+    _block_index++;
+  }
+  return false;
+}
+
+//-----------------------------------------------
+
+CompressedSeries::Cursor::Cursor()
+  : _series(nullptr), _revision(0), _block_index(0), _block_offset(0)
+{
+}
+
+void CompressedSeries::Cursor::load(const CompressedSeries& series, size_t block_index)
+{
+  _series = &series;
+  _revision = series._revision;
+  _block_index = block_index;
+  _block_offset = series._block_offsets[block_index] - series._removed;
+  _points.clear();
+  series._blocks[block_index].decode(_points);
+}
+
+const CompressedSeries::Point&
+CompressedSeries::Cursor::at(const CompressedSeries& series, size_t index)
+{
+  const bool valid = (_series == &series && _revision == series._revision);
+  if (!valid || index < _block_offset || index >= _block_offset + _points.size())
+  {
+    load(series, series.blockFromIndex(index));
+  }
+  return _points[index - _block_offset];
+}
+
+int CompressedSeries::Cursor::indexFromX(const CompressedSeries& series, double x)
+{
+  if (series.empty())
+  {
+    return -1;
+  }
+  const auto& blocks = series._blocks;
+  // first block whose last point is not older than x
+  auto it = std::lower_bound(blocks.begin(), blocks.end(), x,
+                             [](const CompressedBlock& block, double value) {
+                               return block.lastX() < value;
+                             });
+  if (it == blocks.end())
+  {
+    return int(series.size()) - 1;
+  }
+  const size_t block_index = std::distance(blocks.begin(), it);
+  const bool valid = (_series == &series && _revision == series._revision);
+  if (!valid || _block_index != block_index)
+  {
+    load(series, block_index);
+  }
+  auto lower = std::lower_bound(_points.begin(), _points.end(), x,
+                                [](const Point& p, double value) { return p.x < value; });
+  size_t index = _block_offset + std::distance(_points.begin(), lower);
+
+  // the previous point may be closer
+  if (index > 0)
+  {
+    const double prev_x = (lower != _points.begin()) ? std::prev(lower)->x :
+                                                       blocks[block_index - 1].lastX();
+    if (std::abs(prev_x - x) < std::abs(lower->x - x))
+    {
+      index--;
+    }
+  }
+  return int(index);
+}
+
+}  // namespace PJ
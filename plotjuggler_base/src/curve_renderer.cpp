@@ -0,0 +1,346 @@
+#include "curve_renderer.h"
+#include "timeseries_qwt.h"
+
+#include "qwt_plot_canvas.h"
+#include "qwt_series_data.h"
+
+#include <QRunnable>
+#include <QThreadPool>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace
+{
+// The jobs don't use QThreadPool::globalInstance(): they would be queued after the
+// QtConcurrent tasks of the application, and waitForIdle() would wait for those too.
+struct RenderWorkers
+{
+  QThreadPool pool;
+  std::mutex mutex;
+  std::condition_variable idle;
+  int running = 0;
+  // incremented by waitForIdle(). Jobs started before that are cancelled and their
+  // images are outdated.
+  std::atomic<uint64_t> epoch = { 0 };
+};
+
+RenderWorkers& Workers()
+{
+  static RenderWorkers workers;
+  return workers;
+}
+
+bool SameMap(const QwtScaleMap& a, const QwtScaleMap& b)
+{
+  return a.s1() == b.s1() && a.s2() == b.s2() && a.p1() == b.p1() && a.p2() == b.p2();
+}
+
+// The worker must not touch the original series: QwtSeriesWrapper::boundingRect() uses
+// a cache that is not thread safe and the size could change after the job started.
+class SeriesView : public QwtSeriesData<QPointF>
+{
+public:
+  SeriesView(const QwtSeriesData<QPointF>* series)
+    : _series(series), _size(series->size()), _bounding_rect(series->boundingRect())
+  {
+  }
+
+  size_t size() const override
+  {
+    return _size;
+  }
+
+  QPointF sample(size_t i) const override
+  {
+    return _series->sample(i);
+  }
+
+  QRectF boundingRect() const override
+  {
+    return _bounding_rect;
+  }
+
+private:
+  const QwtSeriesData<QPointF>* _series;
+  size_t _size;
+  QRectF _bounding_rect;
+};
+
+}  // namespace
+
+struct CurveRenderer::Job
+{
+  struct Item
+  {
+    // copy of the curve, created in the GUI thread
+    std::unique_ptr<QwtPlotCurve> curve;
+    bool antialiased;
+    // samples sorted by x: only the visible ones are drawn
+    bool sorted_x;
+  };
+  std::vector<Item> items;
+  QRectF canvas_rect;
+  QwtScaleMap x_map;
+  QwtScaleMap y_map;
+  qreal pixel_ratio = 1.0;
+  uint64_t epoch = 0;
+
+  QImage image;
+  bool cancelled = false;
+
+  static constexpr int CHUNK_SIZE = 50000;
+
+  void run();
+};
+
+void CurveRenderer::Job::run()
+{
+  const QSize size = (canvas_rect.size() * pixel_ratio).toSize();
+  if (size.isEmpty())
+  {
+    return;
+  }
+  image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+  image.setDevicePixelRatio(pixel_ratio);
+  image.fill(Qt::transparent);
+
+  QPainter painter(&image);
+  painter.translate(-canvas_rect.topLeft());
+
+  const double min_x = std::min(x_map.s1(), x_map.s2());
+  const double max_x = std::max(x_map.s1(), x_map.s2());
+  auto less_than = [](double x, const QPointF& sample) { return x < sample.x(); };
+
+  for (const auto& item : items)
+  {
+    const auto& series = *item.curve->data();
+    if (series.size() == 0)
+    {
+      continue;
+    }
+    int from = 0;
+    int to = int(series.size()) - 1;
+    if (item.sorted_x)
+    {
+      // keep the last point before and the first after the visible range
+      int first = qwtUpperSampleIndex<QPointF>(series, min_x, less_than);
+      int last = qwtUpperSampleIndex<QPointF>(series, max_x, less_than);
+      from = (first < 0) ? to : std::max(0, first - 1);
+      to = (last < 0) ? to : last;
+    }
+    painter.save();
+    painter.setRenderHint(QPainter::Antialiasing, item.antialiased);
+    // long series are drawn in chunks, to stop soon when the job is cancelled.
+    // Consecutive chunks share a point, to keep the lines connected.
+    int chunk_from = from;
+    do
+    {
+      if (Workers().epoch != epoch)
+      {
+        painter.restore();
+        cancelled = true;
+        return;
+      }
+      const int chunk_to = std::min(to, chunk_from + CHUNK_SIZE);
+      item.curve->drawSeries(&painter, x_map, y_map, canvas_rect, chunk_from, chunk_to);
+      chunk_from = chunk_to;
+    } while (chunk_from < to);
+    painter.restore();
+  }
+}
+
+namespace
+{
+class JobRunnable : public QRunnable
+{
+public:
+  JobRunnable(std::function<void()> function) : _function(std::move(function))
+  {
+  }
+
+  void run() override
+  {
+    _function();
+  }
+
+private:
+  std::function<void()> _function;
+};
+}  // namespace
+
+CurveRenderer::CurveRenderer(QWidget* canvas) : _canvas(canvas)
+{
+}
+
+CurveRenderer::~CurveRenderer()
+{
+  // the jobs read the series owned by the curves of this plot
+  if (_job_running)
+  {
+    waitForIdle();
+  }
+}
+
+bool CurveRenderer::isSupported(const QwtPlotCurve* curve)
+{
+  return curve->symbol() == nullptr && curve->xAxis() == QwtAxis::XBottom &&
+         curve->yAxis() == QwtAxis::YLeft;
+}
+
+void CurveRenderer::clear()
+{
+  _image = QImage();
+}
+
+void CurveRenderer::draw(QPainter* painter, const QRectF& canvas_rect,
+                         const QwtScaleMap& x_map, const QwtScaleMap& y_map,
+                         const std::vector<const QwtPlotCurve*>& curves)
+{
+  const bool showing_result = _showing_result;
+  _showing_result = false;
+
+  if (curves.empty())
+  {
+    // the result of a running job will be discarded
+    _render_again = _job_running;
+    clear();
+    return;
+  }
+
+  const bool same_view = _image_rect == canvas_rect && SameMap(_image_x_map, x_map) &&
+                         SameMap(_image_y_map, y_map);
+  if (!_image.isNull())
+  {
+    painter->save();
+    painter->setClipRect(canvas_rect, Qt::IntersectClip);
+    if (same_view)
+    {
+      painter->drawImage(canvas_rect.topLeft(), _image);
+    }
+    else
+    {
+      // stretch the last image to the current scales, until the new one is ready
+      QRectF target;
+      target.setLeft(x_map.transform(_image_x_map.invTransform(_image_rect.left())));
+      target.setRight(x_map.transform(_image_x_map.invTransform(_image_rect.right())));
+      target.setTop(y_map.transform(_image_y_map.invTransform(_image_rect.top())));
+      target.setBottom(y_map.transform(_image_y_map.invTransform(_image_rect.bottom())));
+      painter->drawImage(target.normalized(), _image);
+    }
+    painter->restore();
+  }
+
+  if (showing_result && same_view && _image_epoch == Workers().epoch)
+  {
+    return;
+  }
+  if (_job_running)
+  {
+    _render_again = true;
+    return;
+  }
+  const QPaintDevice* device = painter->device();
+  startJob(canvas_rect, x_map, y_map, device ? device->devicePixelRatioF() : 1.0, curves);
+}
+
+void CurveRenderer::startJob(const QRectF& canvas_rect, const QwtScaleMap& x_map,
+                             const QwtScaleMap& y_map, qreal pixel_ratio,
+                             const std::vector<const QwtPlotCurve*>& curves)
+{
+  auto job = std::make_shared<Job>();
+  job->canvas_rect = canvas_rect;
+  job->x_map = x_map;
+  job->y_map = y_map;
+  job->pixel_ratio = pixel_ratio;
+  job->epoch = Workers().epoch;
+
+  for (const QwtPlotCurve* curve : curves)
+  {
+    Job::Item item;
+    item.curve = std::make_unique<QwtPlotCurve>();
+    item.curve->setData(new SeriesView(curve->data()));
+    item.curve->setPen(curve->pen());
+    item.curve->setBrush(curve->brush());
+    item.curve->setStyle(curve->style());
+    item.curve->setBaseline(curve->baseline());
+    item.curve->setOrientation(curve->orientation());
+    for (auto attribute : { QwtPlotCurve::ClipPolygons, QwtPlotCurve::FilterPoints,
+                            QwtPlotCurve::FilterPointsAggressive })
+    {
+      item.curve->setPaintAttribute(attribute, curve->testPaintAttribute(attribute));
+    }
+    item.curve->setCurveAttribute(QwtPlotCurve::Inverted,
+                                  curve->testCurveAttribute(QwtPlotCurve::Inverted));
+    item.antialiased = curve->testRenderHint(QwtPlotItem::RenderAntialiased);
+    item.sorted_x = dynamic_cast<const QwtTimeseries*>(curve->data()) != nullptr;
+    job->items.push_back(std::move(item));
+  }
+
+  _job_running = true;
+  _render_again = false;
+  {
+    std::lock_guard<std::mutex> lock(Workers().mutex);
+    Workers().running++;
+  }
+
+  Workers().pool.start(new JobRunnable([this, job]() {
+    job->run();
+    // if this is destroyed, the event is discarded
+    QMetaObject::invokeMethod(
+        this, [this, job]() { onJobFinished(job); }, Qt::QueuedConnection);
+
+    std::lock_guard<std::mutex> lock(Workers().mutex);
+    Workers().running--;
+    Workers().idle.notify_all();
+  }));
+}
+
+void CurveRenderer::onJobFinished(std::shared_ptr<Job> job)
+{
+  _job_running = false;
+  if (!job->cancelled)
+  {
+    _image = std::move(job->image);
+    _image_rect = job->canvas_rect;
+    _image_x_map = job->x_map;
+    _image_y_map = job->y_map;
+    _image_epoch = job->epoch;
+  }
+  // the data changed or the view was modified while rendering: the image is used
+  // only until the next one is ready
+  const bool outdated = job->cancelled || _render_again || job->epoch != Workers().epoch;
+  _render_again = false;
+  _showing_result = !outdated;
+
+  if (auto canvas = qobject_cast<QwtPlotCanvas*>(_canvas))
+  {
+    canvas->replot();
+  }
+}
+
+void CurveRenderer::run(
+    std::function<void(const std::function<bool()>& cancelled)> function)
+{
+  const uint64_t epoch = Workers().epoch;
+  {
+    std::lock_guard<std::mutex> lock(Workers().mutex);
+    Workers().running++;
+  }
+  Workers().pool.start(new JobRunnable([function, epoch]() {
+    function([epoch]() { return Workers().epoch != epoch; });
+
+    std::lock_guard<std::mutex> lock(Workers().mutex);
+    Workers().running--;
+    Workers().idle.notify_all();
+  }));
+}
+
+void CurveRenderer::waitForIdle()
+{
+  auto& workers = Workers();
+  workers.epoch++;
+  std::unique_lock<std::mutex> lock(workers.mutex);
+  workers.idle.wait(lock, [&workers]() { return workers.running == 0; });
+}
@@ -0,0 +1,75 @@
+#ifndef CURVE_RENDERER_H
+#define CURVE_RENDERER_H
+
+#include <QObject>
+#include <QImage>
+#include <QPainter>
+#include <QWidget>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "qwt_plot_curve.h"
+#include "qwt_scale_map.h"
+
+/**
+ * @brief Draws the curves of a plot into a QImage, using a thread pool of its own.
+ * Used by PlotWidgetBase when the canvas is not OpenGL.
+ *
+ * draw() is called by the canvas, in the GUI thread. It paints the last image available
+ * (stretched to the current scales, if they changed in the meantime) and starts
+ * rendering a new one. When the new image is ready, the canvas is repainted.
+ *
+ * The workers read the series while the GUI thread is free to do something else. Any
+ * code that modifies the data must call waitForIdle() first.
+ *
+ * Other tasks that read the data can use the same workers with run().
+ */
+class CurveRenderer : public QObject
+{
+public:
+  explicit CurveRenderer(QWidget* canvas);
+
+  ~CurveRenderer() override;
+
+  /// Curves with symbols are drawn by Qwt, in the GUI thread.
+  static bool isSupported(const QwtPlotCurve* curve);
+
+  void draw(QPainter* painter, const QRectF& canvas_rect, const QwtScaleMap& x_map,
+            const QwtScaleMap& y_map, const std::vector<const QwtPlotCurve*>& curves);
+
+  /// Discard the last image, if the plot changed in a way that makes it misleading.
+  void clear();
+
+  /// Cancel the rendering of all the plots and wait until the workers are done.
+  static void waitForIdle();
+
+  /// Run a function in the workers. Like the rendering, it is cancelled by
+  /// waitForIdle(): "cancelled" returns true when the function must return. The
+  /// function must not throw.
+  static void run(std::function<void(const std::function<bool()>& cancelled)> function);
+
+private:
+  struct Job;
+
+  void startJob(const QRectF& canvas_rect, const QwtScaleMap& x_map,
+                const QwtScaleMap& y_map, qreal pixel_ratio,
+                const std::vector<const QwtPlotCurve*>& curves);
+
+  void onJobFinished(std::shared_ptr<Job> job);
+
+  QWidget* _canvas;
+
+  QImage _image;
+  QRectF _image_rect;
+  QwtScaleMap _image_x_map;
+  QwtScaleMap _image_y_map;
+  uint64_t _image_epoch = 0;
+
+  bool _job_running = false;
+  // draw() was called while the job was running: its result is already old
+  bool _render_again = false;
+  // the canvas is being repainted to show the image just rendered
+  bool _showing_result = false;
+};
+
+#endif  // CURVE_RENDERER_H
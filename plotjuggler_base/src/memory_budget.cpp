@@ -0,0 +1,134 @@
+#include "PlotJuggler/memory_budget.h"
+
+namespace PJ
+{
+namespace
+{
+// after compaction, the usage must be below this fraction of the budget, to avoid
+// compacting again at the next update.
+const double TARGET_RATIO = 0.8;
+// resolution of the first pass, in seconds. It is multiplied by
+// RESOLUTION_FACTOR at each following pass, up to MAX_RESOLUTION.
+const double INITIAL_RESOLUTION = 0.1;
+const double RESOLUTION_FACTOR = 4.0;
+const double MAX_RESOLUTION = INITIAL_RESOLUTION * 16384.0;  // about 27 minutes
+const int MAX_PASSES = 8;
+}  // namespace
+
+MemoryBudget::MemoryBudget()
+  : _budget(0)
+  , _compression(false)
+  , _full_resolution_window(60.0)
+  , _resolution(INITIAL_RESOLUTION)
+{
+}
+
+MemoryBudget::Usage MemoryBudget::memoryUsage(const PlotDataMapRef& data)
+{
+  Usage usage;
+  for (const auto& it : data.numeric)
+  {
+    usage.numeric += it.second.memoryUsage();
+  }
+  for (const auto& it : data.strings)
+  {
+    usage.strings += it.second.memoryUsage();
+  }
+  usage.strings += data.string_pool->memoryUsage();
+  for (const auto& it : data.user_defined)
+  {
+    usage.user_defined += it.second.memoryUsage();
+  }
+  return usage;
+}
+
+void MemoryBudget::setBudget(size_t bytes)
+{
+  _budget = bytes;
+  _resolution = INITIAL_RESOLUTION;
+}
+
+void MemoryBudget::setCompression(bool enabled)
+{
+  _compression = enabled;
+}
+
+void MemoryBudget::setFullResolutionWindow(double seconds)
+{
+  _full_resolution_window = std::max(0.0, seconds);
+}
+
+bool MemoryBudget::enforce(PlotDataMapRef& data)
+{
+  if (_budget == 0 && !_compression)
+  {
+    return false;
+  }
+
+  double newest_time = std::numeric_limits<double>::lowest();
+  bool compacted = false;
+  for (const auto& it : data.numeric)
+  {
+    if (it.second.size() > 0)
+    {
+      newest_time = std::max(newest_time, it.second.back().x);
+    }
+    compacted = compacted || it.second.compactedResolution() > 0;
+  }
+  if (!compacted)
+  {
+    // the data was cleared: start again from the finest resolution
+    _resolution = INITIAL_RESOLUTION;
+  }
+  const double cold_until = newest_time - _full_resolution_window;
+
+  if (_compression)
+  {
+    // only the points that became "cold" since the last call are moved
+    for (auto& it : data.numeric)
+    {
+      it.second.compressHistory(cold_until);
+    }
+  }
+
+  if (_budget == 0)
+  {
+    return false;
+  }
+  Usage usage = memoryUsage(data);
+  if (usage.total() <= _budget)
+  {
+    return false;
+  }
+  const size_t target = static_cast<size_t>(TARGET_RATIO * double(_budget));
+
+  // Start from the resolution reached by the previous calls: the history was already
+  // compacted with it, only the points that became cold since then are visited.
+  bool modified = false;
+  for (int pass = 0; pass < MAX_PASSES && usage.total() > target; pass++)
+  {
+    size_t removed = 0;
+    for (auto& it : data.numeric)
+    {
+      removed += it.second.compact(cold_until, _resolution);
+    }
+    if (removed > 0)
+    {
+      modified = true;
+      usage.numeric = memoryUsage(data).numeric;
+    }
+    if (usage.total() > target)
+    {
+      _resolution = std::min(_resolution * RESOLUTION_FACTOR, MAX_RESOLUTION);
+    }
+    // the budget can not be met by compacting (e.g. strings or a large full
+    // resolution window): try the coarser resolution at the next call
+    if (removed == 0)
+    {
+      break;
+    }
+  }
+  return modified;
+}
+
+}  // namespace PJ
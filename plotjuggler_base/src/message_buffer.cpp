@@ -0,0 +1,176 @@
+#include "PlotJuggler/message_buffer.h"
+#include <algorithm>
+
+namespace PJ
+{
+namespace
+{
+// capacity of a new buffer; smaller messages do not allocate again.
+const size_t MIN_CAPACITY = 256;
+}  // namespace
+
+struct MessageBuffer::Storage
+{
+  std::unique_ptr<uint8_t[]> bytes;
+  size_t capacity = 0;
+  size_t size = 0;
+  std::atomic<int> ref_count = { 0 };
+  std::shared_ptr<MessageBufferPool::State> pool;
+};
+
+MessageBuffer::MessageBuffer(const MessageBuffer& other) : _storage(other._storage)
+{
+  if (_storage)
+  {
+    _storage->ref_count.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+MessageBuffer::MessageBuffer(MessageBuffer&& other) noexcept : _storage(other._storage)
+{
+  other._storage = nullptr;
+}
+
+MessageBuffer& MessageBuffer::operator=(const MessageBuffer& other)
+{
+  Storage* storage = other._storage;
+  if (storage)
+  {
+    storage->ref_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  release();
+  _storage = storage;
+  return *this;
+}
+
+MessageBuffer& MessageBuffer::operator=(MessageBuffer&& other) noexcept
+{
+  if (this != &other)
+  {
+    release();
+    _storage = other._storage;
+    other._storage = nullptr;
+  }
+  return *this;
+}
+
+MessageBuffer::~MessageBuffer()
+{
+  release();
+}
+
+uint8_t* MessageBuffer::data()
+{
+  return _storage ? _storage->bytes.get() : nullptr;
+}
+
+const uint8_t* MessageBuffer::data() const
+{
+  return _storage ? _storage->bytes.get() : nullptr;
+}
+
+size_t MessageBuffer::size() const
+{
+  return _storage ? _storage->size : 0;
+}
+
+void MessageBuffer::truncate(size_t size)
+{
+  if (_storage && size < _storage->size)
+  {
+    _storage->size = size;
+  }
+}
+
+void MessageBuffer::release()
+{
+  Storage* storage = _storage;
+  _storage = nullptr;
+  if (!storage || storage->ref_count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+  {
+    return;
+  }
+
+  // keep the state alive while its mutex is locked, even if this storage is deleted
+  std::shared_ptr<MessageBufferPool::State> pool = storage->pool;
+  bool recycled = false;
+  {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    if (!pool->closed && pool->free_buffers.size() < pool->max_free_buffers)
+    {
+      pool->free_buffers.push_back(storage);
+      recycled = true;
+    }
+  }
+  if (!recycled)
+  {
+    delete storage;
+  }
+}
+
+MessageBufferPool::MessageBufferPool(size_t max_free_buffers)
+  : _state(std::make_shared<State>())
+{
+  _state->max_free_buffers = max_free_buffers;
+  _state->free_buffers.reserve(max_free_buffers);
+}
+
+MessageBufferPool::~MessageBufferPool()
+{
+  std::vector<MessageBuffer::Storage*> free_buffers;
+  {
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    _state->closed = true;
+    std::swap(free_buffers, _state->free_buffers);
+  }
+  for (auto storage : free_buffers)
+  {
+    delete storage;
+  }
+}
+
+MessageBuffer MessageBufferPool::acquire(size_t size)
+{
+  _state->acquired++;
+
+  MessageBuffer::Storage* storage = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    if (!_state->free_buffers.empty())
+    {
+      storage = _state->free_buffers.back();
+      _state->free_buffers.pop_back();
+    }
+  }
+  if (!storage)
+  {
+    storage = new MessageBuffer::Storage;
+    storage->pool = _state;
+    _state->allocations++;
+  }
+
+  if (storage->capacity < size)
+  {
+    size_t capacity = std::max(MIN_CAPACITY, storage->capacity);
+    while (capacity < size)
+    {
+      capacity *= 2;
+    }
+    storage->bytes.reset(new uint8_t[capacity]);
+    storage->capacity = capacity;
+    _state->allocations++;
+  }
+  storage->size = size;
+  storage->ref_count.store(1, std::memory_order_relaxed);
+  return MessageBuffer(storage);
+}
+
+MessageBufferPool::Statistics MessageBufferPool::statistics() const
+{
+  Statistics stats;
+  stats.acquired = _state->acquired;
+  stats.allocations = _state->allocations;
+  return stats;
+}
+
+}  // namespace PJ
@@ -36,10 +36,29 @@ T& getOrCreateImpl(std::unordered_map<std::string, T>& series, const std::string
   return it->second;
 }
 
+std::string PlotDataMapRef::prefixedName(const std::string& name) const
+{
+  if (name_prefix.empty())
+  {
+    return name;
+  }
+  std::string key;
+  key.reserve(name_prefix.size() + 1 + name.size());
+  key = name_prefix;
+  if (name.empty() || name.front() != '/')
+  {
+    key.push_back('/');
+  }
+  key += name;
+  return key;
+}
+
 PlotDataMap::iterator PlotDataMapRef::addNumeric(const std::string& name,
                                                  PlotGroup::Ptr group)
 {
-  return addImpl(numeric, name, group);
+  auto it = addImpl(numeric, prefixedName(name), group);
+  it->second.setTimeRangeIndex(time_range);
+  return it;
 }
 
 AnySeriesMap::iterator PlotDataMapRef::addUserDefined(const std::string& name,
@@ -51,19 +70,31 @@ AnySeriesMap::iterator PlotDataMapRef::addUserDefined(const std::string& name,
 StringSeriesMap::iterator PlotDataMapRef::addStringSeries(const std::string& name,
                                                           PlotGroup::Ptr group)
 {
-  return addImpl(strings, name, group);
+  auto it = addImpl(strings, prefixedName(name), group);
+  it->second.setStringPool(string_pool);
+  return it;
 }
 
 PlotData& PlotDataMapRef::getOrCreateNumeric(const std::string& name,
                                              PlotGroup::Ptr group)
 {
-  return getOrCreateImpl(numeric, name, group);
+  auto it = numeric.find(prefixedName(name));
+  if (it == numeric.end())
+  {
+    it = addNumeric(name, group);
+  }
+  return it->second;
 }
 
 StringSeries& PlotDataMapRef::getOrCreateStringSeries(const std::string& name,
                                                       PlotGroup::Ptr group)
 {
-  return getOrCreateImpl(strings, name, group);
+  auto it = strings.find(prefixedName(name));
+  if (it == strings.end())
+  {
+    it = addStringSeries(name, group);
+  }
+  return it->second;
 }
 
 PlotDataAny& PlotDataMapRef::getOrCreateUserDefined(const std::string& name,
@@ -109,6 +140,27 @@ void PlotDataMapRef::clear()
   numeric.clear();
   strings.clear();
   user_defined.clear();
+  // series created elsewhere may still use the previous pool
+  string_pool = std::make_shared<StringPool>();
+  _swept_pool_size = 0;
+}
+
+void PlotDataMapRef::sweepStringPool()
+{
+  // smaller pools are not worth it
+  const size_t MIN_SWEEP_SIZE = 1024;
+  const size_t size = string_pool->size();
+  if (size < MIN_SWEEP_SIZE || size < 2 * _swept_pool_size)
+  {
+    return;
+  }
+  auto pool = std::make_shared<StringPool>();
+  for (auto& it : strings)
+  {
+    it.second.setStringPool(pool);
+  }
+  string_pool = std::move(pool);
+  _swept_pool_size = string_pool->size();
 }
 
 void PlotDataMapRef::setMaximumRangeX(double range)
@@ -4,6 +4,7 @@
 #include "plotmagnifier.h"
 #include "plotzoomer.h"
 #include "plotlegend.h"
+#include "curve_renderer.h"
 
 #include "qwt_axis.h"
 #include "qwt_legend.h"
@@ -34,6 +35,8 @@
 
 static int _global_color_index_ = 0;
 
+static bool _background_rendering_ = true;
+
 class PlotWidgetBase::QwtPlotPimpl : public QwtPlot
 {
 public:
@@ -45,6 +48,9 @@ public:
   std::function<void(const QRectF&)> resized_callback;
   std::function<void(QEvent*)> event_callback;
   PlotWidgetBase* parent;
+  // see Preferences::async_rendering. Destroyed before the curves, that the workers
+  // might be reading.
+  std::unique_ptr<CurveRenderer> curve_renderer;
 
   QwtPlotPimpl(PlotWidgetBase* parentObject, QWidget* canvas,
                std::function<void(const QRectF&)> resizedViewCallback,
@@ -123,6 +129,71 @@ public:
     return rect;
   }
 
+  void drawCanvas(QPainter* painter) override
+  {
+    if (!curve_renderer || !_background_rendering_)
+    {
+      QwtPlot::drawCanvas(painter);
+      return;
+    }
+
+    QwtScaleMap maps[QwtAxis::AxisPositions];
+    for (int axis = 0; axis < QwtAxis::AxisPositions; axis++)
+    {
+      maps[axis] = canvasMap(axis);
+    }
+    const QRectF canvas_rect = canvas()->contentsRect();
+
+    auto renderedCurve = [](const QwtPlotItem* item) -> const QwtPlotCurve* {
+      if (item->rtti() != QwtPlotItem::Rtti_PlotCurve)
+      {
+        return nullptr;
+      }
+      auto curve = static_cast<const QwtPlotCurve*>(item);
+      return CurveRenderer::isSupported(curve) ? curve : nullptr;
+    };
+
+    std::vector<const QwtPlotCurve*> curves;
+    for (const QwtPlotItem* item : itemList())
+    {
+      const QwtPlotCurve* curve = item->isVisible() ? renderedCurve(item) : nullptr;
+      if (curve)
+      {
+        curves.push_back(curve);
+      }
+    }
+
+    // same as QwtPlot::drawItems(), but the curves are drawn as a single layer
+    bool curves_drawn = false;
+    for (QwtPlotItem* item : itemList())
+    {
+      if (!item->isVisible())
+      {
+        continue;
+      }
+      if (renderedCurve(item))
+      {
+        if (!curves_drawn)
+        {
+          curve_renderer->draw(painter, canvas_rect, maps[QwtAxis::XBottom],
+                               maps[QwtAxis::YLeft], curves);
+          curves_drawn = true;
+        }
+        continue;
+      }
+      painter->save();
+      painter->setRenderHint(QPainter::Antialiasing,
+                             item->testRenderHint(QwtPlotItem::RenderAntialiased));
+      item->draw(painter, maps[item->xAxis()], maps[item->yAxis()], canvas_rect);
+      painter->restore();
+    }
+    if (!curves_drawn)
+    {
+      curve_renderer->draw(painter, canvas_rect, maps[QwtAxis::XBottom],
+                           maps[QwtAxis::YLeft], curves);
+    }
+  }
+
   virtual void resizeEvent(QResizeEvent* ev) override
   {
     QwtPlot::resizeEvent(ev);
@@ -325,6 +396,8 @@ PlotWidgetBase::PlotWidgetBase(QWidget* parent)
     canvas->setFrameStyle(QFrame::Box | QFrame::Plain);
     canvas->setLineWidth(1);
     canvas->setPalette(Qt::white);
+    // the curves are drawn again only by replot(), not by the tracker overlay
+    canvas->setPaintAttribute(QwtPlotOpenGLCanvas::BackingStore, true);
     abs_canvas = canvas;
   }
   else
@@ -341,6 +414,11 @@ PlotWidgetBase::PlotWidgetBase(QWidget* parent)
 
   p = new QwtPlotPimpl(this, abs_canvas, onViewResized, onEvent);
 
+  if (!use_opengl && settings.value("Preferences::async_rendering", false).toBool())
+  {
+    p->curve_renderer = std::make_unique<CurveRenderer>(abs_canvas);
+  }
+
   qwtPlot()->setMinimumWidth(100);
   qwtPlot()->setMinimumHeight(100);
 
@@ -422,6 +500,7 @@ PlotWidgetBase::CurveInfo* PlotWidgetBase::addCurve(const std::string& name,
   curve_info.curve = curve;
   curve_info.marker = marker;
   curve_info.src_name = name;
+  curve_info.time_range_viewer = data.createTimeRangeViewer();
 
   p->curve_list.push_back(curve_info);
 
@@ -734,6 +813,22 @@ bool PlotWidgetBase::isZoomEnabled() const
   return p->zoom_enabled;
 }
 
+void PlotWidgetBase::waitForRendering()
+{
+  CurveRenderer::waitForIdle();
+}
+
+void PlotWidgetBase::runInBackground(
+    std::function<void(const std::function<bool()>& cancelled)> function)
+{
+  CurveRenderer::run(std::move(function));
+}
+
+void PlotWidgetBase::setBackgroundRendering(bool enabled)
+{
+  _background_rendering_ = enabled;
+}
+
 void PlotWidgetBase::replot()
 {
   if (p->zoomer)
@@ -0,0 +1,110 @@
+#include "PlotJuggler/series_join.h"
+#include <functional>
+
+namespace PJ
+{
+SeriesMergeJoin::SeriesMergeJoin(const std::vector<const PlotData*>& series,
+                                 double time_start, double time_end)
+  : _time_end(time_end)
+  , _row_points(series.size(), PlotData::Point(0, 0))
+  , _row(series.size(), nullptr)
+{
+  _sources.reserve(series.size());
+  _heads.reserve(series.size());
+  for (size_t i = 0; i < series.size(); i++)
+  {
+    const PlotData& s = *series[i];
+    Source source{ &s, 0, std::nullopt, 0, PlotData::Point(0, 0), false };
+
+    // skip the compressed blocks older than time_start
+    const auto& blocks = s.archive().blocks();
+    while (source.block < blocks.size() && blocks[source.block].lastX() < time_start)
+    {
+      source.block++;
+    }
+    if (source.block == blocks.size())
+    {
+      auto it = std::lower_bound(
+          s.begin(), s.end(), time_start,
+          [](const PlotData::Point& p, double t) { return p.x < t; });
+      source.pos = std::distance(s.begin(), it);
+    }
+    advance(source);
+    while (source.available && source.point.x < time_start)
+    {
+      advance(source);
+    }
+    _sources.push_back(std::move(source));
+    pushHead(i);
+  }
+}
+
+bool SeriesMergeJoin::next()
+{
+  for (size_t i : _row_series)
+  {
+    _row[i] = nullptr;
+  }
+  _row_series.clear();
+
+  if (_heads.empty())
+  {
+    return false;
+  }
+  _time = _heads.front().x;
+
+  // take a single point from each series, even if the next one has the same time
+  while (!_heads.empty() &&
+         std::abs(_heads.front().x - _time) < std::numeric_limits<double>::epsilon())
+  {
+    std::pop_heap(_heads.begin(), _heads.end(), std::greater<Head>());
+    const size_t i = _heads.back().series;
+    _heads.pop_back();
+
+    _row_points[i] = _sources[i].point;
+    _row[i] = &_row_points[i];
+    _row_series.push_back(i);
+    advance(_sources[i]);
+  }
+  for (size_t i : _row_series)
+  {
+    pushHead(i);
+  }
+  return true;
+}
+
+void SeriesMergeJoin::advance(Source& source)
+{
+  const auto& blocks = source.series->archive().blocks();
+  while (source.block < blocks.size())
+  {
+    if (!source.reader)
+    {
+      source.reader.emplace(blocks[source.block]);
+    }
+    if (source.reader->next(source.point))
+    {
+      source.available = true;
+      return;
+    }
+    source.reader.reset();
+    source.block++;
+  }
+  source.available = source.pos < source.series->size();
+  if (source.available)
+  {
+    source.point = source.series->at(source.pos++);
+  }
+}
+
+void SeriesMergeJoin::pushHead(size_t series)
+{
+  const Source& source = _sources[series];
+  if (source.available && source.point.x <= _time_end)
+  {
+    _heads.push_back({ source.point.x, series });
+    std::push_heap(_heads.begin(), _heads.end(), std::greater<Head>());
+  }
+}
+
+}  // namespace PJ
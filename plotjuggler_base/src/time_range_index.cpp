@@ -0,0 +1,127 @@
+#include "PlotJuggler/time_range_index.h"
+
+namespace PJ
+{
+TimeRangeIndex::Entry::Entry(std::shared_ptr<TimeRangeIndex> index)
+  : _index(std::move(index))
+{
+}
+
+TimeRangeIndex::Entry::~Entry()
+{
+  if (_dirty_slot != NOT_DIRTY)
+  {
+    // the order of the list doesn't matter: move the last entry here
+    auto& dirty = _index->_dirty;
+    dirty[_dirty_slot] = dirty.back();
+    dirty[_dirty_slot]->_dirty_slot = _dirty_slot;
+    dirty.pop_back();
+  }
+  _index->removeIndexed(this);
+}
+
+TimeRangeIndex::Viewer::Viewer(std::shared_ptr<Entry> entry) : _entry(std::move(entry))
+{
+  _entry->_viewers++;
+  _entry->markDirty();
+}
+
+TimeRangeIndex::Viewer::~Viewer()
+{
+  _entry->_viewers--;
+  _entry->markDirty();
+}
+
+std::shared_ptr<TimeRangeIndex::Entry> TimeRangeIndex::createEntry()
+{
+  return std::make_shared<Entry>(shared_from_this());
+}
+
+RangeOpt TimeRangeIndex::range()
+{
+  refresh();
+  return _all.range();
+}
+
+size_t TimeRangeIndex::maxSize()
+{
+  refresh();
+  return _all.maxSize();
+}
+
+RangeOpt TimeRangeIndex::viewedRange()
+{
+  refresh();
+  return _viewed.range();
+}
+
+size_t TimeRangeIndex::viewedMaxSize()
+{
+  refresh();
+  return _viewed.maxSize();
+}
+
+void TimeRangeIndex::refresh()
+{
+  for (Entry* entry : _dirty)
+  {
+    removeIndexed(entry);
+    if (entry->_current.size > 0)
+    {
+      entry->_indexed = entry->_current;
+      _all.insert(entry->_indexed);
+      if (entry->_viewers > 0)
+      {
+        _viewed.insert(entry->_indexed);
+        entry->_indexed_viewed = true;
+      }
+    }
+    entry->_dirty_slot = Entry::NOT_DIRTY;
+  }
+  _dirty.clear();
+}
+
+void TimeRangeIndex::removeIndexed(Entry* entry)
+{
+  if (entry->_indexed.size > 0)
+  {
+    _all.erase(entry->_indexed);
+    if (entry->_indexed_viewed)
+    {
+      _viewed.erase(entry->_indexed);
+    }
+  }
+  entry->_indexed = {};
+  entry->_indexed_viewed = false;
+}
+
+void TimeRangeIndex::ExtentSet::insert(const Extent& extent)
+{
+  fronts.insert(extent.front);
+  backs.insert(extent.back);
+  sizes.insert(extent.size);
+}
+
+void TimeRangeIndex::ExtentSet::erase(const Extent& extent)
+{
+  // remove a single instance of each value
+  fronts.erase(fronts.find(extent.front));
+  backs.erase(backs.find(extent.back));
+  sizes.erase(sizes.find(extent.size));
+}
+
+RangeOpt TimeRangeIndex::ExtentSet::range() const
+{
+  if (fronts.empty())
+  {
+    return std::nullopt;
+  }
+  return Range{ *fronts.begin(), *backs.rbegin() };
+}
+
+size_t TimeRangeIndex::ExtentSet::maxSize() const
+{
+  return sizes.empty() ? 0 : *sizes.rbegin();
+}
+
+}  // namespace PJ
@@ -7,15 +7,15 @@
 
 RangeOpt QwtTimeseries::getVisualizationRangeY(Range range_X)
 {
-  int first_index = _ts_data->getIndexFromX(range_X.min);
-  int last_index = _ts_data->getIndexFromX(range_X.max);
+  int first_index = indexFromX(range_X.min);
+  int last_index = indexFromX(range_X.max);
 
   if (first_index > last_index || first_index < 0 || last_index < 0)
   {
     return {};
   }
 
-  if (first_index == 0 && last_index == plotData()->size() - 1)
+  if (first_index == 0 && last_index == size() - 1)
   {
     return _ts_data->rangeY();
   }
@@ -34,17 +34,56 @@ RangeOpt QwtTimeseries::getVisualizationRangeY(Range range_X)
 
 std::optional<QPointF> QwtTimeseries::sampleFromTime(double t)
 {
-  int index = _ts_data->getIndexFromX(t);
+  int index = indexFromX(t);
   if (index < 0)
   {
     return {};
   }
-  const auto& p = plotData()->at(size_t(index));
+  const auto& archive = _ts_data->archive();
+  if (size_t(index) < archive.size())
+  {
+    thread_local CompressedSeries::Cursor cursor;
+    const auto& p = cursor.at(archive, size_t(index));
+    return QPointF(p.x, p.y);
+  }
+  const auto& p = _ts_data->at(size_t(index) - archive.size());
   return QPointF(p.x, p.y);
 }
 
+QPointF QwtTimeseries::sample(size_t i) const
+{
+  const auto& archive = _ts_data->archive();
+  if (i < archive.size())
+  {
+    // blocks are decoded one at a time, while Qwt reads the samples in order.
+    // The curves may be drawn by several threads at once (see CurveRenderer).
+    thread_local CompressedSeries::Cursor cursor;
+    const auto& p = cursor.at(archive, i);
+    return QPointF(p.x - timeOffset(), p.y);
+  }
+  return QwtSeriesWrapper::sample(i - archive.size());
+}
+
+size_t QwtTimeseries::size() const
+{
+  return _ts_data->archive().size() + QwtSeriesWrapper::size();
+}
+
+int QwtTimeseries::indexFromX(double x) const
+{
+  const auto& archive = _ts_data->archive();
+  if (!archive.empty() && x < _ts_data->front().x)
+  {
+    // like sample(), this is called by the threads that draw the curves
+    thread_local CompressedSeries::Cursor cursor;
+    return cursor.indexFromX(archive, x);
+  }
+  int index = _ts_data->getIndexFromX(x);
+  return (index < 0) ? index : index + int(archive.size());
+}
+
 TransformedTimeseries::TransformedTimeseries(const PlotData* source_data)
-  : QwtTimeseries(&_dst_data)
+  : QwtTimeseries(source_data)
   , _dst_data(source_data->plotName(), {})
   , _src_data(source_data)
 {
@@ -64,6 +103,9 @@ void TransformedTimeseries::setTransform(QString transform_ID)
   if (transform_ID.isEmpty())
   {
     _transform.reset();
+    _src_pin.reset();
+    _dst_data.clear();
+    setTimeseries(_src_data);
   }
   else
   {
@@ -71,6 +113,8 @@ void TransformedTimeseries::setTransform(QString transform_ID)
     _transform = TransformFactory::create(transform_ID.toStdString());
     std::vector<PlotData*> dest = { &_dst_data };
     _transform->setData(nullptr, { _src_data }, dest);
+    _src_pin = _src_data->pinHistory();
+    setTimeseries(&_dst_data);
   }
 }
 
@@ -83,21 +127,17 @@ bool TransformedTimeseries::updateCache(bool reset_old_data)
       _dst_data.clear();
       _transform->reset();
     }
-    std::vector<PlotData*> dest = { &_dst_data };
     _transform->calculate();
   }
-  else
-  {
-    // TODO: optimize ??
-    _dst_data.clear();
-    for (size_t i = 0; i < _src_data->size(); i++)
-    {
-      _dst_data.pushBack(_src_data->at(i));
-    }
-  }
+  // else: nothing to do, _src_data is used directly
   return true;
 }
 
+uint64_t TransformedTimeseries::dataGeneration() const
+{
+  return _src_data->generation();
+}
+
 QString TransformedTimeseries::transformName()
 {
   return (!_transform) ? QString() : _transform->name();
@@ -141,6 +181,11 @@ size_t QwtSeriesWrapper::size() const
   return _data->size();
 }
 
+uint64_t QwtSeriesWrapper::dataGeneration() const
+{
+  return _data->generation();
+}
+
 void QwtSeriesWrapper::setTimeOffset(double offset)
 {
   _time_offset = offset;
@@ -23,8 +23,16 @@ public:
 
   void setTimeOffset(double offset);
 
+  double timeOffset() const
+  {
+    return _time_offset;
+  }
+
   virtual bool updateCache(bool reset_old_data) = 0;
 
+  /// Changes every time the data used to build the cache is modified.
+  virtual uint64_t dataGeneration() const;
+
   size_t size() const override;
 
   QRectF boundingRect() const override;
@@ -36,6 +44,12 @@ public:
   virtual RangeOpt getVisualizationRangeY(Range range_X) = 0;
 
   virtual std::optional<QPointF> sampleFromTime(double t) = 0;
+
+protected:
+  void setPlotData(const PlotDataXY* data)
+  {
+    _data = data;
+  }
 };
 
 class QwtTimeseries : public QwtSeriesWrapper
@@ -49,8 +63,22 @@ public:
 
   virtual std::optional<QPointF> sampleFromTime(double t) override;
 
+  // include the compressed history of the series (see PlotData::archive())
+  QPointF sample(size_t i) const override;
+
+  size_t size() const override;
+
 protected:
   const PlotData* _ts_data;
+
+  // same as PlotData::getIndexFromX, including the compressed history
+  int indexFromX(double x) const;
+
+  void setTimeseries(const PlotData* data)
+  {
+    _ts_data = data;
+    setPlotData(data);
+  }
 };
 
 //------------------------------------
@@ -66,6 +94,8 @@ public:
 
   virtual bool updateCache(bool reset_old_data) override;
 
+  uint64_t dataGeneration() const override;
+
   QString transformName();
 
   QString alias() const;
@@ -74,9 +104,13 @@ public:
 
 protected:
   QString _alias;
+  // Used only when a transform is applied. Otherwise, the source data is
+  // displayed directly, without any copy.
   PlotData _dst_data;
   const PlotData* _src_data;
   TransformFunction_SISO::Ptr _transform;
+  // a transform reads the whole history of the source: it must not be compressed
+  std::shared_ptr<PlotData::HistoryPin> _src_pin;
 };
 
 //---------------------------------------------------------
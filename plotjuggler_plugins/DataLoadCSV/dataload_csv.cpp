@@ -540,19 +540,20 @@ bool DataLoadCSV::readDataFromFile(FileLoadInfo* info, PlotDataMapRef& plot_data
   // cleanups
   for (unsigned i = 0; i < column_names.size(); i++)
   {
-    const auto& name = column_names[i];
     bool is_numeric = true;
     if (plots_vector[i]->size() == 0 && string_vector[i]->size() > 0)
     {
       is_numeric = false;
     }
+    // the key includes plot_data.name_prefix, if any
+    const std::string name = plots_vector[i]->plotName();
     if (is_numeric)
     {
-      plot_data.strings.erase(plot_data.strings.find(name));
+      plot_data.strings.erase(name);
     }
     else
     {
-      plot_data.numeric.erase(plot_data.numeric.find(name));
+      plot_data.numeric.erase(name);
     }
   }
   return true;
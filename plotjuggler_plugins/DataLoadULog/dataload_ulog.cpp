@@ -43,9 +43,9 @@ bool DataLoadULog::readDataFromFile(FileLoadInfo* fileload_info,
   QByteArray file_array = file.readAll();
   ULogParser::DataStream datastream(file_array.data(), file_array.size());
 
-  ULogParser parser(datastream);
+  auto parser = std::make_shared<ULogParser>(datastream);
 
-  const auto& timeseries_map = parser.getTimeseriesMap();
+  const auto& timeseries_map = parser->getTimeseriesMap();
 
   for (const auto& it : timeseries_map)
   {
@@ -67,13 +67,37 @@ bool DataLoadULog::readDataFromFile(FileLoadInfo* fileload_info,
     }
   }
 
-  ULogParametersDialog* dialog = new ULogParametersDialog(parser, _main_win);
-  dialog->setWindowTitle(QString("ULog file %1").arg(filename));
+  auto file_info = std::make_shared<ULogFileInfo>();
+  file_info->info = parser->getInfo();
+  file_info->parameters = parser->getParameters();
+  file_info->logs = parser->getLogs();
+
+  // this method may run in a worker thread: the dialog is created by finishLoading()
+  std::lock_guard<std::mutex> lock(_mutex);
+  _file_infos[fileload_info] = file_info;
+
+  return true;
+}
+
+void DataLoadULog::finishLoading(const FileLoadInfo& fileload_info)
+{
+  std::shared_ptr<ULogFileInfo> file_info;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _file_infos.find(&fileload_info);
+    if (it == _file_infos.end())
+    {
+      return;
+    }
+    file_info = it->second;
+    _file_infos.erase(it);
+  }
+
+  ULogParametersDialog* dialog = new ULogParametersDialog(*file_info, _main_win);
+  dialog->setWindowTitle(QString("ULog file %1").arg(fileload_info.filename));
   dialog->setAttribute(Qt::WA_DeleteOnClose);
   dialog->restoreSettings();
   dialog->show();
-
-  return true;
 }
 
 DataLoadULog::~DataLoadULog()
@@ -3,8 +3,13 @@
 #include <QObject>
 #include <QtPlugin>
 #include <QWidget>
+#include <map>
+#include <memory>
+#include <mutex>
 #include "PlotJuggler/dataloader_base.h"
 
+struct ULogFileInfo;
+
 using namespace PJ;
 
 class DataLoadULog : public PJ::DataLoader
@@ -21,6 +26,13 @@ public:
   bool readDataFromFile(PJ::FileLoadInfo* fileload_info,
                         PlotDataMapRef& destination) override;
 
+  bool supportsConcurrentLoading() const override
+  {
+    return true;
+  }
+
+  void finishLoading(const PJ::FileLoadInfo& fileload_info) override;
+
   ~DataLoadULog() override;
 
   const char* name() const override
@@ -35,4 +47,9 @@ public:
 private:
   std::string _default_time_axis;
   QWidget* _main_win;
+
+  // parameters and logs waiting for finishLoading(), to be shown in a dialog.
+  // The parsers themselves are released as soon as the data is copied.
+  std::mutex _mutex;
+  std::map<const PJ::FileLoadInfo*, std::shared_ptr<ULogFileInfo>> _file_infos;
 };
@@ -5,7 +5,8 @@
 #include <QSettings>
 #include <QHeaderView>
 
-ULogParametersDialog::ULogParametersDialog(const ULogParser& parser, QWidget* parent)
+ULogParametersDialog::ULogParametersDialog(const ULogFileInfo& file_info,
+                                           QWidget* parent)
   : QDialog(parent), ui(new Ui::ULogParametersDialog)
 {
   ui->setupUi(this);
@@ -13,9 +14,9 @@ ULogParametersDialog::ULogParametersDialog(const ULogParser& parser, QWidget* pa
   QTableWidget* table_params = ui->tableWidgetParams;
   QTableWidget* table_logs = ui->tableWidgetLogs;
 
-  table_info->setRowCount(parser.getInfo().size());
+  table_info->setRowCount(file_info.info.size());
   int row = 0;
-  for (const auto& it : parser.getInfo())
+  for (const auto& it : file_info.info)
   {
     table_info->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(it.first)));
     table_info->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(it.second)));
@@ -23,9 +24,9 @@ ULogParametersDialog::ULogParametersDialog(const ULogParser& parser, QWidget* pa
   }
   table_info->sortItems(0);
 
-  table_params->setRowCount(parser.getParameters().size());
+  table_params->setRowCount(file_info.parameters.size());
   row = 0;
-  for (const auto& param : parser.getParameters())
+  for (const auto& param : file_info.parameters)
   {
     table_params->setItem(row, 0,
                           new QTableWidgetItem(QString::fromStdString(param.name)));
@@ -43,9 +44,9 @@ ULogParametersDialog::ULogParametersDialog(const ULogParser& parser, QWidget* pa
   }
   table_params->sortItems(0);
 
-  table_logs->setRowCount(parser.getLogs().size());
+  table_logs->setRowCount(file_info.logs.size());
   row = 0;
-  for (const auto& log_msg : parser.getLogs())
+  for (const auto& log_msg : file_info.logs)
   {
     QString time = QString::number(0.001 * double(log_msg.timestamp / 1000), 'f', 2);
     table_logs->setItem(row, 0, new QTableWidgetItem(time));
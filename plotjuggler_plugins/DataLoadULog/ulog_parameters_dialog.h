@@ -9,12 +9,21 @@ namespace Ui
 class ULogParametersDialog;
 }
 
+/// The content of a ULog file shown by ULogParametersDialog
+struct ULogFileInfo
+{
+  std::map<std::string, std::string> info;
+  std::vector<ULogParser::Parameter> parameters;
+  std::vector<ULogParser::MessageLog> logs;
+};
+
 class ULogParametersDialog : public QDialog
 {
   Q_OBJECT
 
 public:
-  explicit ULogParametersDialog(const ULogParser& parser, QWidget* parent = nullptr);
+  explicit ULogParametersDialog(const ULogFileInfo& file_info,
+                                QWidget* parent = nullptr);
 
   void restoreSettings();
 
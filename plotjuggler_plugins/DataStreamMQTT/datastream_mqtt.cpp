@@ -6,6 +6,7 @@
 #include <QUuid>
 #include <QIntValidator>
 #include <QMessageBox>
+#include <algorithm>
 
 #ifdef WIN32
 #include <windows.h>
@@ -42,36 +43,14 @@ void message_callback(struct mosquitto *mosq, void *context, const struct mosqui
 {
   DataStreamMQTT* _this = static_cast<DataStreamMQTT*>(context);
 
-  std::unique_lock<std::mutex> lk(_this->mutex());
+  using namespace std::chrono;
+  auto ts = high_resolution_clock::now().time_since_epoch();
+  double timestamp = 1e-6* double( duration_cast<microseconds>(ts).count() );
 
-  auto it = _this->_parsers.find(message->topic);
-  if( it == _this->_parsers.end() )
-  {
-    auto& parser_factory = _this->availableParsers()->at( _this->_protocol );
-    auto parser = parser_factory->createInstance({}, _this->dataMap());
-    it = _this->_parsers.insert( {message->topic, parser} ).first;
-  }
-  auto& parser = it->second;
-
-  bool result = false;
-  try {
-    MessageRef msg( static_cast<uint8_t*>(message->payload), message->payloadlen);
-
-    using namespace std::chrono;
-    auto ts = high_resolution_clock::now().time_since_epoch();
-    double timestamp = 1e-6* double( duration_cast<microseconds>(ts).count() );
-
-    result = parser->parseMessage(msg, timestamp);
-
-  } catch (std::exception& ) {
-  }
-
-  emit _this->dataReceived();
-  if( !result )
-  {
-    _this->_failed_parsing++;
-    emit _this->notificationsChanged(_this->_failed_parsing);
-  }
+  // the payload is owned by mosquitto: it is copied and parsed by the workers of the
+  // pool, to keep this thread free to receive the next messages
+  _this->_parse_pool->push(message->topic, message->payload, message->payloadlen,
+                           timestamp);
 }
 
 /*
@@ -222,12 +201,14 @@ DataStreamMQTT::DataStreamMQTT():
   _notification_action = new QAction(this);
 
   connect(_notification_action, &QAction::triggered, this, [this]() {
-    QMessageBox::warning(nullptr, "MQTT error",
-                         QString("Failed to parse %1 messages").arg(_failed_parsing),
-                         QMessageBox::Ok);
+    showStatistics();
 
     if (_failed_parsing > 0)
     {
+      if (_parse_pool)
+      {
+        _acknowledged_failures = _parse_pool->failedMessages();
+      }
       _failed_parsing = 0;
       emit notificationsChanged(_failed_parsing);
     }
@@ -249,6 +230,7 @@ bool DataStreamMQTT::start(QStringList *)
 
   //cleanup notifications
   _failed_parsing = 0;
+  _acknowledged_failures = 0;
   emit notificationsChanged(0);
 
   if( !availableParsers() )
@@ -380,6 +362,16 @@ bool DataStreamMQTT::start(QStringList *)
 
   _running = true;
 
+  // the messages of the same topic are always parsed by the same worker, in order
+  const int num_workers = std::clamp(QThread::idealThreadCount() / 2, 1, 4);
+  auto parser_factory = availableParsers()->at(_protocol);
+  _parse_pool = std::make_unique<TopicParsePool>(
+      dataMap(), mutex(),
+      [parser_factory](PlotDataMapRef& data) {
+        return parser_factory->createInstance({}, data);
+      },
+      [this]() { onParsedData(); }, num_workers);
+
   mosquitto_loop_start(_mosq);
 
   return _running;
@@ -395,11 +387,59 @@ void DataStreamMQTT::shutdown()
     _mosq = nullptr;
     _disconnection_done = false;
     _running = false;
-    _parsers.clear();
+    // no more messages from mosquitto: wait for the workers before clearing the data
+    _parse_pool->stop();
     dataMap().clear();
   }
 }
 
+void DataStreamMQTT::onParsedData()
+{
+  // called at most once every few milliseconds, not once per message
+  emit dataReceived();
+
+  const int failed = int(_parse_pool->failedMessages() - _acknowledged_failures);
+  if( _failed_parsing.exchange(failed) != failed )
+  {
+    emit notificationsChanged(failed);
+  }
+}
+
+void DataStreamMQTT::showStatistics()
+{
+  if( !_parse_pool )
+  {
+    return;
+  }
+  auto statistics = _parse_pool->statistics();
+  std::sort(statistics.begin(), statistics.end(), [](const auto& a, const auto& b) {
+    return std::make_pair(a.failed, a.received) > std::make_pair(b.failed, b.received);
+  });
+
+  // the topics with more failures first; the list may be very long
+  const size_t MAX_TOPICS = 20;
+
+  QString text = QString("Failed to parse %1 messages\n\n").arg(_failed_parsing.load());
+  for( size_t i = 0; i < statistics.size() && i < MAX_TOPICS; i++ )
+  {
+    const auto& stats = statistics[i];
+    text += QString("%1\n    %2 messages (%3 Hz), %4 failed, "
+                    "latency %5 ms (max %6 ms)\n")
+                .arg(QString::fromStdString(stats.topic))
+                .arg(stats.received)
+                .arg(stats.rate, 0, 'f', 1)
+                .arg(stats.failed)
+                .arg(stats.mean_latency * 1000, 0, 'f', 2)
+                .arg(stats.max_latency * 1000, 0, 'f', 2);
+  }
+  if( statistics.size() > MAX_TOPICS )
+  {
+    text += QString("\n... and %1 other topics").arg(statistics.size() - MAX_TOPICS);
+  }
+
+  QMessageBox::information(nullptr, "MQTT statistics", text, QMessageBox::Ok);
+}
+
 bool DataStreamMQTT::isRunning() const
 {
   return _running;
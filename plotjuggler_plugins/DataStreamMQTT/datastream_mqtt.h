@@ -8,6 +8,7 @@
 #include "PlotJuggler/datastreamer_base.h"
 #include "PlotJuggler/messageparser_base.h"
 #include "ui_datastream_mqtt.h"
+#include "topic_parse_pool.h"
 
 #include <mosquitto.h>
 
@@ -96,7 +97,7 @@ public:
 
   std::pair<QAction*, int> notificationAction() override
   {
-    return { _notification_action, _failed_parsing };
+    return { _notification_action, _failed_parsing.load() };
   }
 
   bool _disconnection_done;
@@ -104,7 +105,9 @@ public:
   bool _finished;
   bool _running;
 
-  std::unordered_map<std::string, PJ::MessageParserPtr> _parsers;
+  // parses the messages received by mosquitto; kept after shutdown(), to show its
+  // statistics
+  std::unique_ptr<TopicParsePool> _parse_pool;
 
   struct mosquitto *_mosq = nullptr;
   MosquittoConfig _config;
@@ -113,7 +116,14 @@ public:
   QString _protocol;
 
   QAction* _notification_action;
-  int _failed_parsing = 0;
+  std::atomic_int _failed_parsing = { 0 };
+  // failures already shown to the user
+  std::atomic<uint64_t> _acknowledged_failures = { 0 };
+
+  // called by the workers of _parse_pool
+  void onParsedData();
+
+  void showStatistics();
 
 private slots:
 
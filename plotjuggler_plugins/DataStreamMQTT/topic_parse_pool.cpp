@@ -0,0 +1,296 @@
+#include "topic_parse_pool.h"
+#include <algorithm>
+#include <cstring>
+
+struct TopicParsePool::Topic
+{
+  std::string name;
+  size_t worker = 0;
+
+  // created and used only by the worker
+  PJ::MessageParserPtr parser;
+
+  // written by push()
+  std::atomic<uint64_t> received = { 0 };
+  std::atomic<double> first_timestamp = { 0 };
+  std::atomic<double> last_timestamp = { 0 };
+
+  // written by the worker
+  std::atomic<uint64_t> parsed = { 0 };
+  std::atomic<uint64_t> failed = { 0 };
+  std::atomic<int64_t> latency_sum_us = { 0 };
+  std::atomic<int64_t> latency_max_us = { 0 };
+};
+
+struct TopicParsePool::Worker
+{
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::vector<Message> queue;
+  bool stop = false;
+
+  // written by the parsers of the topics of this worker
+  PJ::PlotDataMapRef data;
+
+  std::thread thread;
+};
+
+namespace
+{
+template <typename SeriesMap, typename CreateFunction>
+void AppendSeries(SeriesMap& source, PJ::PlotDataMapRef& destination,
+                  CreateFunction create)
+{
+  for (auto& [name, source_series] : source)
+  {
+    if (source_series.size() == 0)
+    {
+      continue;
+    }
+    PJ::PlotGroup::Ptr group;
+    if (source_series.group())
+    {
+      group = destination.getOrCreateGroup(source_series.group()->name());
+    }
+    auto& destination_series = create(name, group);
+
+    for (const auto& [attribute, value] : source_series.attributes())
+    {
+      destination_series.setAttribute(attribute, value);
+    }
+    for (size_t i = 0; i < source_series.size(); i++)
+    {
+      destination_series.pushBack(source_series.at(i));
+    }
+    // the memory of the points is released, except the first block of the deque
+    source_series.clear();
+  }
+}
+}  // namespace
+
+TopicParsePool::TopicParsePool(PJ::PlotDataMapRef& data, std::mutex& data_mutex,
+                               ParserFactory parser_factory,
+                               std::function<void()> on_data, int num_workers,
+                               std::chrono::milliseconds notification_period)
+  : _data(data)
+  , _data_mutex(data_mutex)
+  , _parser_factory(std::move(parser_factory))
+  , _on_data(std::move(on_data))
+  , _notification_period(notification_period)
+{
+  num_workers = std::max(1, num_workers);
+  for (int i = 0; i < num_workers; i++)
+  {
+    _workers.push_back(std::make_unique<Worker>());
+  }
+  for (auto& worker : _workers)
+  {
+    worker->thread = std::thread(&TopicParsePool::run, this, std::ref(*worker));
+  }
+}
+
+TopicParsePool::~TopicParsePool()
+{
+  stop();
+}
+
+void TopicParsePool::push(const char* topic_name, const void* payload, size_t size,
+                          double timestamp)
+{
+  _topic_key.assign(topic_name);
+  auto it = _topics.find(_topic_key);
+  if (it == _topics.end())
+  {
+    auto topic = std::make_unique<Topic>();
+    topic->name = _topic_key;
+    topic->worker = std::hash<std::string>()(_topic_key) % _workers.size();
+    topic->first_timestamp = timestamp;
+
+    std::lock_guard<std::mutex> lock(_topics_mutex);
+    it = _topics.emplace(_topic_key, std::move(topic)).first;
+  }
+  Topic* topic = it->second.get();
+  topic->received++;
+  topic->last_timestamp = timestamp;
+
+  Message message = { topic, _buffer_pool.acquire(size), timestamp, Clock::now() };
+  if (size > 0)
+  {
+    std::memcpy(message.buffer.data(), payload, size);
+  }
+
+  Worker& worker = *_workers[topic->worker];
+  bool was_empty = false;
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    was_empty = worker.queue.empty();
+    worker.queue.push_back(std::move(message));
+  }
+  // if the queue was not empty, the worker was already woken up
+  if (was_empty)
+  {
+    worker.condition.notify_one();
+  }
+}
+
+void TopicParsePool::stop()
+{
+  for (auto& worker : _workers)
+  {
+    {
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      worker->stop = true;
+    }
+    worker->condition.notify_one();
+  }
+  for (auto& worker : _workers)
+  {
+    if (worker->thread.joinable())
+    {
+      worker->thread.join();
+    }
+    worker->queue.clear();
+  }
+}
+
+std::vector<TopicParsePool::TopicStatistics> TopicParsePool::statistics() const
+{
+  std::vector<TopicStatistics> result;
+
+  std::lock_guard<std::mutex> lock(_topics_mutex);
+  result.reserve(_topics.size());
+  for (const auto& [name, topic] : _topics)
+  {
+    TopicStatistics stats;
+    stats.topic = name;
+    stats.received = topic->received;
+    stats.failed = topic->failed;
+
+    const double elapsed = topic->last_timestamp - topic->first_timestamp;
+    if (elapsed > 0)
+    {
+      stats.rate = double(stats.received - 1) / elapsed;
+    }
+    if (const uint64_t parsed = topic->parsed; parsed > 0)
+    {
+      stats.mean_latency = 1e-6 * double(topic->latency_sum_us) / double(parsed);
+      stats.max_latency = 1e-6 * double(topic->latency_max_us);
+    }
+    result.push_back(std::move(stats));
+  }
+  return result;
+}
+
+void TopicParsePool::run(Worker& worker)
+{
+  std::vector<Message> batch;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(worker.mutex);
+      auto ready = [&worker] { return worker.stop || !worker.queue.empty(); };
+
+      // if a notification was postponed, wake up in time to send it
+      if (_pending_notification)
+      {
+        worker.condition.wait_for(lock, _notification_period, ready);
+      }
+      else
+      {
+        worker.condition.wait(lock, ready);
+      }
+      if (worker.stop)
+      {
+        return;
+      }
+      std::swap(batch, worker.queue);
+    }
+
+    if (!batch.empty())
+    {
+      parseBatch(worker, batch);
+      // release the buffers to the pool, but keep the capacity of the vector
+      batch.clear();
+    }
+    notifyIfDue();
+  }
+}
+
+void TopicParsePool::parseBatch(Worker& worker, std::vector<Message>& batch)
+{
+  for (auto& message : batch)
+  {
+    Topic& topic = *message.topic;
+    bool result = false;
+    try
+    {
+      if (!topic.parser)
+      {
+        topic.parser = _parser_factory(worker.data);
+      }
+      PJ::MessageRef msg(message.buffer);
+      result = topic.parser->parseMessage(msg, message.timestamp);
+    }
+    catch (std::exception&)
+    {
+    }
+
+    if (!result)
+    {
+      topic.failed++;
+      _failed++;
+    }
+
+    using namespace std::chrono;
+    const int64_t latency =
+        duration_cast<microseconds>(Clock::now() - message.received).count();
+    topic.parsed++;
+    topic.latency_sum_us += latency;
+    int64_t max_latency = topic.latency_max_us;
+    while (latency > max_latency &&
+           !topic.latency_max_us.compare_exchange_weak(max_latency, latency))
+    {
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_data_mutex);
+    AppendSeries(worker.data.numeric, _data,
+                 [this](const std::string& name, PJ::PlotGroup::Ptr group) -> auto& {
+                   return _data.getOrCreateNumeric(name, group);
+                 });
+    AppendSeries(worker.data.strings, _data,
+                 [this](const std::string& name, PJ::PlotGroup::Ptr group) -> auto& {
+                   return _data.getOrCreateStringSeries(name, group);
+                 });
+    AppendSeries(worker.data.user_defined, _data,
+                 [this](const std::string& name, PJ::PlotGroup::Ptr group) -> auto& {
+                   return _data.getOrCreateUserDefined(name, group);
+                 });
+  }
+  // The series of the worker are empty now. They are not erased, because the
+  // parsers may keep a reference to them, but the strings of the pool are released.
+  worker.data.sweepStringPool();
+
+  _pending_notification = true;
+}
+
+void TopicParsePool::notifyIfDue()
+{
+  if (!_pending_notification)
+  {
+    return;
+  }
+  const Clock::rep now = Clock::now().time_since_epoch().count();
+  Clock::rep last = _last_notification;
+  if (now - last < _notification_period.count())
+  {
+    return;
+  }
+  // only one of the workers sends the notification
+  if (_last_notification.compare_exchange_strong(last, now) &&
+      _pending_notification.exchange(false))
+  {
+    _on_data();
+  }
+}
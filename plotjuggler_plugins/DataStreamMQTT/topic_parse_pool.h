@@ -0,0 +1,110 @@
+#ifndef TOPIC_PARSE_POOL_H
+#define TOPIC_PARSE_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "PlotJuggler/message_buffer.h"
+#include "PlotJuggler/messageparser_base.h"
+
+/**
+ * Parses the messages received by the network thread in a few worker threads.
+ *
+ * Each topic is assigned to a worker by the hash of its name, so that its messages
+ * are parsed in order, by the same parser. The parsers of a worker write into a
+ * private PlotDataMapRef; after each batch of messages, its content is moved into the
+ * data of the streamer, locking its mutex once. Only the empty series are left in the
+ * private map (see PlotDataMapRef::sweepStringPool).
+ *
+ * The callback "on_data" is called by the workers when new data is available, at
+ * most once per "notification_period".
+ */
+class TopicParsePool
+{
+public:
+  using ParserFactory = std::function<PJ::MessageParserPtr(PJ::PlotDataMapRef&)>;
+
+  struct TopicStatistics
+  {
+    std::string topic;
+    uint64_t received = 0;
+    uint64_t failed = 0;
+    // messages per second, between the first and the last one
+    double rate = 0;
+    // seconds between the reception of a message and the end of its parsing
+    double mean_latency = 0;
+    double max_latency = 0;
+  };
+
+  TopicParsePool(PJ::PlotDataMapRef& data, std::mutex& data_mutex,
+                 ParserFactory parser_factory, std::function<void()> on_data,
+                 int num_workers,
+                 std::chrono::milliseconds notification_period =
+                     std::chrono::milliseconds(10));
+
+  TopicParsePool(const TopicParsePool& other) = delete;
+  TopicParsePool& operator=(const TopicParsePool& other) = delete;
+
+  ~TopicParsePool();
+
+  /// Must be called always by the same thread. The payload is copied.
+  void push(const char* topic_name, const void* payload, size_t size, double timestamp);
+
+  /// Wait for the workers to finish. The messages not parsed yet are discarded.
+  void stop();
+
+  std::vector<TopicStatistics> statistics() const;
+
+  uint64_t failedMessages() const
+  {
+    return _failed;
+  }
+
+private:
+  struct Topic;
+  struct Worker;
+
+  using Clock = std::chrono::steady_clock;
+
+  struct Message
+  {
+    Topic* topic;
+    PJ::MessageBuffer buffer;
+    double timestamp;
+    Clock::time_point received;
+  };
+
+  void run(Worker& worker);
+
+  void parseBatch(Worker& worker, std::vector<Message>& batch);
+
+  void notifyIfDue();
+
+  PJ::PlotDataMapRef& _data;
+  std::mutex& _data_mutex;
+  ParserFactory _parser_factory;
+  std::function<void()> _on_data;
+  const Clock::duration _notification_period;
+
+  std::vector<std::unique_ptr<Worker>> _workers;
+  PJ::MessageBufferPool _buffer_pool;
+
+  // modified only by push(), under _topics_mutex
+  std::unordered_map<std::string, std::unique_ptr<Topic>> _topics;
+  mutable std::mutex _topics_mutex;
+  // reused by push() to search _topics, without allocating a new string
+  std::string _topic_key;
+
+  std::atomic<uint64_t> _failed = { 0 };
+  std::atomic_bool _pending_notification = { false };
+  std::atomic<Clock::rep> _last_notification = { 0 };
+};
+
+#endif  // TOPIC_PARSE_POOL_H
@@ -20,6 +20,7 @@ THE SOFTWARE.
 #include <QFile>
 #include <QMessageBox>
 #include <QDebug>
+#include <QLoggingCategory>
 #include <QSettings>
 #include <QDialog>
 #include <mutex>
@@ -27,10 +28,13 @@ THE SOFTWARE.
 #include <QIntValidator>
 #include <QMessageBox>
 #include <chrono>
-#include <QNetworkDatagram>
 
 #include "ui_udp_server.h"
 
+// statistics of the message buffers, printed on shutdown.
+// Enabled with QT_LOGGING_RULES="plotjuggler.udp.debug=true"
+Q_LOGGING_CATEGORY(udpLog, "plotjuggler.udp", QtInfoMsg)
+
 class UdpServerDialog : public QDialog
 {
 public:
@@ -165,6 +169,10 @@ void UDP_Server::shutdown()
   {
     _udp_socket->deleteLater();
     _running = false;
+
+    auto stats = _buffer_pool.statistics();
+    qCDebug(udpLog) << "UDP received" << stats.acquired << "messages, with"
+                    << stats.allocations << "buffer allocations";
   }
 }
 
@@ -172,14 +180,26 @@ void UDP_Server::processMessage()
 {
   while (_udp_socket->hasPendingDatagrams())
   {
-    QNetworkDatagram datagram = _udp_socket->receiveDatagram();
+    const qint64 size = _udp_socket->pendingDatagramSize();
+    if (size < 0)
+    {
+      break;
+    }
+    // read the datagram directly into a recycled buffer
+    MessageBuffer buffer = _buffer_pool.acquire(size_t(size));
+    const qint64 received =
+        _udp_socket->readDatagram(reinterpret_cast<char*>(buffer.data()), size);
+    if (received < 0)
+    {
+      break;
+    }
+    buffer.truncate(size_t(received));
 
     using namespace std::chrono;
     auto ts = high_resolution_clock::now().time_since_epoch();
     double timestamp = 1e-6 * double(duration_cast<microseconds>(ts).count());
 
-    QByteArray m = datagram.data();
-    MessageRef msg(reinterpret_cast<uint8_t*>(m.data()), m.count());
+    MessageRef msg(buffer);
 
     try
     {
@@ -58,6 +58,7 @@ private:
   bool _running;
   QUdpSocket* _udp_socket;
   PJ::MessageParserPtr _parser;
+  PJ::MessageBufferPool _buffer_pool;
 
 private slots:
 
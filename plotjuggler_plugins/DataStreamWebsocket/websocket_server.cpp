@@ -20,6 +20,7 @@ THE SOFTWARE.
 #include <QFile>
 #include <QMessageBox>
 #include <QDebug>
+#include <QLoggingCategory>
 #include <QSettings>
 #include <QDialog>
 #include <mutex>
@@ -30,6 +31,62 @@ THE SOFTWARE.
 
 #include "ui_websocket_server.h"
 
+namespace
+{
+// Write the UTF-8 encoding of "str" into "out", that must have room for 3 bytes
+// for each QChar. Return the number of bytes written.
+size_t EncodeUtf8(const QString& str, uint8_t* out)
+{
+  const ushort* utf16 = str.utf16();
+  const int length = str.size();
+  uint8_t* ptr = out;
+  for (int i = 0; i < length; i++)
+  {
+    uint32_t code = utf16[i];
+    if (code < 0x80)
+    {
+      *ptr++ = uint8_t(code);
+      continue;
+    }
+    if (code >= 0xD800 && code < 0xE000)
+    {
+      // surrogate pair, or a lone surrogate that is replaced with U+FFFD
+      if (code < 0xDC00 && i + 1 < length && utf16[i + 1] >= 0xDC00 &&
+          utf16[i + 1] < 0xE000)
+      {
+        code = 0x10000 + ((code - 0xD800) << 10) + (utf16[i + 1] - 0xDC00);
+        i++;
+      }
+      else
+      {
+        code = 0xFFFD;
+      }
+    }
+    if (code < 0x800)
+    {
+      *ptr++ = uint8_t(0xC0 | (code >> 6));
+    }
+    else if (code < 0x10000)
+    {
+      *ptr++ = uint8_t(0xE0 | (code >> 12));
+      *ptr++ = uint8_t(0x80 | ((code >> 6) & 0x3F));
+    }
+    else
+    {
+      *ptr++ = uint8_t(0xF0 | (code >> 18));
+      *ptr++ = uint8_t(0x80 | ((code >> 12) & 0x3F));
+      *ptr++ = uint8_t(0x80 | ((code >> 6) & 0x3F));
+    }
+    *ptr++ = uint8_t(0x80 | (code & 0x3F));
+  }
+  return size_t(ptr - out);
+}
+}  // namespace
+
+// statistics of the message buffers, printed on shutdown.
+// Enabled with QT_LOGGING_RULES="plotjuggler.websocket.debug=true"
+Q_LOGGING_CATEGORY(websocketLog, "plotjuggler.websocket", QtInfoMsg)
+
 class WebsocketDialog : public QDialog
 {
 public:
@@ -165,6 +222,11 @@ void WebsocketServer::shutdown()
     socketDisconnected();
     _server.close();
     _running = false;
+
+    auto stats = _buffer_pool.statistics();
+    qCDebug(websocketLog) << "WebSocket received" << stats.acquired
+                          << "messages, with" << stats.allocations
+                          << "buffer allocations";
   }
 }
 
@@ -185,8 +247,10 @@ void WebsocketServer::processMessage(QString message)
   auto ts = high_resolution_clock::now().time_since_epoch();
   double timestamp = 1e-6 * double(duration_cast<microseconds>(ts).count());
 
-  QByteArray bmsg = message.toLocal8Bit();
-  MessageRef msg(reinterpret_cast<uint8_t*>(bmsg.data()), bmsg.size());
+  // encode the text directly into a recycled buffer
+  MessageBuffer buffer = _buffer_pool.acquire(3 * size_t(message.size()));
+  buffer.truncate(EncodeUtf8(message, buffer.data()));
+  MessageRef msg(buffer);
 
   try
   {
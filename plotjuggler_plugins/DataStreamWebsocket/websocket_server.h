@@ -62,6 +62,7 @@ private:
   QList<QWebSocket*> _clients;
   QWebSocketServer _server;
   PJ::MessageParserPtr _parser;
+  PJ::MessageBufferPool _buffer_pool;
 
 private slots:
   void onNewConnection();
@@ -10,6 +10,7 @@
 #include <QSettings>
 #include <QByteArray>
 #include "publisher_csv.h"
+#include "PlotJuggler/series_join.h"
 
 StatePublisherCSV::StatePublisherCSV()
 {
@@ -138,44 +139,28 @@ QString StatePublisherCSV::generateStatisticsCSV(double time_start, double time_
   {
     const auto& name = it.first;
     const auto& plot = *(it.second);
-    int index = plot.getIndexFromX(time_start);
-    if (index < 0)
+
+    // includes the compressed history of the series
+    PJ::SeriesMergeJoin join({ &plot }, time_start, time_end);
+    if (!join.next())
     {
-      continue;  // skip this
+      continue;  // out of range
     }
 
     auto current_value = plot.getYfromX(_previous_time);
 
-    auto point = plot.at(index);
-
-    if (point.x > time_end)  // out of range
-    {
-      continue;
-    }
-    if (index + 1 == plot.size())  // out of range
-    {
-      continue;
-    }
-
-    double min_value = point.y;
-    double max_value = point.y;
-    double total = point.y;
+    double min_value = join.point(0)->y;
+    double max_value = min_value;
+    double total = min_value;
     int count = 1;
-    index++;
 
-    while (index < plot.size())
+    while (join.next())
     {
-      point = plot.at(index);
-      if (point.x > time_end)
-      {
-        break;
-      }
-      double value = point.y;
+      double value = join.point(0)->y;
       max_value = std::max(max_value, value);
       min_value = std::min(min_value, value);
       total += value;
       count++;
-      index++;
     }
     out << name << ',';
     out << ((current_value) ? std::to_string(current_value.value()) : "");
@@ -255,7 +240,7 @@ QString StatePublisherCSV::generateRangeCSV(double time_start, double time_end)
 
   for (const auto& it : _datamap->numeric)
   {
-    if (it.second.size() == 0 || it.second.front().x > time_end ||
+    if (it.second.size() == 0 || it.second.frontX() > time_end ||
         it.second.back().x < time_start)
     {
       continue;
@@ -267,11 +252,8 @@ QString StatePublisherCSV::generateRangeCSV(double time_start, double time_end)
   std::sort(ordered_plotdata.begin(), ordered_plotdata.end(),
             [](const PlotPair& a, const PlotPair& b) { return a.first < b.first; });
 
-  // current index per plordata
-  std::vector<size_t> indices(plot_count, 0);
-
-  const auto NaN = std::numeric_limits<double>::quiet_NaN();
-  std::vector<double> row_values(plot_count, NaN);
+  std::vector<const PJ::PlotData*> series;
+  series.reserve(plot_count);
 
   QString labels;
   labels += "__time,";
@@ -279,71 +261,25 @@ QString StatePublisherCSV::generateRangeCSV(double time_start, double time_end)
   {
     labels += QString::fromStdString(ordered_plotdata[i].first);
     labels += (i + 1 < plot_count) ? "," : "\n";
-
-    const PJ::PlotData* plotdata = (ordered_plotdata[i].second);
-    int index = plotdata->getIndexFromX(time_start);
-    if (index < 0)
-    {
-      index = plotdata->size();
-    }
-    indices[i] = index + 1;
+    series.push_back(ordered_plotdata[i].second);
   }
 
-  bool done = false;
   QStringList rows = { labels };
 
-  while (!done)
+  // one row for each distinct timestamp; a cell is empty if that series has no
+  // point at that time, or if its value is NaN
+  PJ::SeriesMergeJoin join(series, time_start, time_end);
+  while (join.next())
   {
-    // done will become false if at least one plotdata is not completed
-    done = true;
-    double min_time = std::numeric_limits<double>::max();
-
-    for (size_t i = 0; i < plot_count; i++)
-    {
-      size_t index = indices[i];
-      const PJ::PlotData* plotdata = (ordered_plotdata[i].second);
-      row_values[i] = NaN;
-
-      if (index >= plotdata->size())
-      {
-        continue;
-      }
-      const auto& point = plotdata->at(index);
-      if (point.x > time_end)
-      {
-        continue;
-      }
-
-      done = false;
-
-      if (min_time > point.x)
-      {
-        min_time = point.x;  // new min_time
-        // reset previous flags
-        std::fill(row_values.begin(), row_values.begin() + i, NaN);
-        row_values[i] = point.y;
-      }
-      else if (std::abs(min_time - point.x) < std::numeric_limits<double>::epsilon())
-      {
-        row_values[i] = point.y;
-      }
-    }
-
-    if (min_time > time_end || done)
-    {
-      break;
-    }
-
     // the row to append to the CSV file
-    QString row_str = QString::number(min_time, 'f', 6) + ",";
+    QString row_str = QString::number(join.time(), 'f', 6) + ",";
 
     for (size_t i = 0; i < plot_count; i++)
     {
-      if (!std::isnan(row_values[i]))
+      const PJ::PlotData::Point* point = join.point(i);
+      if (point && !std::isnan(point->y))
       {
-        row_str += QString::number(row_values[i], 'f');
-        // value used, move to the nex index
-        indices[i]++;
+        row_str += QString::number(point->y, 'f');
       }
       row_str += (i + 1 < plot_count) ? "," : "\n";
     }
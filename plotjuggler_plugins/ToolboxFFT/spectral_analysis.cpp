@@ -0,0 +1,281 @@
+#include "spectral_analysis.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include "KissFFT/kiss_fftr.h"
+
+namespace SpectralAnalysis
+{
+namespace
+{
+struct PlanDeleter
+{
+  void operator()(kiss_fftr_cfg cfg) const
+  {
+    kiss_fftr_free(cfg);
+  }
+};
+
+using PlanPtr = std::unique_ptr<kiss_fftr_state, PlanDeleter>;
+
+void ComputeWindow(WindowType type, size_t N, std::vector<kiss_fft_scalar>& window)
+{
+  window.resize(N);
+  const double K = 2.0 * M_PI / double(N - 1);
+  for (size_t n = 0; n < N; n++)
+  {
+    double w = 1.0;
+    switch (type)
+    {
+      case RECTANGULAR:
+        w = 1.0;
+        break;
+      case HANN:
+        w = 0.5 - 0.5 * std::cos(K * n);
+        break;
+      case HAMMING:
+        w = 0.54 - 0.46 * std::cos(K * n);
+        break;
+      case BLACKMAN:
+        w = 0.42 - 0.5 * std::cos(K * n) + 0.08 * std::cos(2.0 * K * n);
+        break;
+    }
+    window[n] = static_cast<kiss_fft_scalar>(w);
+  }
+}
+
+// A kiss_fftr_cfg contains a scratch buffer, therefore it can not be shared
+// between threads. Each thread keeps its own plans, one per size. Only the segment
+// sizes of Options are cached: there are a few of them.
+kiss_fftr_cfg GetPlan(size_t N)
+{
+  thread_local std::map<size_t, PlanPtr> cache;
+  auto& plan = cache[N];
+  if (!plan)
+  {
+    plan.reset(kiss_fftr_alloc(static_cast<int>(N), 0, nullptr, nullptr));
+  }
+  return plan.get();
+}
+
+const std::vector<kiss_fft_scalar>& GetWindow(WindowType type, size_t N)
+{
+  thread_local std::map<std::pair<WindowType, size_t>, std::vector<kiss_fft_scalar>>
+      cache;
+  auto& window = cache[{ type, N }];
+  if (window.size() != N)
+  {
+    ComputeWindow(type, N, window);
+  }
+  return window;
+}
+
+// Buffers reused for all the segments of a series.
+class SegmentProcessor
+{
+public:
+  // If cached is false, the plan and the window are freed by the destructor.
+  SegmentProcessor(size_t N, WindowType window_type, bool cached)
+    : _N(N), _input(N), _output(N / 2 + 1), _window_sum(0)
+  {
+    if (cached)
+    {
+      _plan = GetPlan(N);
+      _window = &GetWindow(window_type, N);
+    }
+    else
+    {
+      _own_plan.reset(kiss_fftr_alloc(static_cast<int>(N), 0, nullptr, nullptr));
+      _plan = _own_plan.get();
+      ComputeWindow(window_type, N, _own_window);
+      _window = &_own_window;
+    }
+    for (auto w : *_window)
+    {
+      _window_sum += w;
+    }
+  }
+
+  size_t bins() const
+  {
+    return _N / 2;
+  }
+
+  double windowSum() const
+  {
+    return _window_sum;
+  }
+
+  // add |X(k)|^2 of the windowed samples [first, first+N) to power
+  void accumulatePower(const PJ::PlotData& data, size_t first, double* power)
+  {
+    for (size_t i = 0; i < _N; i++)
+    {
+      _input[i] = static_cast<kiss_fft_scalar>(data[first + i].y) * (*_window)[i];
+    }
+    kiss_fftr(_plan, _input.data(), _output.data());
+
+    for (size_t k = 0; k < bins(); k++)
+    {
+      const double re = _output[k].r;
+      const double im = _output[k].i;
+      power[k] += re * re + im * im;
+    }
+  }
+
+private:
+  size_t _N;
+  PlanPtr _own_plan;
+  std::vector<kiss_fft_scalar> _own_window;
+  kiss_fftr_cfg _plan;
+  const std::vector<kiss_fft_scalar>* _window;
+  std::vector<kiss_fft_scalar> _input;
+  std::vector<kiss_fft_cpx> _output;
+  double _window_sum;
+};
+
+struct Segmentation
+{
+  size_t size = 0;
+  size_t step = 1;
+  size_t count = 0;
+};
+
+Segmentation Segment(size_t samples, const Options& options)
+{
+  Segmentation seg;
+  // kiss_fftr requires an even number of samples
+  seg.size = std::min(options.segment_size, samples) & ~size_t(1);
+  if (seg.size < 8)
+  {
+    return {};
+  }
+  const double overlap = std::clamp(options.overlap, 0.0, 0.95);
+  seg.step = std::max<size_t>(1, static_cast<size_t>(seg.size * (1.0 - overlap)));
+  seg.count = 1 + (samples - seg.size) / seg.step;
+  return seg;
+}
+
+// Welch method. A single FFT is the special case of one segment as large as the range.
+Spectrum AverageSpectrum(const PJ::PlotData& data, size_t first, size_t count,
+                         const Options& options, bool single_fft)
+{
+  Spectrum spectrum;
+  const Segmentation seg = Segment(count, options);
+  const double dT = SamplingPeriod(data, first, count);
+  if (seg.count == 0 || dT <= 0)
+  {
+    return spectrum;
+  }
+
+  // the size of a single FFT changes with the range: its plan is not cached
+  SegmentProcessor processor(seg.size, options.window,
+                             !single_fft && seg.size == options.segment_size);
+  std::vector<double> power(processor.bins(), 0.0);
+
+  for (size_t s = 0; s < seg.count; s++)
+  {
+    processor.accumulatePower(data, first + s * seg.step, power.data());
+  }
+
+  const double frequency_step = 1.0 / (dT * double(seg.size));
+  spectrum.frequency.resize(power.size());
+  spectrum.amplitude.resize(power.size());
+  for (size_t k = 0; k < power.size(); k++)
+  {
+    spectrum.frequency[k] = k * frequency_step;
+    spectrum.amplitude[k] =
+        std::sqrt(power[k] / double(seg.count)) / processor.windowSum();
+  }
+  return spectrum;
+}
+
+}  // namespace
+
+double SamplingPeriod(const PJ::PlotData& data, size_t first, size_t count)
+{
+  if (count < 2)
+  {
+    return 0;
+  }
+  return (data[first + count - 1].x - data[first].x) / double(count - 1);
+}
+
+Spectrum SingleFFT(const PJ::PlotData& data, size_t first, size_t count,
+                   WindowType window)
+{
+  Options options;
+  options.window = window;
+  options.segment_size = count;
+  options.overlap = 0;
+  return AverageSpectrum(data, first, count, options, true);
+}
+
+Spectrum Welch(const PJ::PlotData& data, size_t first, size_t count,
+               const Options& options)
+{
+  return AverageSpectrum(data, first, count, options, false);
+}
+
+Spectrogram STFT(const PJ::PlotData& data, size_t first, size_t count,
+                 const Options& options)
+{
+  Spectrogram out;
+  const Segmentation seg = Segment(count, options);
+  const double dT = SamplingPeriod(data, first, count);
+  if (seg.count == 0 || dT <= 0)
+  {
+    return out;
+  }
+
+  SegmentProcessor processor(seg.size, options.window,
+                             seg.size == options.segment_size);
+
+  out.bins = processor.bins();
+  out.frames = std::min(seg.count, std::max<size_t>(1, options.max_frames));
+  out.time_min = data[first + seg.size / 2].x;
+  out.time_max = data[first + (seg.count - 1) * seg.step + seg.size / 2].x;
+  out.frequency_max = 0.5 / dT;
+
+  // when there are more segments than frames, consecutive segments are averaged
+  std::vector<double> power(out.bins * out.frames, 0.0);
+  std::vector<size_t> segments_per_frame(out.frames, 0);
+  std::vector<double> segment_power(out.bins);
+
+  for (size_t s = 0; s < seg.count; s++)
+  {
+    std::fill(segment_power.begin(), segment_power.end(), 0.0);
+    processor.accumulatePower(data, first + s * seg.step, segment_power.data());
+
+    const size_t frame = (s * out.frames) / seg.count;
+    segments_per_frame[frame]++;
+    for (size_t k = 0; k < out.bins; k++)
+    {
+      power[k * out.frames + frame] += segment_power[k];
+    }
+  }
+
+  const double norm = processor.windowSum() * processor.windowSum();
+  const double MIN_DB = -200;
+  out.values.resize(power.size());
+  out.value_min = std::numeric_limits<double>::max();
+  out.value_max = -std::numeric_limits<double>::max();
+
+  for (size_t k = 0; k < out.bins; k++)
+  {
+    for (size_t f = 0; f < out.frames; f++)
+    {
+      const size_t index = k * out.frames + f;
+      const double p = power[index] / (norm * std::max<size_t>(1, segments_per_frame[f]));
+      const double db = (p > 0) ? std::max(MIN_DB, 10.0 * std::log10(p)) : MIN_DB;
+      out.values[index] = db;
+      out.value_min = std::min(out.value_min, db);
+      out.value_max = std::max(out.value_max, db);
+    }
+  }
+  return out;
+}
+
+}  // namespace SpectralAnalysis
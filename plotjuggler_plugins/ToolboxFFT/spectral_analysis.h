@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include "PlotJuggler/plotdata.h"
+
+namespace SpectralAnalysis
+{
+enum WindowType
+{
+  RECTANGULAR = 0,
+  HANN,
+  HAMMING,
+  BLACKMAN
+};
+
+struct Options
+{
+  WindowType window = HANN;
+  // number of samples of each segment (Welch and STFT)
+  size_t segment_size = 1024;
+  // overlap between consecutive segments, in the range [0, 1)
+  double overlap = 0.5;
+  // maximum number of columns of the spectrogram. Frames are averaged to fit.
+  size_t max_frames = 2000;
+};
+
+struct Spectrum
+{
+  std::vector<double> frequency;
+  std::vector<double> amplitude;
+};
+
+struct Spectrogram
+{
+  double time_min = 0;
+  double time_max = 0;
+  double frequency_max = 0;
+  size_t frames = 0;
+  size_t bins = 0;
+  // amplitude in dB, stored row by row: values[bin * frames + frame]
+  std::vector<double> values;
+  double value_min = 0;
+  double value_max = 0;
+};
+
+/// Average sampling period of the samples in the range [first, first+count)
+double SamplingPeriod(const PJ::PlotData& data, size_t first, size_t count);
+
+/// Amplitude spectrum of all the samples in the range, computed with a single FFT.
+Spectrum SingleFFT(const PJ::PlotData& data, size_t first, size_t count,
+                   WindowType window);
+
+/// Welch method: average of the power spectra of overlapping, windowed segments.
+Spectrum Welch(const PJ::PlotData& data, size_t first, size_t count,
+               const Options& options);
+
+/// Short-Time Fourier Transform. Segments are computed like in Welch().
+Spectrogram STFT(const PJ::PlotData& data, size_t first, size_t count,
+                 const Options& options);
+
+}  // namespace SpectralAnalysis
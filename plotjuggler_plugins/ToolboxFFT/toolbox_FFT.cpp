@@ -7,10 +7,17 @@
 #include <QDebug>
 #include <QDragEnterEvent>
 #include <QSettings>
+#include <QProgressDialog>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+#include "qwt_plot.h"
+#include "qwt_plot_spectrogram.h"
+#include "qwt_matrix_raster_data.h"
+#include "qwt_color_map.h"
 
 #include "PlotJuggler/transform_function.h"
 #include "PlotJuggler/svg_util.h"
-#include "KissFFT/kiss_fftr.h"
 
 ToolboxFFT::ToolboxFFT()
 {
@@ -19,6 +26,13 @@ ToolboxFFT::ToolboxFFT()
 
   ui->setupUi(_widget);
 
+  QSettings settings;
+  ui->comboMethod->setCurrentIndex(settings.value("ToolboxFFT::method", 0).toInt());
+  ui->comboWindow->setCurrentIndex(settings.value("ToolboxFFT::window", 0).toInt());
+  ui->comboSegmentSize->setCurrentText(
+      settings.value("ToolboxFFT::segment_size", "1024").toString());
+  ui->spinBoxOverlap->setValue(settings.value("ToolboxFFT::overlap", 50).toInt());
+
   connect(ui->buttonBox, &QDialogButtonBox::rejected, this, &ToolboxPlugin::closed);
 
   connect(ui->pushButtonCalculate, &QPushButton::clicked, this,
@@ -27,6 +41,12 @@ ToolboxFFT::ToolboxFFT()
   connect(ui->pushButtonSave, &QPushButton::clicked, this, &ToolboxFFT::onSaveCurve);
 
   connect(ui->pushButtonClear, &QPushButton::clicked, this, &ToolboxFFT::onClearCurves);
+
+  connect(ui->comboMethod, qOverload<int>(&QComboBox::currentIndexChanged), this,
+          &ToolboxFFT::onMethodChanged);
+
+  connect(ui->comboSpectrogramCurve, &QComboBox::currentTextChanged, this,
+          &ToolboxFFT::onSpectrogramCurveChanged);
 }
 
 ToolboxFFT::~ToolboxFFT()
@@ -46,9 +66,25 @@ void ToolboxFFT::init(PJ::PlotDataMapRef& src_data, PJ::TransformsMap& transform
   preview_layout_A->setMargin(6);
   preview_layout_A->addWidget(_plot_widget_A->widget());
 
+  _spectrogram_plot = new QwtPlot(ui->framePlotPreviewB);
+  _spectrogram_plot->setCanvasBackground(Qt::white);
+  _spectrogram_plot->setAxisTitle(QwtPlot::yLeft, "Hz");
+
+  _spectrogram = new QwtPlotSpectrogram();
+  _spectrogram->setRenderThreadCount(0);  // use all the available cores
+  auto color_map = new QwtLinearColorMap(Qt::darkBlue, Qt::darkRed);
+  color_map->addColorStop(0.25, Qt::cyan);
+  color_map->addColorStop(0.5, Qt::green);
+  color_map->addColorStop(0.75, Qt::yellow);
+  _spectrogram->setColorMap(color_map);
+  _spectrogram->attach(_spectrogram_plot);
+
   auto preview_layout_B = new QHBoxLayout(ui->framePlotPreviewB);
   preview_layout_B->setMargin(6);
   preview_layout_B->addWidget(_plot_widget_B->widget());
+  preview_layout_B->addWidget(_spectrogram_plot);
+
+  onMethodChanged(ui->comboMethod->currentIndex());
 
   _plot_widget_A->setAcceptDrops(true);
 
@@ -76,16 +112,35 @@ bool ToolboxFFT::onShowWidget()
 
 void ToolboxFFT::calculateCurveFFT()
 {
+  using namespace SpectralAnalysis;
+
   _plot_widget_B->removeAllCurves();
+  _spectrograms.clear();
+  ui->comboSpectrogramCurve->clear();
+
+  // The tasks work on a copy of the selected range: the curves in _plot_data can be
+  // modified by the GUI thread while the progress dialog is open.
+  struct Task
+  {
+    Task(const std::string& id) : curve_id(id), samples(id, {})
+    {
+    }
+    std::string curve_id;
+    QColor color = Qt::transparent;
+    PlotData samples;
+    Spectrum spectrum;
+    Spectrogram spectrogram;
+  };
+  std::vector<Task> tasks;
 
   for (const auto& curve_id : _curve_names)
   {
     auto it = _plot_data->numeric.find(curve_id);
     if (it == _plot_data->numeric.end())
     {
-      return;
+      continue;
     }
-    PlotData& curve_data = it->second;
+    const PlotData& curve_data = it->second;
 
     int min_index = 0;
     int max_index = curve_data.size() - 1;
@@ -96,75 +151,149 @@ void ToolboxFFT::calculateCurveFFT()
       max_index = curve_data.getIndexFromX(_zoom_range.max);
     }
 
-    double min_t = curve_data.at(min_index).x;
-    double max_t = curve_data.at(max_index).x;
-
-    int N = 1 + max_index - min_index;
-
-    if (N & 1)
-    {  // if not even, make it even
-      N--;
-      max_index--;
+    if (min_index < 0 || max_index < 0 || (1 + max_index - min_index) < 8)
+    {
+      continue;
     }
-
-    if (N < 8 || min_index < 0 || max_index < 0)
+    Task task(curve_id);
+    for (int i = min_index; i <= max_index; i++)
     {
-      return;
+      task.samples.pushBack(curve_data[i]);
     }
+    auto colorHint = curve_data.attribute("ColorHint");
+    if (colorHint.isValid())
+    {
+      task.color = colorHint.value<QColor>();
+    }
+    tasks.push_back(std::move(task));
+  }
 
-    double dT = (curve_data.at(max_index).x - curve_data.at(min_index).x) / double(N - 1);
-
-    std::vector<kiss_fft_scalar> input;
-    input.reserve(curve_data.size());
+  const auto method = static_cast<Method>(ui->comboMethod->currentIndex());
 
-    // double std_dev = 0.0;
+  Options options;
+  options.window = static_cast<WindowType>(ui->comboWindow->currentIndex());
+  options.segment_size = ui->comboSegmentSize->currentText().toUInt();
+  options.overlap = 0.01 * ui->spinBoxOverlap->value();
 
-    for (size_t i = 0; i < N; i++)
+  QSettings settings;
+  settings.setValue("ToolboxFFT::method", int(method));
+  settings.setValue("ToolboxFFT::window", int(options.window));
+  settings.setValue("ToolboxFFT::segment_size", ui->comboSegmentSize->currentText());
+  settings.setValue("ToolboxFFT::overlap", ui->spinBoxOverlap->value());
+
+  // each curve is processed by a different thread
+  std::function<void(Task&)> process = [method, options](Task& task) {
+    const PlotData& data = task.samples;
+    switch (method)
     {
-      const auto& p = curve_data[i];
-      input.push_back(static_cast<kiss_fft_scalar>(p.y));
+      case SINGLE_FFT:
+        task.spectrum = SingleFFT(data, 0, data.size(), options.window);
+        break;
+      case WELCH:
+        task.spectrum = Welch(data, 0, data.size(), options);
+        break;
+      case SPECTROGRAM:
+        task.spectrogram = STFT(data, 0, data.size(), options);
+        break;
+    }
+  };
+
+  QProgressDialog progress_dialog(_widget);
+  progress_dialog.setWindowTitle("FFT Toolbox");
+  progress_dialog.setLabelText("Calculating...");
+  progress_dialog.setWindowModality(Qt::ApplicationModal);
+
+  QFutureWatcher<void> watcher;
+  connect(&watcher, &QFutureWatcher<void>::finished, &progress_dialog,
+          &QProgressDialog::reset);
+  connect(&progress_dialog, &QProgressDialog::canceled, &watcher,
+          &QFutureWatcher<void>::cancel);
+  connect(&watcher, &QFutureWatcher<void>::progressRangeChanged, &progress_dialog,
+          &QProgressDialog::setRange);
+  connect(&watcher, &QFutureWatcher<void>::progressValueChanged, &progress_dialog,
+          &QProgressDialog::setValue);
+
+  watcher.setFuture(QtConcurrent::map(tasks, process));
+  progress_dialog.exec();
+  watcher.waitForFinished();
+
+  if (watcher.isCanceled())
+  {
+    return;
+  }
 
-      if (i != 0)
+  for (auto& task : tasks)
+  {
+    if (method == SPECTROGRAM)
+    {
+      if (task.spectrogram.frames > 0)
       {
-        double dTi = (p.x - curve_data[i - 1].x);
-        double diff = dTi - dT;
-        // std_dev += diff*diff;
+        _spectrograms[task.curve_id] = std::move(task.spectrogram);
+        ui->comboSpectrogramCurve->addItem(QString::fromStdString(task.curve_id));
       }
+      continue;
     }
-    // std_dev = sqrt(std_dev / double(N-1) );
-
-    std::vector<kiss_fft_cpx> out(N / 2 + 1);
 
-    auto config = kiss_fftr_alloc(N, false, nullptr, nullptr);
-
-    QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-    kiss_fftr(config, input.data(), out.data());
-    QApplication::restoreOverrideCursor();
-
-    auto& curver_fft = _local_data.getOrCreateNumeric(curve_id);
+    auto& curver_fft = _local_data.getOrCreateNumeric(task.curve_id);
     curver_fft.clear();
-    for (int i = 0; i < N / 2; i++)
-    {
-      kiss_fft_scalar Hz = i * (1.0 / dT) / double(N);
-      kiss_fft_scalar amplitude = std::hypot(out[i].r, out[i].i) / N;
-      curver_fft.pushBack({ Hz, amplitude });
-    }
-
-    QColor color = Qt::transparent;
-    auto colorHint = curve_data.attribute("ColorHint");
-    if (colorHint.isValid())
+    for (size_t i = 0; i < task.spectrum.frequency.size(); i++)
     {
-      color = colorHint.value<QColor>();
+      curver_fft.pushBack({ task.spectrum.frequency[i], task.spectrum.amplitude[i] });
     }
 
-    _plot_widget_B->addCurve(curve_id + "_FFT", curver_fft, color);
-
-    free(config);
+    _plot_widget_B->addCurve(task.curve_id + "_FFT", curver_fft, task.color);
   }
 
   _plot_widget_B->resetZoom();
 }
 
+void ToolboxFFT::onMethodChanged(int method)
+{
+  const bool spectrogram = (method == SPECTROGRAM);
+
+  _plot_widget_B->widget()->setVisible(!spectrogram);
+  _spectrogram_plot->setVisible(spectrogram);
+  ui->comboSpectrogramCurve->setVisible(spectrogram);
+  ui->label_3->setText(spectrogram ? "Spectrogram:" : "FFT: Frequencies");
+
+  // parameters of the segments are not used by the single FFT
+  ui->comboSegmentSize->setEnabled(method != SINGLE_FFT);
+  ui->spinBoxOverlap->setEnabled(method != SINGLE_FFT);
+
+  // a spectrogram can not be saved as a timeseries
+  ui->pushButtonSave->setEnabled(!spectrogram && !_curve_names.empty());
+  ui->lineEditSuffix->setEnabled(!spectrogram && !_curve_names.empty());
+}
+
+void ToolboxFFT::onSpectrogramCurveChanged(const QString& curve_name)
+{
+  auto it = _spectrograms.find(curve_name.toStdString());
+  if (it == _spectrograms.end())
+  {
+    _spectrogram->setData(new QwtMatrixRasterData());
+    _spectrogram_plot->replot();
+    return;
+  }
+  const auto& spectrogram = it->second;
+
+  QVector<double> values(spectrogram.values.size());
+  std::copy(spectrogram.values.begin(), spectrogram.values.end(), values.begin());
+
+  auto raster = new QwtMatrixRasterData();
+  raster->setValueMatrix(values, spectrogram.frames);
+  raster->setInterval(Qt::XAxis,
+                      QwtInterval(spectrogram.time_min, spectrogram.time_max));
+  raster->setInterval(Qt::YAxis, QwtInterval(0.0, spectrogram.frequency_max));
+  raster->setInterval(Qt::ZAxis,
+                      QwtInterval(spectrogram.value_min, spectrogram.value_max));
+  _spectrogram->setData(raster);
+
+  _spectrogram_plot->setAxisScale(QwtPlot::xBottom, spectrogram.time_min,
+                                  spectrogram.time_max);
+  _spectrogram_plot->setAxisScale(QwtPlot::yLeft, 0.0, spectrogram.frequency_max);
+  _spectrogram_plot->replot();
+}
+
 void ToolboxFFT::onClearCurves()
 {
   _plot_widget_A->removeAllCurves();
@@ -173,6 +302,9 @@ void ToolboxFFT::onClearCurves()
   _plot_widget_B->removeAllCurves();
   _plot_widget_B->resetZoom();
 
+  _spectrograms.clear();
+  ui->comboSpectrogramCurve->clear();
+
   ui->pushButtonSave->setEnabled(false);
   ui->pushButtonCalculate->setEnabled(false);
 
@@ -228,9 +360,8 @@ void ToolboxFFT::onDropEvent(QDropEvent*)
     _zoom_range.max = std::max(_zoom_range.max, curve_data.back().x);
   }
 
-  ui->pushButtonSave->setEnabled(true);
   ui->pushButtonCalculate->setEnabled(true);
-  ui->lineEditSuffix->setEnabled(true);
+  onMethodChanged(ui->comboMethod->currentIndex());
 
   _dragging_curves.clear();
   _plot_widget_A->resetZoom();
@@ -4,6 +4,10 @@
 #include <thread>
 #include "PlotJuggler/toolbox_base.h"
 #include "PlotJuggler/plotwidget_base.h"
+#include "spectral_analysis.h"
+
+class QwtPlot;
+class QwtPlotSpectrogram;
 
 namespace Ui
 {
@@ -45,6 +49,9 @@ private:
   PJ::PlotWidgetBase* _plot_widget_A = nullptr;
   PJ::PlotWidgetBase* _plot_widget_B = nullptr;
 
+  QwtPlot* _spectrogram_plot = nullptr;
+  QwtPlotSpectrogram* _spectrogram = nullptr;
+
   PJ::PlotDataMapRef* _plot_data = nullptr;
   PJ::TransformsMap* _transforms = nullptr;
 
@@ -54,6 +61,15 @@ private:
 
   std::vector<std::string> _curve_names;
 
+  std::map<std::string, SpectralAnalysis::Spectrogram> _spectrograms;
+
+  enum Method
+  {
+    SINGLE_FFT = 0,
+    WELCH,
+    SPECTROGRAM
+  };
+
 private slots:
 
   void onDragEnterEvent(QDragEnterEvent* event);
@@ -62,4 +78,6 @@ private slots:
   void onSaveCurve();
   void calculateCurveFFT();
   void onClearCurves();
+  void onMethodChanged(int method);
+  void onSpectrogramCurveChanged(const QString& curve_name);
 };
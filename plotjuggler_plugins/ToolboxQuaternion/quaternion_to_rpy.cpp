@@ -1,6 +1,30 @@
 #include "quaternion_to_rpy.h"
+#include <algorithm>
 #include <array>
 #include <math.h>
+#include "PlotJuggler/series_join.h"
+
+namespace
+{
+// number of quaternions converted together by convertBlock()
+const size_t BLOCK_SIZE = 64;
+
+struct QuaternionBlock
+{
+  std::array<double, BLOCK_SIZE> t;
+  std::array<double, BLOCK_SIZE> x;
+  std::array<double, BLOCK_SIZE> y;
+  std::array<double, BLOCK_SIZE> z;
+  std::array<double, BLOCK_SIZE> w;
+  size_t size = 0;
+};
+
+bool TimeLess(double t, const PJ::PlotData::Point& p)
+{
+  return t < p.x;
+}
+
+}  // namespace
 
 QuaternionToRollPitchYaw::QuaternionToRollPitchYaw()
 {
@@ -33,87 +57,157 @@ void QuaternionToRollPitchYaw::calculate()
   data_pitch.setMaximumRangeX(data_x.maximumRangeX());
   data_yaw.setMaximumRangeX(data_x.maximumRangeX());
 
-  data_roll.clear();
-  data_pitch.clear();
-  data_yaw.clear();
+  if (data_x.size() == 0 || data_y.size() == 0 || data_z.size() == 0 ||
+      data_w.size() == 0)
+  {
+    return;
+  }
+
+  if (data_roll.size() > 0)
+  {
+    _last_timestamp = std::max(_last_timestamp, data_roll.back().x);
+  }
+
+  // The timestamps of X are used for the output. Y, Z and W don't need to have
+  // the same size: the value used is the most recent one at the time of X.
+  PJ::SeriesJoin components({ &data_y, &data_z, &data_w }, PJ::JoinPolicy::PREVIOUS);
 
-  if (data_x.size() == 0 || data_x.size() != data_y.size() ||
-      data_y.size() != data_z.size() || data_z.size() != data_w.size())
+  auto first_it =
+      std::upper_bound(data_x.begin(), data_x.end(), _last_timestamp, TimeLess);
+  if (first_it == data_x.end())
   {
     return;
   }
 
-  int pos = data_x.getIndexFromX(_last_timestamp);
-  size_t index = pos < 0 ? 0 : static_cast<size_t>(pos);
+  QuaternionBlock block;
+  std::array<double, BLOCK_SIZE> roll;
+  std::array<double, BLOCK_SIZE> pitch;
+  std::array<double, BLOCK_SIZE> yaw;
+
+  auto flush = [&]() {
+    convertBlock(block.size, block.x.data(), block.y.data(), block.z.data(),
+                 block.w.data(), roll.data(), pitch.data(), yaw.data());
+
+    for (size_t i = 0; i < block.size; i++)
+    {
+      updateWrapOffsets({ roll[i], pitch[i], yaw[i] }, data_roll.size() > 0);
 
-  while (index < data_x.size())
+      const double timestamp = block.t[i];
+      data_roll.pushBack({ timestamp, _scale * (roll[i] + _roll_offset) });
+      data_pitch.pushBack({ timestamp, _scale * (pitch[i] + _pitch_offset) });
+      data_yaw.pushBack({ timestamp, _scale * (yaw[i] + _yaw_offset) });
+    }
+    block.size = 0;
+  };
+
+  for (size_t index = std::distance(data_x.begin(), first_it); index < data_x.size();
+       index++)
   {
-    auto& point_x = data_x.at(index);
-    double timestamp = point_x.x;
-    double q_x = point_x.y;
-    double q_y = data_y.at(index).y;
-    double q_z = data_z.at(index).y;
-    double q_w = data_w.at(index).y;
-
-    if (timestamp >= _last_timestamp)
+    const auto& point_x = data_x[index];
+    const double timestamp = point_x.x;
+
+    if (!components.reached(timestamp))
     {
-      std::array<double, 3> RPY;
-      calculateNextPoint(index, { q_x, q_y, q_z, q_w }, RPY);
+      // a component was not received yet. Wait for the next call
+      break;
+    }
+    _last_timestamp = timestamp;
 
-      data_roll.pushBack({ timestamp, _scale * (RPY[0] + _roll_offset) });
-      data_pitch.pushBack({ timestamp, _scale * (RPY[1] + _pitch_offset) });
-      data_yaw.pushBack({ timestamp, _scale * (RPY[2] + _yaw_offset) });
+    std::array<double, 3> values;
+    if (!components.valuesAt(timestamp, values.data()))
+    {
+      // a component starts after the current timestamp
+      continue;
+    }
+
+    block.t[block.size] = timestamp;
+    block.x[block.size] = point_x.y;
+    block.y[block.size] = values[0];
+    block.z[block.size] = values[1];
+    block.w[block.size] = values[2];
+    block.size++;
 
-      _last_timestamp = timestamp;
+    if (block.size == BLOCK_SIZE)
+    {
+      flush();
     }
-    index++;
   }
+  flush();
 }
 
 void QuaternionToRollPitchYaw::calculateNextPoint(size_t index,
                                                   const std::array<double, 4>& quat,
                                                   std::array<double, 3>& rpy)
 {
-  double q_x = quat[0];
-  double q_y = quat[1];
-  double q_z = quat[2];
-  double q_w = quat[3];
+  convertBlock(1, &quat[0], &quat[1], &quat[2], &quat[3], &rpy[0], &rpy[1], &rpy[2]);
+  updateWrapOffsets(rpy, index != 0);
+}
 
-  double quat_norm2 = (q_w * q_w) + (q_x * q_x) + (q_y * q_y) + (q_z * q_z);
-  if (std::abs(quat_norm2 - 1.0) > std::numeric_limits<double>::epsilon())
-  {
-    double mult = 1.0 / std::sqrt(quat_norm2);
-    q_x *= mult;
-    q_y *= mult;
-    q_z *= mult;
-    q_w *= mult;
-  }
-  double roll, pitch, yaw;
-  // roll (x-axis rotation)
-  double sinr_cosp = 2 * (q_w * q_x + q_y * q_z);
-  double cosr_cosp = 1 - 2 * (q_x * q_x + q_y * q_y);
-  roll = std::atan2(sinr_cosp, cosr_cosp);
-
-  // pitch (y-axis rotation)
-  double sinp = 2 * (q_w * q_y - q_z * q_x);
-  if (std::abs(sinp) >= 1)
-  {
-    pitch = std::copysign(M_PI_2, sinp);  // use 90 degrees if out of range
-  }
-  else
+void QuaternionToRollPitchYaw::convertBlock(size_t count, const double* q_x,
+                                            const double* q_y, const double* q_z,
+                                            const double* q_w, double* roll,
+                                            double* pitch, double* yaw)
+{
+  std::array<double, BLOCK_SIZE> sinr_cosp;
+  std::array<double, BLOCK_SIZE> cosr_cosp;
+  std::array<double, BLOCK_SIZE> sinp;
+  std::array<double, BLOCK_SIZE> siny_cosp;
+  std::array<double, BLOCK_SIZE> cosy_cosp;
+
+  while (count > 0)
   {
-    pitch = std::asin(sinp);
+    const size_t N = std::min(count, BLOCK_SIZE);
+
+    // No branches and no function calls other than sqrt:
+    // this loop is vectorized by the compiler.
+    for (size_t i = 0; i < N; i++)
+    {
+      const double mult =
+          1.0 / std::sqrt(q_w[i] * q_w[i] + q_x[i] * q_x[i] + q_y[i] * q_y[i] +
+                          q_z[i] * q_z[i]);
+      const double x = q_x[i] * mult;
+      const double y = q_y[i] * mult;
+      const double z = q_z[i] * mult;
+      const double w = q_w[i] * mult;
+
+      sinr_cosp[i] = 2 * (w * x + y * z);
+      cosr_cosp[i] = 1 - 2 * (x * x + y * y);
+      // use 90 degrees if out of range
+      sinp[i] = std::min(1.0, std::max(-1.0, 2 * (w * y - z * x)));
+      siny_cosp[i] = 2 * (w * z + x * y);
+      cosy_cosp[i] = 1 - 2 * (y * y + z * z);
+    }
+
+    for (size_t i = 0; i < N; i++)
+    {
+      roll[i] = std::atan2(sinr_cosp[i], cosr_cosp[i]);
+      pitch[i] = std::asin(sinp[i]);
+      yaw[i] = std::atan2(siny_cosp[i], cosy_cosp[i]);
+    }
+
+    q_x += N;
+    q_y += N;
+    q_z += N;
+    q_w += N;
+    roll += N;
+    pitch += N;
+    yaw += N;
+    count -= N;
   }
-  // yaw (z-axis rotation)
-  double siny_cosp = 2 * (q_w * q_z + q_x * q_y);
-  double cosy_cosp = 1 - 2 * (q_y * q_y + q_z * q_z);
-  yaw = std::atan2(siny_cosp, cosy_cosp);
+}
+
+void QuaternionToRollPitchYaw::updateWrapOffsets(const std::array<double, 3>& rpy,
+                                                 bool check_wrap)
+{
+  const double roll = rpy[0];
+  const double pitch = rpy[1];
+  const double yaw = rpy[2];
 
   const double WRAP_ANGLE = M_PI * 2.0;
   const double WRAP_THRESHOLD = M_PI * 1.95;
 
   //--------- wrap ------
-  if (index != 0 && _wrap)
+  if (check_wrap && _wrap)
   {
     if ((roll - _prev_roll) > WRAP_THRESHOLD)
     {
@@ -146,6 +240,4 @@ void QuaternionToRollPitchYaw::calculateNextPoint(size_t index,
   _prev_pitch = pitch;
   _prev_roll = roll;
   _prev_yaw = yaw;
-
-  rpy = { roll, pitch, yaw };
 }
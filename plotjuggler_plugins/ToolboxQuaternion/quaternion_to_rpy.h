@@ -1,6 +1,7 @@
 #ifndef QUATERNION_TO_RPY_H
 #define QUATERNION_TO_RPY_H
 
+#include <array>
 #include "PlotJuggler/transform_function.h"
 
 class QuaternionToRollPitchYaw : public PJ::TransformFunction
@@ -40,7 +41,15 @@ public:
   void calculateNextPoint(size_t index, const std::array<double, 4>& quat,
                           std::array<double, 3>& rpy);
 
+  /// Convert a block of quaternions (structure of arrays) to roll, pitch and yaw.
+  /// The result is not wrapped.
+  static void convertBlock(size_t count, const double* q_x, const double* q_y,
+                           const double* q_z, const double* q_w, double* roll,
+                           double* pitch, double* yaw);
+
 private:
+  void updateWrapOffsets(const std::array<double, 3>& rpy, bool check_wrap);
+
   double _prev_roll = 0;
   double _prev_yaw = 0;
   double _prev_pitch = 0;